@@ -0,0 +1,84 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef BATCHED_MATRIX_H
+#define BATCHED_MATRIX_H
+
+#include <limits>
+#include <stdexcept>
+#include "Matrix.h"
+
+// A batch of equally-sized matrices in CPU and GPU memory.
+// The matrices are stored one after another, each in column major
+// order, so the batch is also one Matrix of nRows x (nCols * nBatch)
+// whose columns [b*nCols, (b+1)*nCols) are matrix b.  That is the
+// layout strided batched BLAS routines expect, with a stride of
+// ld * nCols elements.  For batched BLAS routines that take an
+// array of pointers to the matrices, we also keep such an array
+// in GPU memory.
+template<typename T>
+class BatchedMatrix : public Matrix<T>
+{
+protected:
+    int nMatrixCols;
+    int nBatch;
+
+    // Device addresses of each matrix, in host and device memory.
+    Matrix<T*> pointers;
+
+    static int CheckedNumCols(int nCols, int nBatch)
+    {
+        if(static_cast<long long>(nCols) * nBatch > std::numeric_limits<int>::max())
+        {
+            throw std::length_error("batch has too many columns in total for an int");
+        }
+        return nCols * nBatch;
+    }
+
+public:
+    BatchedMatrix(int _nRows, int _nCols, int _nBatch, const MatrixLayout& layout = MatrixLayout())
+      : Matrix<T>(_nRows, CheckedNumCols(_nCols, _nBatch), layout),
+        nMatrixCols(_nCols),
+        nBatch(_nBatch),
+        pointers(_nBatch, 1)
+    {
+        for(auto b = 0; b < nBatch; ++b)
+        {
+            pointers.El(b, 0) = this->GetDeviceData() + b * GetStride();
+        }
+        pointers.CopyHostToDevice();
+    }
+
+    int GetNumMatrixCols(void) const  { return nMatrixCols; }
+    int GetBatchCount(void) const     { return nBatch; }
+
+    // Distance between consecutive matrices, in elements.
+    size_t GetStride(void) const
+    {
+        return static_cast<size_t>(this->GetLeadingDim()) * nMatrixCols;
+    }
+
+    // Array of the matrices' device addresses, in device memory.
+    T* const* GetDevicePointers(void) const { return pointers.GetDeviceData(); }
+
+    // Access element (r, c) of the batch as one wide matrix.
+    using Matrix<T>::El;
+
+    // Access element (r, c) of matrix b from host storage.
+    T& El(int b, int r, int c)
+    {
+        return Matrix<T>::El(r, b * nMatrixCols + c);
+    }
+
+    const T& El(int b, int r, int c) const
+    {
+        return Matrix<T>::El(r, b * nMatrixCols + c);
+    }
+
+    // Host address of matrix b.
+    T* GetHostMatrix(int b) const   { return this->GetHostData() + b * GetStride(); }
+
+    // Device address of matrix b.
+    T* GetDeviceMatrix(int b) const { return this->GetDeviceData() + b * GetStride(); }
+};
+
+#endif // BATCHED_MATRIX_H
@@ -0,0 +1,58 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include <vector>
+#include "HipStream.h"
+#include "HipEvent.h"
+
+// How to run an operation repeatedly for timing.
+struct BenchmarkOptions
+{
+    // Whether to time the operation at all.
+    bool enabled = false;
+
+    // Untimed runs to absorb one-time costs like JIT compilation.
+    int nWarmup = 5;
+
+    // Timed runs.
+    int nIters = 20;
+};
+
+// Run the given operation (which must enqueue its work on the
+// given stream) repeatedly and return the device time in
+// milliseconds for each timed run.
+// Events are recorded back to back around each run, so the
+// host does not synchronize with the device inside the timed loop.
+template<typename Func>
+std::vector<double>
+TimeOnStream(const HipStream& stream,
+                const BenchmarkOptions& opts,
+                Func op)
+{
+    for(auto i = 0; i < opts.nWarmup; ++i)
+    {
+        op();
+    }
+    stream.Synchronize();
+
+    std::vector<HipEvent> events(opts.nIters + 1);
+    events[0].Record(stream);
+    for(auto i = 0; i < opts.nIters; ++i)
+    {
+        op();
+        events[i+1].Record(stream);
+    }
+    events.back().Synchronize();
+
+    std::vector<double> samples;
+    samples.reserve(opts.nIters);
+    for(auto i = 0; i < opts.nIters; ++i)
+    {
+        samples.push_back(events[i+1].ElapsedSince(events[i]));
+    }
+    return samples;
+}
+
+#endif // TEST_BENCHMARK_H
@@ -0,0 +1,201 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef BLOCKED_GEMM_H
+#define BLOCKED_GEMM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// A blocked host GEMM:
+//   C = alpha * op(A) * op(B) + beta * C
+// with column major storage, op(A) m x k, op(B) k x n, and C m x n.
+// Elements are converted to ComputeType as they are loaded, so this
+// works for any InType/OutType combination the GemmEx testers use.
+// It does not depend on HIP.
+//
+// The computation is divided into tiles of C that can be computed
+// independently, so callers can hand them out to host threads however
+// they like.  For each tile, blocks of op(A) and op(B) are packed into
+// contiguous buffers, and the inner loop is a unit-stride multiply-add
+// over a column of the packed A block that the compiler can vectorize.
+template<typename InType, typename OutType, typename ComputeType = float>
+class BlockedGemm
+{
+public:
+    // Block sizes: a packed A block is mBlock x kBlock,
+    // a packed B block is kBlock x nBlock, and the accumulators
+    // for a tile of C are mBlock x nBlock.
+    static constexpr int mBlock = 256;
+    static constexpr int nBlock = 64;
+    static constexpr int kBlock = 128;
+
+    // Scratch space for computing tiles, one per thread.
+    struct Workspace
+    {
+        std::vector<ComputeType> packedA;
+        std::vector<ComputeType> packedB;
+        std::vector<ComputeType> acc;
+
+        Workspace(void)
+          : packedA(static_cast<size_t>(mBlock) * kBlock),
+            packedB(static_cast<size_t>(kBlock) * nBlock),
+            acc(static_cast<size_t>(mBlock) * nBlock)
+        { }
+    };
+
+private:
+    bool transA;
+    bool transB;
+    int m;
+    int n;
+    int k;
+    ComputeType alpha;
+    const InType* A;
+    size_t lda;
+    const InType* B;
+    size_t ldb;
+    ComputeType beta;
+    OutType* C;
+    size_t ldc;
+
+    int nRowTiles;
+    int nColTiles;
+
+public:
+    BlockedGemm(bool _transA,
+                bool _transB,
+                int _m,
+                int _n,
+                int _k,
+                ComputeType _alpha,
+                const InType* _A,
+                size_t _lda,
+                const InType* _B,
+                size_t _ldb,
+                ComputeType _beta,
+                OutType* _C,
+                size_t _ldc)
+      : transA(_transA),
+        transB(_transB),
+        m(_m),
+        n(_n),
+        k(_k),
+        alpha(_alpha),
+        A(_A),
+        lda(_lda),
+        B(_B),
+        ldb(_ldb),
+        beta(_beta),
+        C(_C),
+        ldc(_ldc),
+        nRowTiles((m > 0) ? (m + mBlock - 1) / mBlock : 0),
+        nColTiles((n > 0) ? (n + nBlock - 1) / nBlock : 0)
+    { }
+
+    int GetNumTiles(void) const     { return nRowTiles * nColTiles; }
+
+    // Compute one tile of C, in [0, GetNumTiles()).
+    void ComputeTile(int tile, Workspace& ws) const
+    {
+        auto& packedA = ws.packedA;
+        auto& packedB = ws.packedB;
+        auto& acc = ws.acc;
+
+        auto i0 = (tile % nRowTiles) * mBlock;
+        auto j0 = (tile / nRowTiles) * nBlock;
+        auto mb = std::min(mBlock, m - i0);
+        auto nb = std::min(nBlock, n - j0);
+
+        std::fill(acc.begin(), acc.end(), ComputeType(0));
+
+        for(auto p0 = 0; p0 < k; p0 += kBlock)
+        {
+            auto kb = std::min(kBlock, k - p0);
+
+            // Pack op(A)[i0:i0+mb, p0:p0+kb], column major with leading
+            // dim mBlock.  Rows past mb are zero, so the inner loops below
+            // always run over exactly mBlock rows.
+            for(auto p = 0; p < kb; ++p)
+            {
+                auto dst = &packedA[static_cast<size_t>(p) * mBlock];
+                for(auto i = 0; i < mb; ++i)
+                {
+                    dst[i] = static_cast<ComputeType>(transA
+                        ? A[static_cast<size_t>(i0 + i) * lda + (p0 + p)]
+                        : A[static_cast<size_t>(p0 + p) * lda + (i0 + i)]);
+                }
+                std::fill(dst + mb, dst + mBlock, ComputeType(0));
+            }
+
+            // Pack op(B)[p0:p0+kb, j0:j0+nb], column major with leading dim kBlock.
+            for(auto j = 0; j < nb; ++j)
+            {
+                auto dst = &packedB[static_cast<size_t>(j) * kBlock];
+                for(auto p = 0; p < kb; ++p)
+                {
+                    dst[p] = static_cast<ComputeType>(transB
+                        ? B[static_cast<size_t>(p0 + p) * ldb + (j0 + j)]
+                        : B[static_cast<size_t>(j0 + j) * ldb + (p0 + p)]);
+                }
+            }
+
+            // Accumulate, four columns of C at a time so each
+            // packed A column is loaded once per four updates.
+            auto j = 0;
+            for( ; j + 4 <= nb; j += 4)
+            {
+                ComputeType* __restrict__ c0 = &acc[static_cast<size_t>(j) * mBlock];
+                ComputeType* __restrict__ c1 = c0 + mBlock;
+                ComputeType* __restrict__ c2 = c1 + mBlock;
+                ComputeType* __restrict__ c3 = c2 + mBlock;
+                for(auto p = 0; p < kb; ++p)
+                {
+                    const ComputeType* __restrict__ a = &packedA[static_cast<size_t>(p) * mBlock];
+                    auto b0 = packedB[static_cast<size_t>(j) * kBlock + p];
+                    auto b1 = packedB[static_cast<size_t>(j + 1) * kBlock + p];
+                    auto b2 = packedB[static_cast<size_t>(j + 2) * kBlock + p];
+                    auto b3 = packedB[static_cast<size_t>(j + 3) * kBlock + p];
+                    for(auto i = 0; i < mBlock; ++i)
+                    {
+                        c0[i] += a[i] * b0;
+                        c1[i] += a[i] * b1;
+                        c2[i] += a[i] * b2;
+                        c3[i] += a[i] * b3;
+                    }
+                }
+            }
+            for( ; j < nb; ++j)
+            {
+                ComputeType* __restrict__ c0 = &acc[static_cast<size_t>(j) * mBlock];
+                for(auto p = 0; p < kb; ++p)
+                {
+                    const ComputeType* __restrict__ a = &packedA[static_cast<size_t>(p) * mBlock];
+                    auto b0 = packedB[static_cast<size_t>(j) * kBlock + p];
+                    for(auto i = 0; i < mBlock; ++i)
+                    {
+                        c0[i] += a[i] * b0;
+                    }
+                }
+            }
+        }
+
+        // Scale and combine with C.  As in BLAS, C is not read if beta is zero.
+        for(auto j = 0; j < nb; ++j)
+        {
+            auto a = &acc[static_cast<size_t>(j) * mBlock];
+            auto c = &C[static_cast<size_t>(j0 + j) * ldc + i0];
+            for(auto i = 0; i < mb; ++i)
+            {
+                auto val = alpha * a[i];
+                if(beta != ComputeType(0))
+                {
+                    val += beta * static_cast<ComputeType>(c[i]);
+                }
+                c[i] = static_cast<OutType>(val);
+            }
+        }
+    }
+};
+
+#endif // BLOCKED_GEMM_H
@@ -0,0 +1,56 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_HIPEVENT_H
+#define TEST_HIPEVENT_H
+
+#include "hip/hip_runtime_api.h"
+#include "HipstarException.h"
+#include "HipStream.h"
+
+class HipEvent
+{
+private:
+    hipEvent_t handle;
+
+public:
+    HipEvent(void)
+    {
+        CHECK(hipEventCreate(&handle));
+    }
+
+    // Events are tied to the work they record, so don't copy them.
+    HipEvent(const HipEvent&) = delete;
+    HipEvent& operator=(const HipEvent&) = delete;
+
+    ~HipEvent(void)
+    {
+        CHECK(hipEventDestroy(handle));
+    }
+
+    hipEvent_t GetHandle(void) const   { return handle; }
+
+    void Record(const HipStream& stream)
+    {
+        CHECK(hipEventRecord(handle, stream.GetHandle()));
+    }
+
+    void Synchronize(void) const  { CHECK(hipEventSynchronize(handle)); }
+
+    // Have work enqueued on the given stream from now on wait
+    // for the work this event recorded, without blocking the host.
+    void MakeStreamWait(const HipStream& stream) const
+    {
+        CHECK(hipStreamWaitEvent(stream.GetHandle(), handle, 0));
+    }
+
+    // Time in milliseconds between the given (earlier) event and this one.
+    // Both events must have completed.
+    float ElapsedSince(const HipEvent& start) const
+    {
+        float ms = 0;
+        CHECK(hipEventElapsedTime(&ms, start.handle, handle));
+        return ms;
+    }
+};
+
+#endif // TEST_HIPEVENT_H
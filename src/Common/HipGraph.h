@@ -0,0 +1,97 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_HIPGRAPH_H
+#define TEST_HIPGRAPH_H
+
+#include <exception>
+#include <memory>
+#include <string>
+#include "hip/hip_runtime_api.h"
+#include "HipstarException.h"
+#include "HipStream.h"
+
+// An executable HIP graph, captured from the work some code
+// enqueues on a stream, that can be replayed with one launch
+// instead of one submission per operation.
+class HipGraph
+{
+private:
+    hipGraph_t graph;
+    hipGraphExec_t exec;
+
+    HipGraph(hipGraph_t _graph, hipGraphExec_t _exec)
+      : graph(_graph),
+        exec(_exec)
+    { }
+
+public:
+    // Graphs are launched by reference, never duplicated.
+    HipGraph(const HipGraph&) = delete;
+    HipGraph& operator=(const HipGraph&) = delete;
+
+    ~HipGraph(void)
+    {
+        CHECK(hipGraphExecDestroy(exec));
+        CHECK(hipGraphDestroy(graph));
+    }
+
+    // Capture the work that enqueue() puts on the stream (without
+    // running it) and instantiate it.  Not every runtime supports
+    // capture, and libraries may do things during capture that
+    // invalidate it, so rather than throwing we return null and
+    // say why in whyNot, leaving the stream usable as before.
+    template<typename Func>
+    static std::unique_ptr<HipGraph> TryCapture(const HipStream& stream,
+                                                Func enqueue,
+                                                std::string& whyNot)
+    {
+        auto code = hipStreamBeginCapture(stream.GetHandle(), hipStreamCaptureModeRelaxed);
+        if(code != hipSuccess)
+        {
+            whyNot = std::string("cannot begin capture: ") + hipGetErrorString(code);
+            return nullptr;
+        }
+
+        try
+        {
+            enqueue();
+        }
+        catch(const std::exception& e)
+        {
+            whyNot = std::string("enqueue failed during capture: ") + e.what();
+        }
+
+        hipGraph_t graph = nullptr;
+        code = hipStreamEndCapture(stream.GetHandle(), &graph);
+        if( (code != hipSuccess) or not whyNot.empty() )
+        {
+            if(whyNot.empty())
+            {
+                whyNot = std::string("cannot end capture: ") + hipGetErrorString(code);
+            }
+            if(graph != nullptr)
+            {
+                hipGraphDestroy(graph);
+            }
+            return nullptr;
+        }
+
+        hipGraphExec_t exec = nullptr;
+        code = hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0);
+        if(code != hipSuccess)
+        {
+            whyNot = std::string("cannot instantiate graph: ") + hipGetErrorString(code);
+            hipGraphDestroy(graph);
+            return nullptr;
+        }
+        return std::unique_ptr<HipGraph>(new HipGraph(graph, exec));
+    }
+
+    // Enqueue a replay of the captured work on the given stream.
+    void Launch(const HipStream& stream)
+    {
+        CHECK(hipGraphLaunch(exec, stream.GetHandle()));
+    }
+};
+
+#endif // TEST_HIPGRAPH_H
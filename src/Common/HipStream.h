@@ -5,6 +5,7 @@
 
 #include "hip/hip_runtime_api.h"
 #include "HipstarException.h"
+#include "Trace.h"
 
 class HipStream
 {
@@ -14,6 +15,7 @@ private:
 public:
     HipStream(void)
     {
+        TraceSpan span("hipStreamCreate", "setup");
         hipStreamCreate(&handle);        
     }
 
@@ -24,7 +26,11 @@ public:
 
     hipStream_t GetHandle(void) const   { return handle; }
 
-    void Synchronize(void) const  { CHECK(hipStreamSynchronize(handle)); }
+    void Synchronize(void) const
+    {
+        TraceSpan span("hipStreamSynchronize", "sync");
+        CHECK(hipStreamSynchronize(handle));
+    }
 };
 
 #endif // TEST_HIPSTREAM_H
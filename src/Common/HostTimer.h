@@ -0,0 +1,31 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_HOST_TIMER_H
+#define TEST_HOST_TIMER_H
+
+#include <chrono>
+
+// Wall clock timer for host-side operations (e.g., creating
+// library handles) that can't be timed with HIP events.
+class HostTimer
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start;
+
+public:
+    HostTimer(void)
+      : start(Clock::now())
+    { }
+
+    void Restart(void)  { start = Clock::now(); }
+
+    // Milliseconds since construction or the last Restart.
+    double ElapsedMs(void) const
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+};
+
+#endif // TEST_HOST_TIMER_H
@@ -3,9 +3,14 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
-#include <cstring>  // for memset
 #include "hip/hip_runtime.h"
 
 #include "src/Common/ExtTestConfig.h"
@@ -14,101 +19,434 @@
 #endif // defined(TEST_HALF_PRECISION)
 
 #include "HipstarException.h"
+#include "MemoryPool.h"
+#include "Trace.h"
+#include "Transfer.h"
+
+// How a Matrix's elements are laid out in memory.
+// By default, columns are packed (the leading dimension is
+// the number of rows) and the storage has whatever alignment
+// the allocator gives.  Padding the leading dimension avoids
+// the cache and memory bank conflicts that power-of-two
+// leading dimensions can cause.
+struct MatrixLayout
+{
+    // Number of unused elements added to the end of each column.
+    int pad = 0;
+
+    // Round the leading dimension up to a multiple of this many elements.
+    int ldMultiple = 1;
+
+    // Alignment of the first element, in bytes (a power of two),
+    // or zero to use the allocator's alignment.
+    size_t baseAlignment = 0;
+
+    int GetLeadingDim(int nRows) const
+    {
+        auto ld = static_cast<long long>(nRows) + pad;
+        ld = ((ld + ldMultiple - 1) / ldMultiple) * ldMultiple;
+        if(ld > std::numeric_limits<int>::max())
+        {
+            throw std::length_error("padded leading dimension is too large for an int");
+        }
+        return static_cast<int>(ld);
+    }
+};
+
+// Where a Matrix's storage lives.
+enum class MatrixStorage
+{
+    // Pinned host memory, and separate device memory,
+    // with explicit copies between them.
+    Pinned,
+
+    // Ordinary (pageable) host memory, as applications often
+    // use, and separate device memory.  The runtime stages
+    // copies through pinned buffers of its own.
+    Pageable,
+
+    // One managed allocation used from both host and device.
+    // Copies become prefetches, and the runtime migrates pages
+    // on demand, so host and device must not use it at once.
+    Managed,
+
+    // Device memory only, for data produced and consumed on the
+    // device.  Using host storage or copies is an error.
+    DeviceOnly
+};
+
+inline
+const char*
+GetStorageName(MatrixStorage storage)
+{
+    switch(storage)
+    {
+    case MatrixStorage::Pinned:     return "pinned";
+    case MatrixStorage::Pageable:   return "pageable";
+    case MatrixStorage::Managed:    return "managed";
+    default:                        return "device";
+    }
+}
+
+// Parse a comma-separated list of storage names, like "pinned,managed".
+inline
+std::vector<MatrixStorage>
+ParseStorageList(const std::string& str)
+{
+    std::vector<MatrixStorage> ret;
+    std::istringstream iss(str);
+    std::string name;
+    while(std::getline(iss, name, ','))
+    {
+        if(name == "pinned")
+        {
+            ret.push_back(MatrixStorage::Pinned);
+        }
+        else if(name == "pageable")
+        {
+            ret.push_back(MatrixStorage::Pageable);
+        }
+        else if(name == "managed")
+        {
+            ret.push_back(MatrixStorage::Managed);
+        }
+        else if(name == "device")
+        {
+            ret.push_back(MatrixStorage::DeviceOnly);
+        }
+        else
+        {
+            throw std::invalid_argument("bad storage '" + name + "' (expected pinned, pageable, managed, or device)");
+        }
+    }
+    if(ret.empty())
+    {
+        throw std::invalid_argument("empty storage list");
+    }
+    return ret;
+}
 
 // A Matrix in CPU and GPU memory.
 // The matrix elements are stored in column major order
 // to be easier to pass to traditional BLAS library
 // implementations that were originally designed for
-// Fortran applications.
+// Fortran applications.  Host and device storage have the
+// same layout, with consecutive columns ld elements apart.
+// Each side's storage is allocated (and zeroed) when first used,
+// so a matrix used only on the device, or not at all, costs
+// no host memory.  Use one side's storage from one thread
+// at a time until it has been allocated.
+// Storage is pinned host and device memory unless another
+// MatrixStorage is given.
 template<typename T>
 class Matrix
 {
 protected:
     int nRows;
     int nCols;
+    int ld;
+    size_t baseAlignment;
+    MatrixStorage storage;
+
+    // Storage as allocated, and the (possibly more aligned)
+    // address of the first element within it.
+    mutable void* hostAlloc;
+    mutable void* devAlloc;
+    mutable T* hostData;
+    mutable T* devData;
+
+    static T* AlignUp(void* p, size_t alignment)
+    {
+        auto addr = reinterpret_cast<uintptr_t>(p);
+        if(alignment > 0)
+        {
+            addr = (addr + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        }
+        return reinterpret_cast<T*>(addr);
+    }
+
+    // Storage comes from the caching pools, since pinned
+    // allocation is slow and programs that sweep over
+    // problem shapes create and destroy many matrices.
+    // We over-allocate by the alignment so that we can
+    // align the first element ourselves.
+    void AllocateHost(void) const
+    {
+        if(storage == MatrixStorage::Managed)
+        {
+            AllocateManaged();
+            return;
+        }
+        if(storage == MatrixStorage::DeviceOnly)
+        {
+            throw std::logic_error("a device-only matrix has no host storage");
+        }
+
+        TraceSpan span("Matrix allocate host", "memory");
+        hostAlloc = (storage == MatrixStorage::Pageable)
+            ? PageableHostPool().Allocate(GetSize() + baseAlignment)
+            : PinnedHostPool().Allocate(GetSize() + baseAlignment);
+        hostData = AlignUp(hostAlloc, baseAlignment);
+        std::fill_n(hostData, GetNumStoredItems(), T());
+    }
+
+    void AllocateDevice(void) const
+    {
+        if(storage == MatrixStorage::Managed)
+        {
+            AllocateManaged();
+            return;
+        }
+
+        TraceSpan span("Matrix allocate device", "memory");
+        devAlloc = DevicePool().Allocate(GetSize() + baseAlignment);
+        devData = AlignUp(devAlloc, baseAlignment);
+        CHECK(hipMemset(devData, 0, GetSize()));
+    }
+
+    // Managed storage is one allocation for both sides, zeroed
+    // on the host, so its pages start out there.
+    void AllocateManaged(void) const
+    {
+        TraceSpan span("Matrix allocate managed", "memory");
+        hostAlloc = ManagedPool().Allocate(GetSize() + baseAlignment);
+        hostData = AlignUp(hostAlloc, baseAlignment);
+        devData = hostData;
+        std::fill_n(hostData, GetNumStoredItems(), T());
+    }
 
-    T* hostData;
-    T* devData;
+    // Ask the runtime to migrate managed storage to the given
+    // device (or hipCpuDeviceId, for the host) in stream order.
+    void PrefetchAsync(int deviceId, hipStream_t stream) const
+    {
+        CHECK(hipMemPrefetchAsync(GetDeviceData(), GetSize(), deviceId, stream));
+    }
+
+    void PrefetchToDeviceAsync(hipStream_t stream) const
+    {
+        int deviceId = 0;
+        CHECK(hipGetDevice(&deviceId));
+        PrefetchAsync(deviceId, stream);
+    }
 
 public:
-    Matrix(int _nRows, int _nCols)
+    Matrix(int _nRows,
+            int _nCols,
+            const MatrixLayout& layout = MatrixLayout(),
+            MatrixStorage _storage = MatrixStorage::Pinned)
       : nRows(_nRows),
         nCols(_nCols),
+        ld(layout.GetLeadingDim(_nRows)),
+        baseAlignment(layout.baseAlignment),
+        storage(_storage),
+        hostAlloc(nullptr),
+        devAlloc(nullptr),
         hostData(nullptr),
         devData(nullptr)
     {
-        CHECK(hipHostMalloc(&hostData, GetSize()));
-        memset(hostData, 0, GetSize());
-
-        CHECK(hipMalloc(&devData, GetSize()));
-        CHECK(hipMemset(devData, 0, GetSize()));
+        if( (baseAlignment & (baseAlignment - 1)) != 0 )
+        {
+            throw std::invalid_argument("matrix base alignment must be a power of two");
+        }
     }
 
+    // Storage is owned, never shared.
+    Matrix(const Matrix&) = delete;
+    Matrix& operator=(const Matrix&) = delete;
+
     ~Matrix(void)
     {
-        if(hostData != nullptr)
+        if(storage == MatrixStorage::Managed)
         {
-            CHECK(hipHostFree(hostData));
-            hostData = nullptr;
+            ManagedPool().Free(hostAlloc);
+            return;
         }
-        if(devData != nullptr)
+        ReleaseHostStorage();
+        if(devAlloc != nullptr)
         {
-            CHECK(hipFree(devData));
+            DevicePool().Free(devAlloc);
+            devAlloc = nullptr;
             devData = nullptr;
         }
     }
 
     int GetNumRows(void) const   { return nRows; }
     int GetNumCols(void) const   { return nCols; }
-    int GetNumItems(void) const  { return nRows * nCols; }
-    int GetSize(void) const    { return GetNumItems() * sizeof(T); }
 
-    T* GetDeviceData(void) const  { return devData; }
-    T* GetHostData(void) const { return hostData; }
+    MatrixStorage GetStorage(void) const    { return storage; }
+
+    // Distance between consecutive columns, in elements.
+    int GetLeadingDim(void) const   { return ld; }
+    bool IsPadded(void) const   { return ld != nRows; }
+
+    // Sizes are 64-bit, since matrices may exceed 2 GiB
+    // even though each dimension fits in an int.
+    // Items are the nRows x nCols logical elements; stored items
+    // and size also cover the padding at the end of each column.
+    size_t GetNumItems(void) const  { return static_cast<size_t>(nRows) * nCols; }
+    size_t GetNumStoredItems(void) const  { return static_cast<size_t>(ld) * nCols; }
+    size_t GetSize(void) const    { return GetNumStoredItems() * sizeof(T); }
+
+    // The storage on each side, allocating it if need be.
+    T* GetDeviceData(void) const
+    {
+        if(devData == nullptr)
+        {
+            AllocateDevice();
+        }
+        return devData;
+    }
+
+    T* GetHostData(void) const
+    {
+        if(hostData == nullptr)
+        {
+            AllocateHost();
+        }
+        return hostData;
+    }
+
+    bool HasHostStorage(void) const     { return hostData != nullptr; }
+    bool HasDeviceStorage(void) const   { return devData != nullptr; }
+
+    // Give back the host storage, e.g., once inputs are on the device.
+    // It is allocated (zeroed) again if used again.
+    // Managed storage is shared with the device, so is kept.
+    void ReleaseHostStorage(void)
+    {
+        if( (hostAlloc != nullptr) and (storage != MatrixStorage::Managed) )
+        {
+            if(storage == MatrixStorage::Pageable)
+            {
+                PageableHostPool().Free(hostAlloc);
+            }
+            else
+            {
+                PinnedHostPool().Free(hostAlloc);
+            }
+            hostAlloc = nullptr;
+            hostData = nullptr;
+        }
+    }
 
     // Access element from host storage.
     T& El(int r, int c)
     {
-        return hostData[c*nRows + r];
+        return GetHostData()[static_cast<size_t>(c)*ld + r];
     }
 
     const T& El(int r, int c) const
     {
-        return hostData[c*nRows + r];
+        return GetHostData()[static_cast<size_t>(c)*ld + r];
     }
 
+    // Transfers are split into chunks of at most TransferChunkBytes().
+    // Padded matrices are copied with 2D copies that skip the padding.
+    // For managed storage, the whole allocation is prefetched instead.
     void CopyHostToDevice(void)
     {
-        CHECK(hipMemcpy(devData,
-                        hostData,
-                        GetSize(),
-                        hipMemcpyHostToDevice));
+        TraceSpan span("Matrix copy H2D", "copy");
+        if(storage == MatrixStorage::Managed)
+        {
+            PrefetchToDeviceAsync(nullptr);
+            CHECK(hipStreamSynchronize(nullptr));
+            return;
+        }
+        if(IsPadded())
+        {
+            ChunkedCopy2D(GetDeviceData(), ld * sizeof(T),
+                            GetHostData(), ld * sizeof(T),
+                            nRows * sizeof(T), nCols,
+                            hipMemcpyHostToDevice);
+            return;
+        }
+        ChunkedCopy(GetDeviceData(),
+                    GetHostData(),
+                    GetSize(),
+                    hipMemcpyHostToDevice);
     }
 
     void CopyHostToDeviceAsync(const HipStream& stream)
     {
-        CHECK(hipMemcpyAsync(devData,
-                            hostData,
+        CopyHostToDeviceAsync(std::vector<const HipStream*>{ &stream });
+    }
+
+    // Spread the chunks of the transfer over the given streams.
+    // When tracing, the device span covers the chunks on the first stream.
+    void CopyHostToDeviceAsync(const std::vector<const HipStream*>& streams)
+    {
+        DeviceTraceSpan span("copy H2D", streams[0]->GetHandle());
+        if(storage == MatrixStorage::Managed)
+        {
+            PrefetchToDeviceAsync(streams[0]->GetHandle());
+            return;
+        }
+        if(IsPadded())
+        {
+            ChunkedCopy2DAsync(GetDeviceData(), ld * sizeof(T),
+                                GetHostData(), ld * sizeof(T),
+                                nRows * sizeof(T), nCols,
+                                hipMemcpyHostToDevice,
+                                streams);
+            return;
+        }
+        ChunkedCopyAsync(GetDeviceData(),
+                            GetHostData(),
                             GetSize(),
                             hipMemcpyHostToDevice,
-                            stream.GetHandle()));
+                            streams);
     }
 
     void CopyDeviceToHost(void)
     {
-        CHECK(hipMemcpy(hostData,
-                        devData,
-                        GetSize(),
-                        hipMemcpyDeviceToHost));
+        TraceSpan span("Matrix copy D2H", "copy");
+        if(storage == MatrixStorage::Managed)
+        {
+            PrefetchAsync(hipCpuDeviceId, nullptr);
+            CHECK(hipStreamSynchronize(nullptr));
+            return;
+        }
+        if(IsPadded())
+        {
+            ChunkedCopy2D(GetHostData(), ld * sizeof(T),
+                            GetDeviceData(), ld * sizeof(T),
+                            nRows * sizeof(T), nCols,
+                            hipMemcpyDeviceToHost);
+            return;
+        }
+        ChunkedCopy(GetHostData(),
+                    GetDeviceData(),
+                    GetSize(),
+                    hipMemcpyDeviceToHost);
     }
 
     void CopyDeviceToHostAsync(const HipStream& stream)
     {
-        CHECK(hipMemcpyAsync(hostData,
-                            devData,
+        CopyDeviceToHostAsync(std::vector<const HipStream*>{ &stream });
+    }
+
+    void CopyDeviceToHostAsync(const std::vector<const HipStream*>& streams)
+    {
+        DeviceTraceSpan span("copy D2H", streams[0]->GetHandle());
+        if(storage == MatrixStorage::Managed)
+        {
+            PrefetchAsync(hipCpuDeviceId, streams[0]->GetHandle());
+            return;
+        }
+        if(IsPadded())
+        {
+            ChunkedCopy2DAsync(GetHostData(), ld * sizeof(T),
+                                GetDeviceData(), ld * sizeof(T),
+                                nRows * sizeof(T), nCols,
+                                hipMemcpyDeviceToHost,
+                                streams);
+            return;
+        }
+        ChunkedCopyAsync(GetHostData(),
+                            GetDeviceData(),
                             GetSize(),
                             hipMemcpyDeviceToHost,
-                            stream.GetHandle()));
+                            streams);
     }
 };
 
@@ -135,16 +473,24 @@ template<typename T>
 std::ostream&
 operator<<(std::ostream& os, const Matrix<T>& m)
 {
-    std::vector<T> hdata(m.GetNumItems());
+    if(not m.HasDeviceStorage())
+    {
+        return os << "dims: " << m.GetNumRows() << 'x' << m.GetNumCols() << ", not allocated";
+    }
+    std::vector<T> hdata(m.GetNumStoredItems());
     auto matrixSize = m.GetSize();
     CHECK(hipMemcpy(hdata.data(), m.GetDeviceData(), matrixSize, hipMemcpyDeviceToHost));
     os << "dims: " << m.GetNumRows() << 'x' << m.GetNumCols()
+        << ", ld: " << m.GetLeadingDim()
         << ", nItems: " << m.GetNumItems()
         << ", size: " << matrixSize
         << ", vals: ";
-    for(auto i = 0; i < m.GetNumItems(); ++i)
+    for(auto c = 0; c < m.GetNumCols(); ++c)
     {
-        os << ToFloat(hdata[i]) << ' ';
+        for(auto r = 0; r < m.GetNumRows(); ++r)
+        {
+            os << ToFloat(hdata[static_cast<size_t>(c) * m.GetLeadingDim() + r]) << ' ';
+        }
     }
     return os;
 }
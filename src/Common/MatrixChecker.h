@@ -0,0 +1,311 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_MATRIX_CHECKER_H
+#define TEST_MATRIX_CHECKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "HipstarException.h"
+#include "Matrix.h"
+#include "Trace.h"
+#include "Transfer.h"
+
+// How to compare computed matrix values against expected values.
+// A value matches if it is within any of the tolerances.
+// With all tolerances zero, values must match exactly.
+struct CheckOptions
+{
+    // Largest allowed |computed - expected|.
+    double absTol = 0;
+
+    // Largest allowed |computed - expected| / |expected|.
+    double relTol = 0;
+
+    // Largest allowed distance in units in the last place
+    // of the matrix element type.
+    uint32_t ulpTol = 0;
+
+    // Most mismatches to describe individually.
+    size_t maxReported = 10;
+
+    // Host threads to use.  Zero means one per hardware thread.
+    unsigned int nThreads = 0;
+};
+
+// One element that didn't match.
+struct Mismatch
+{
+    int row = 0;
+    int col = 0;
+    double expected = 0;
+    double computed = 0;
+};
+
+// The outcome of checking a matrix.
+struct CheckResult
+{
+    size_t nChecked = 0;
+    size_t nMismatches = 0;
+
+    // The first few mismatches, in column major order.
+    std::vector<Mismatch> samples;
+
+    // The element with the largest (non-NaN) absolute error,
+    // whether or not it is a mismatch.  The location is only
+    // meaningful if the error is nonzero.
+    double maxAbsErr = 0;
+    Mismatch maxErrAt;
+
+    // Sum of absolute errors over all elements, for the mean error.
+    double sumAbsErr = 0;
+
+    double GetMeanAbsErr(void) const { return (nChecked > 0) ? (sumAbsErr / nChecked) : 0; }
+};
+
+// Distance between two values in units in the last place,
+// based on their bit patterns (works for float and half).
+template<typename T>
+uint64_t
+UlpDistance(const T& a, const T& b)
+{
+    static_assert((sizeof(T) == 2) or (sizeof(T) == 4), "UlpDistance supports 16 and 32 bit types");
+    using Bits = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+    constexpr Bits signBit = Bits(1) << (8 * sizeof(T) - 1);
+
+    // Map sign-magnitude bit patterns onto a monotonic integer line.
+    auto toOrdered = [](const T& v) {
+        Bits bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return (bits & signBit)
+            ? -static_cast<int64_t>(bits & ~signBit)
+            : static_cast<int64_t>(bits);
+    };
+    auto diff = toOrdered(a) - toOrdered(b);
+    return static_cast<uint64_t>((diff < 0) ? -diff : diff);
+}
+
+// Add the outcome of checking later columns to a result.
+inline
+void
+MergeCheckResults(CheckResult& result, const CheckResult& later, size_t maxReported)
+{
+    result.nChecked += later.nChecked;
+    result.nMismatches += later.nMismatches;
+    result.sumAbsErr += later.sumAbsErr;
+    for(const auto& sample : later.samples)
+    {
+        if(result.samples.size() < maxReported)
+        {
+            result.samples.push_back(sample);
+        }
+    }
+    if(later.maxAbsErr > result.maxAbsErr)
+    {
+        result.maxAbsErr = later.maxAbsErr;
+        result.maxErrAt = later.maxErrAt;
+    }
+}
+
+// Compare columns [firstCol, lastCol) of a matrix against
+// expected values.  getCol(c) must return the address of column
+// c's values in host memory, and fillExpected(c, expected) must
+// store the expected values of column c into expected[0..nRows).
+// Columns are divided among host threads, and each column is
+// compared as a contiguous array, with the common case (all values
+// within the absolute/relative tolerance) handled by a simple loop
+// the compiler can vectorize.
+template<typename T, typename GetColFunc, typename FillExpectedFunc>
+CheckResult
+CheckColumns(int nRows,
+                int firstCol,
+                int lastCol,
+                GetColFunc getCol,
+                FillExpectedFunc fillExpected,
+                const CheckOptions& opts)
+{
+    auto nCols = lastCol - firstCol;
+
+    auto nThreads = (opts.nThreads > 0) ? opts.nThreads : std::thread::hardware_concurrency();
+    nThreads = std::max(1u, std::min(nThreads, static_cast<unsigned int>(std::max(nCols, 1))));
+
+    auto absTol = static_cast<float>(opts.absTol);
+    auto relTol = static_cast<float>(opts.relTol);
+
+    // Check columns [firstCol, lastCol) into the given result.
+    auto checkCols = [&](int firstCol, int lastCol, CheckResult& result) {
+        std::vector<float> expected(nRows);
+        std::vector<float> computed(nRows);
+        std::vector<float> err(nRows);
+
+        for(auto c = firstCol; c < lastCol; ++c)
+        {
+            fillExpected(c, expected.data());
+            const T* col = getCol(c);
+
+            // Fast pass: count values outside abs/rel tolerance and
+            // find the column's largest error.
+            size_t nOutside = 0;
+            float colMaxErr = 0;
+            double colSumErr = 0;
+            for(auto r = 0; r < nRows; ++r)
+            {
+                computed[r] = ToFloat(col[r]);
+                err[r] = std::fabs(computed[r] - expected[r]);
+                auto bound = std::max(absTol, relTol * std::fabs(expected[r]));
+                nOutside += (err[r] <= bound) ? 0 : 1;  // NaN counts as outside
+                colMaxErr = std::max(colMaxErr, err[r]);  // NaN is ignored
+                colSumErr += err[r];
+            }
+            result.nChecked += nRows;
+            result.sumAbsErr += colSumErr;
+
+            if(colMaxErr > result.maxAbsErr)
+            {
+                auto r = static_cast<int>(std::find(err.begin(), err.end(), colMaxErr) - err.begin());
+                result.maxAbsErr = colMaxErr;
+                result.maxErrAt = Mismatch{ r, c, expected[r], computed[r] };
+            }
+
+            if(nOutside > 0)
+            {
+                // Slow pass: apply the ULP tolerance and record samples.
+                for(auto r = 0; r < nRows; ++r)
+                {
+                    auto bound = std::max(absTol, relTol * std::fabs(expected[r]));
+                    if(err[r] <= bound)
+                    {
+                        continue;
+                    }
+                    if( (opts.ulpTol > 0)
+                        and not std::isnan(err[r])
+                        and (UlpDistance(col[r], static_cast<T>(expected[r])) <= opts.ulpTol) )
+                    {
+                        continue;
+                    }
+
+                    ++result.nMismatches;
+                    if(result.samples.size() < opts.maxReported)
+                    {
+                        result.samples.push_back(Mismatch{ r, c, expected[r], computed[r] });
+                    }
+                }
+            }
+        }
+    };
+
+    // Each thread checks a contiguous block of columns, so
+    // concatenating their samples keeps column major order.
+    std::vector<CheckResult> partials(nThreads);
+    std::vector<std::thread> threads;
+    int colsPerThread = (nCols + nThreads - 1) / nThreads;
+    for(unsigned int t = 0; t < nThreads; ++t)
+    {
+        auto threadFirstCol = firstCol + std::min(nCols, static_cast<int>(t) * colsPerThread);
+        auto threadLastCol = std::min(lastCol, threadFirstCol + colsPerThread);
+        threads.emplace_back(checkCols, threadFirstCol, threadLastCol, std::ref(partials[t]));
+    }
+    for(auto& t : threads)
+    {
+        t.join();
+    }
+
+    CheckResult result;
+    for(const auto& partial : partials)
+    {
+        MergeCheckResults(result, partial, opts.maxReported);
+    }
+    return result;
+}
+
+// Compare a matrix's host data against expected values
+// (see CheckColumns).
+template<typename T, typename FillExpectedFunc>
+CheckResult
+CheckMatrix(const Matrix<T>& matrix,
+            FillExpectedFunc fillExpected,
+            const CheckOptions& opts)
+{
+    // Allocate host storage, if need be, before the threads share it.
+    matrix.GetHostData();
+    auto getCol = [&matrix](int c) { return &matrix.El(0, c); };
+    return CheckColumns<T>(matrix.GetNumRows(), 0, matrix.GetNumCols(), getCol, fillExpected, opts);
+}
+
+// Compare a matrix's device data against expected values, without
+// a full host copy: columns are copied to a host buffer of
+// GetChunkCols columns and checked a buffer at a time.
+template<typename T, typename FillExpectedFunc>
+CheckResult
+CheckMatrixStreamed(const Matrix<T>& matrix,
+                    FillExpectedFunc fillExpected,
+                    const CheckOptions& opts)
+{
+    TraceSpan span("CheckMatrixStreamed", "check");
+
+    auto nRows = matrix.GetNumRows();
+    auto nCols = matrix.GetNumCols();
+    auto colBytes = static_cast<size_t>(nRows) * sizeof(T);
+    auto chunkCols = static_cast<int>(GetChunkCols(colBytes, nCols));
+
+    Matrix<T> buffer(nRows, chunkCols);
+    auto getCol = [&buffer, &chunkCols](int c) { return &buffer.El(0, c % chunkCols); };
+
+    CheckResult result;
+    for(auto firstCol = 0; firstCol < nCols; firstCol += chunkCols)
+    {
+        auto lastCol = std::min(nCols, firstCol + chunkCols);
+        CHECK(hipMemcpy2D(buffer.GetHostData(), colBytes,
+                            &matrix.GetDeviceData()[static_cast<size_t>(firstCol) * matrix.GetLeadingDim()],
+                            matrix.GetLeadingDim() * sizeof(T),
+                            colBytes,
+                            lastCol - firstCol,
+                            hipMemcpyDeviceToHost));
+        MergeCheckResults(result,
+                            CheckColumns<T>(nRows, firstCol, lastCol, getCol, fillExpected, opts),
+                            opts.maxReported);
+    }
+    return result;
+}
+
+// Describe a check's outcome: the sampled mismatches,
+// then a summary with the total and the largest error.
+inline
+void
+ReportCheck(std::ostream& os, const CheckResult& result)
+{
+    // Show enough digits to tell apart values that differ in the last place.
+    auto oldPrecision = os.precision(std::numeric_limits<float>::max_digits10);
+    for(const auto& m : result.samples)
+    {
+        os << "mismatch at: (" << m.row << ", " << m.col << ")"
+            << " expected " << m.expected
+            << ", got " << m.computed
+            << '\n';
+    }
+    if(result.nMismatches > result.samples.size())
+    {
+        os << "(" << (result.nMismatches - result.samples.size())
+            << " more mismatches not shown)\n";
+    }
+    os << "Total mismatches: " << result.nMismatches << '\n'
+        << "Max abs error: " << result.maxAbsErr;
+
+    // With no error at all, there is no element to point to.
+    if(result.maxAbsErr > 0)
+    {
+        os << " at (" << result.maxErrAt.row << ", " << result.maxErrAt.col << ")"
+            << " expected " << result.maxErrAt.expected
+            << ", got " << result.maxErrAt.computed;
+    }
+    os << std::endl;
+    os.precision(oldPrecision);
+}
+
+#endif // TEST_MATRIX_CHECKER_H
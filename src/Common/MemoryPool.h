@@ -0,0 +1,413 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_MEMORY_POOL_H
+#define TEST_MEMORY_POOL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "HipstarException.h"
+
+// Statistics about a MemoryPool's use.
+struct MemoryPoolStats
+{
+    // Allocations satisfied from cached blocks.
+    uint64_t nHits = 0;
+
+    // Allocations that needed a new block from the HIP runtime.
+    uint64_t nMisses = 0;
+
+    // Bytes handed out to clients (rounded up to the size class).
+    size_t bytesInUse = 0;
+    size_t peakBytesInUse = 0;
+
+    // Bytes obtained from the HIP runtime, whether in use or cached.
+    size_t bytesReserved = 0;
+    size_t peakBytesReserved = 0;
+};
+
+// Raw allocation policies for MemoryPool.
+struct PinnedHostMemory
+{
+    static constexpr const char* name = "pinned host";
+
+    static void* Allocate(size_t nBytes)
+    {
+        void* ptr = nullptr;
+        CHECK(hipHostMalloc(&ptr, nBytes));
+        return ptr;
+    }
+
+    static void Free(void* ptr)  { CHECK(hipHostFree(ptr)); }
+};
+
+struct DeviceMemory
+{
+    static constexpr const char* name = "device";
+
+    static void* Allocate(size_t nBytes)
+    {
+        void* ptr = nullptr;
+        CHECK(hipMalloc(&ptr, nBytes));
+        return ptr;
+    }
+
+    static void Free(void* ptr)  { CHECK(hipFree(ptr)); }
+};
+
+// Ordinary host memory, as applications often hold their data in.
+// The runtime must stage copies of it through pinned buffers.
+struct PageableHostMemory
+{
+    static constexpr const char* name = "pageable host";
+
+    static void* Allocate(size_t nBytes)
+    {
+        void* ptr = std::malloc(nBytes);
+        if(ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    static void Free(void* ptr)  { std::free(ptr); }
+};
+
+// Memory usable from both host and device, migrated by the runtime.
+struct ManagedMemory
+{
+    static constexpr const char* name = "managed";
+
+    static void* Allocate(size_t nBytes)
+    {
+        void* ptr = nullptr;
+        CHECK(hipMallocManaged(&ptr, nBytes));
+        return ptr;
+    }
+
+    static void Free(void* ptr)  { CHECK(hipFree(ptr)); }
+};
+
+// A caching allocator.
+// Freed blocks are kept in per-size-class free lists and reused
+// for later allocations in the same size class, so that repeatedly
+// creating and destroying Matrix objects (e.g., in a sweep)
+// doesn't pay the HIP runtime's allocation cost every time.
+// Size classes are spaced four per power of two, so at most
+// 25% of a block is wasted.
+// A freed block may still be in use by work queued on the device, so
+// Free records an event for it, and the block is handed out again
+// only once that event has completed.
+// Caching can be disabled to measure raw allocation cost;
+// statistics are kept either way.
+template<typename RawMemory>
+class MemoryPool
+{
+private:
+    mutable std::mutex mtx;
+    bool enabled;
+
+    // A cached block, and the event recorded when it was freed.
+    struct FreeBlock
+    {
+        void* ptr;
+        hipEvent_t freed;
+    };
+
+    // Cached blocks, keyed by size class, oldest first.
+    std::map<size_t, std::vector<FreeBlock>> freeBlocks;
+
+    // Each cached block's event, kept for reuse while the block is in use.
+    std::unordered_map<void*, hipEvent_t> blockEvents;
+
+    // Blocks currently in use, and their size class.
+    std::unordered_map<void*, size_t> liveBlocks;
+
+    MemoryPoolStats stats;
+
+    static size_t GetSizeClass(size_t nBytes)
+    {
+        constexpr size_t minBlockSize = 256;
+        if(nBytes <= minBlockSize)
+        {
+            return minBlockSize;
+        }
+
+        // Find the power of two at or below nBytes, then
+        // round up to the next quarter step above it.
+        size_t pow2 = minBlockSize;
+        while((pow2 * 2) <= nBytes)
+        {
+            pow2 *= 2;
+        }
+        size_t quarter = pow2 / 4;
+        return ((nBytes + quarter - 1) / quarter) * quarter;
+    }
+
+    void NoteInUse(size_t nBytes)
+    {
+        stats.bytesInUse += nBytes;
+        stats.peakBytesInUse = std::max(stats.peakBytesInUse, stats.bytesInUse);
+    }
+
+    void NoteReserved(size_t nBytes)
+    {
+        stats.bytesReserved += nBytes;
+        stats.peakBytesReserved = std::max(stats.peakBytesReserved, stats.bytesReserved);
+    }
+
+public:
+    MemoryPool(void)
+      : enabled(true)
+    { }
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    ~MemoryPool(void)
+    {
+        // We don't free cached blocks here, because at static
+        // destruction time the HIP runtime may already be gone.
+        // Programs should call Release before exiting.
+    }
+
+    bool IsEnabled(void) const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return enabled;
+    }
+
+    // Turn caching on or off.  Turning it off releases cached blocks.
+    void SetEnabled(bool _enabled)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            enabled = _enabled;
+        }
+        if(not _enabled)
+        {
+            Release();
+        }
+    }
+
+    void* Allocate(size_t nBytes)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        void* ptr = nullptr;
+        hipEvent_t mustWaitFor = nullptr;
+        size_t blockSize = enabled ? GetSizeClass(nBytes) : nBytes;
+        if(enabled)
+        {
+            auto iter = freeBlocks.find(blockSize);
+            if((iter != freeBlocks.end()) and not iter->second.empty())
+            {
+                // Prefer a block the device is done with.  If there is
+                // none, take the oldest and wait for it below.
+                auto& blocks = iter->second;
+                auto chosen = std::find_if(blocks.begin(), blocks.end(), [](const FreeBlock& block) {
+                    auto err = hipEventQuery(block.freed);
+                    if(err == hipErrorNotReady)
+                    {
+                        return false;
+                    }
+                    CHECK(err);
+                    return true;
+                });
+                if(chosen == blocks.end())
+                {
+                    chosen = blocks.begin();
+                    mustWaitFor = chosen->freed;
+                }
+                ptr = chosen->ptr;
+                blocks.erase(chosen);
+                ++stats.nHits;
+            }
+        }
+        if(ptr == nullptr)
+        {
+            ptr = RawMemory::Allocate(blockSize);
+            ++stats.nMisses;
+            NoteReserved(blockSize);
+        }
+
+        liveBlocks[ptr] = blockSize;
+        NoteInUse(blockSize);
+
+        // The block is ours now, so other threads needn't wait with us.
+        lock.unlock();
+        if(mustWaitFor != nullptr)
+        {
+            CHECK(hipEventSynchronize(mustWaitFor));
+        }
+        return ptr;
+    }
+
+    void Free(void* ptr)
+    {
+        if(ptr == nullptr)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto iter = liveBlocks.find(ptr);
+        if(iter == liveBlocks.end())
+        {
+            throw std::invalid_argument(std::string("freeing unknown ") + RawMemory::name + " block");
+        }
+        auto blockSize = iter->second;
+        liveBlocks.erase(iter);
+        stats.bytesInUse -= blockSize;
+
+        if(enabled)
+        {
+            // Work still queued may use the block, so note when the
+            // device gets past it.  The null stream orders after all
+            // work on blocking streams, so one event covers any stream
+            // the block was used on.
+            auto& freed = blockEvents[ptr];
+            if(freed == nullptr)
+            {
+                CHECK(hipEventCreate(&freed));
+            }
+            CHECK(hipEventRecord(freed, nullptr));
+            freeBlocks[blockSize].push_back({ ptr, freed });
+        }
+        else
+        {
+            auto eventIter = blockEvents.find(ptr);
+            if(eventIter != blockEvents.end())
+            {
+                CHECK(hipEventDestroy(eventIter->second));
+                blockEvents.erase(eventIter);
+            }
+            RawMemory::Free(ptr);
+            stats.bytesReserved -= blockSize;
+        }
+    }
+
+    // Return all cached (i.e., not in use) blocks to the HIP runtime.
+    void Release(void)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for(auto& [blockSize, blocks] : freeBlocks)
+        {
+            for(const auto& block : blocks)
+            {
+                CHECK(hipEventSynchronize(block.freed));
+                CHECK(hipEventDestroy(block.freed));
+                blockEvents.erase(block.ptr);
+                RawMemory::Free(block.ptr);
+                stats.bytesReserved -= blockSize;
+            }
+        }
+        freeBlocks.clear();
+    }
+
+    MemoryPoolStats GetStats(void) const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+    void ReportTo(std::ostream& os) const
+    {
+        auto s = GetStats();
+        os << RawMemory::name << " memory pool"
+            << (IsEnabled() ? "" : " (caching disabled)")
+            << ": hits " << s.nHits
+            << ", misses " << s.nMisses
+            << ", peak bytes in use " << s.peakBytesInUse
+            << ", peak bytes reserved " << s.peakBytesReserved
+            << std::endl;
+    }
+};
+
+// The process-wide pools used by Matrix.
+inline
+MemoryPool<PinnedHostMemory>&
+PinnedHostPool(void)
+{
+    static MemoryPool<PinnedHostMemory> pool;
+    return pool;
+}
+
+inline
+MemoryPool<DeviceMemory>&
+DevicePool(void)
+{
+    static MemoryPool<DeviceMemory> pool;
+    return pool;
+}
+
+// Pools for matrices with other storage (see MatrixStorage).
+inline
+MemoryPool<PageableHostMemory>&
+PageableHostPool(void)
+{
+    static MemoryPool<PageableHostMemory> pool;
+    return pool;
+}
+
+inline
+MemoryPool<ManagedMemory>&
+ManagedPool(void)
+{
+    static MemoryPool<ManagedMemory> pool;
+    return pool;
+}
+
+inline
+void
+SetMemoryPoolsEnabled(bool enabled)
+{
+    PinnedHostPool().SetEnabled(enabled);
+    DevicePool().SetEnabled(enabled);
+    PageableHostPool().SetEnabled(enabled);
+    ManagedPool().SetEnabled(enabled);
+}
+
+// Describe the most host and device memory the run's matrices
+// used at once.  With caching, more may have been held.
+// Pageable and managed memory are only mentioned if used.
+inline
+void
+ReportPeakMemory(std::ostream& os)
+{
+    constexpr double mib = 1024.0 * 1024.0;
+    os << "peak memory in use: pinned host "
+        << (PinnedHostPool().GetStats().peakBytesInUse / mib) << " MiB, device "
+        << (DevicePool().GetStats().peakBytesInUse / mib) << " MiB";
+    if(PageableHostPool().GetStats().peakBytesInUse > 0)
+    {
+        os << ", pageable host " << (PageableHostPool().GetStats().peakBytesInUse / mib) << " MiB";
+    }
+    if(ManagedPool().GetStats().peakBytesInUse > 0)
+    {
+        os << ", managed " << (ManagedPool().GetStats().peakBytesInUse / mib) << " MiB";
+    }
+    os << std::endl;
+}
+
+inline
+void
+ReleaseMemoryPools(void)
+{
+    PinnedHostPool().Release();
+    DevicePool().Release();
+    PageableHostPool().Release();
+    ManagedPool().Release();
+}
+
+#endif // TEST_MEMORY_POOL_H
@@ -0,0 +1,268 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_RESULTS_WRITER_H
+#define TEST_RESULTS_WRITER_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "MemoryPool.h"
+#include "src/Common/ExtTestConfig.h"
+
+// An ordered set of named values, written as a JSON object.
+class JsonObject
+{
+private:
+    // Values are kept already encoded as JSON.
+    std::vector<std::pair<std::string, std::string>> fields;
+
+public:
+    static std::string Encode(const std::string& str)
+    {
+        std::ostringstream ostr;
+        ostr << '"';
+        for(auto c : str)
+        {
+            if( (c == '"') or (c == '\\') )
+            {
+                ostr << '\\' << c;
+            }
+            else if(static_cast<unsigned char>(c) < 0x20)
+            {
+                ostr << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+            }
+            else
+            {
+                ostr << c;
+            }
+        }
+        ostr << '"';
+        return ostr.str();
+    }
+
+    static std::string Encode(double val)
+    {
+        if(not std::isfinite(val))
+        {
+            return "null";
+        }
+        std::ostringstream ostr;
+        ostr << std::setprecision(10) << val;
+        return ostr.str();
+    }
+
+    JsonObject& Add(const std::string& key, const std::string& val)
+    {
+        fields.emplace_back(key, Encode(val));
+        return *this;
+    }
+
+    JsonObject& Add(const std::string& key, const char* val)
+    {
+        return Add(key, std::string(val));
+    }
+
+    JsonObject& Add(const std::string& key, double val)
+    {
+        fields.emplace_back(key, Encode(val));
+        return *this;
+    }
+
+    JsonObject& Add(const std::string& key, int64_t val)
+    {
+        fields.emplace_back(key, std::to_string(val));
+        return *this;
+    }
+
+    JsonObject& Add(const std::string& key, int val)
+    {
+        return Add(key, static_cast<int64_t>(val));
+    }
+
+    JsonObject& Add(const std::string& key, size_t val)
+    {
+        return Add(key, static_cast<int64_t>(val));
+    }
+
+    JsonObject& Add(const std::string& key, bool val)
+    {
+        fields.emplace_back(key, val ? "true" : "false");
+        return *this;
+    }
+
+    void WriteTo(std::ostream& os) const
+    {
+        os << '{';
+        for(size_t i = 0; i < fields.size(); ++i)
+        {
+            os << ((i > 0) ? "," : "") << Encode(fields[i].first) << ':' << fields[i].second;
+        }
+        os << '}';
+    }
+};
+
+// One result: the configuration that identifies it (what was run),
+// what was measured, and the raw timing samples, if any, so that
+// results can be compared with a statistical test.
+struct ResultRecord
+{
+    JsonObject config;
+    JsonObject metrics;
+    std::vector<double> samplesMs;
+    bool passed = true;
+};
+
+// Collects the results of a run and writes them, with a description
+// of the environment (versions, device), as a JSON file:
+//   { "environment": {...},
+//     "results": [ { "config": {...}, "metrics": {...},
+//                    "samples_ms": [...], "status": "PASS" }, ... ] }
+// The exttest_compare tool reads these files.
+class ResultsWriter
+{
+private:
+    bool enabled = false;
+    std::string program;
+    JsonObject environment;
+    std::vector<ResultRecord> records;
+
+    // Number of results that failed, whether or not they are collected.
+    size_t nFailed = 0;
+
+    ResultsWriter(void) = default;
+
+public:
+    // The process's results writer.
+    static ResultsWriter& Get(void)
+    {
+        static ResultsWriter writer;
+        return writer;
+    }
+
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+    bool IsEnabled(void) const  { return enabled; }
+
+    // Whether any result added so far failed, so programs
+    // can exit with an error if any did.
+    bool AnyFailed(void) const  { return nFailed > 0; }
+
+    // Start collecting results of the named program, and
+    // describe the test build.  This makes no HIP calls, so
+    // that startup can still be profiled.
+    void Enable(const std::string& programPath)
+    {
+        enabled = true;
+        program = programPath.substr(programPath.find_last_of('/') + 1);
+
+        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        environment.Add("program", program)
+            .Add("exttest_version", EXTTEST_VERSION)
+            .Add("build_type", EXTTEST_BUILD_TYPE)
+            .Add("timestamp", timestamp);
+    }
+
+    // Describe the HIP runtime, device, and peak memory use.
+    // Done when the results are written.
+    void AddDeviceEnvironment(void)
+    {
+        int runtimeVersion = 0;
+        if(hipRuntimeGetVersion(&runtimeVersion) == hipSuccess)
+        {
+            environment.Add("hip_runtime_version", runtimeVersion);
+        }
+        int deviceId = 0;
+        hipDeviceProp_t props;
+        if( (hipGetDevice(&deviceId) == hipSuccess)
+            and (hipGetDeviceProperties(&props, deviceId) == hipSuccess) )
+        {
+            environment.Add("device", props.name)
+                .Add("device_memory_bytes", static_cast<size_t>(props.totalGlobalMem));
+        }
+
+        // How much memory the run's matrices needed.
+        environment.Add("peak_pinned_host_bytes", PinnedHostPool().GetStats().peakBytesInUse)
+            .Add("peak_device_bytes", DevicePool().GetStats().peakBytesInUse);
+        if(PageableHostPool().GetStats().peakBytesInUse > 0)
+        {
+            environment.Add("peak_pageable_host_bytes", PageableHostPool().GetStats().peakBytesInUse);
+        }
+        if(ManagedPool().GetStats().peakBytesInUse > 0)
+        {
+            environment.Add("peak_managed_bytes", ManagedPool().GetStats().peakBytesInUse);
+        }
+    }
+
+    // Describe more of the environment (e.g., library versions).
+    template<typename T>
+    void AddEnvironment(const std::string& key, const T& val)
+    {
+        environment.Add(key, val);
+    }
+
+    void Add(ResultRecord record)
+    {
+        if(not record.passed)
+        {
+            ++nFailed;
+        }
+        if(enabled)
+        {
+            records.push_back(std::move(record));
+        }
+    }
+
+    void WriteTo(std::ostream& os) const
+    {
+        os << "{\"environment\":";
+        environment.WriteTo(os);
+        os << ",\n\"results\":[";
+        for(size_t i = 0; i < records.size(); ++i)
+        {
+            const auto& record = records[i];
+            os << ((i > 0) ? ",\n" : "\n") << "{\"config\":";
+            record.config.WriteTo(os);
+            os << ",\"metrics\":";
+            record.metrics.WriteTo(os);
+            os << ",\"samples_ms\":[";
+            for(size_t j = 0; j < record.samplesMs.size(); ++j)
+            {
+                os << ((j > 0) ? "," : "") << JsonObject::Encode(record.samplesMs[j]);
+            }
+            os << "],\"status\":" << (record.passed ? "\"PASS\"" : "\"FAIL\"") << '}';
+        }
+        os << "\n]}\n";
+    }
+
+    // If collecting results, write them to the given file.
+    void Finish(const std::string& path)
+    {
+        if(enabled)
+        {
+            std::ofstream ofs(path);
+            if(not ofs)
+            {
+                throw std::runtime_error("cannot open results file " + path);
+            }
+            AddDeviceEnvironment();
+            WriteTo(ofs);
+            enabled = false;
+        }
+    }
+};
+
+#endif // TEST_RESULTS_WRITER_H
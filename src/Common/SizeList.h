@@ -0,0 +1,131 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_SIZE_LIST_H
+#define TEST_SIZE_LIST_H
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Parse one value from a size list specification.
+template<typename T>
+T
+ParseSizeValue(const std::string& str, const std::string& spec)
+{
+    size_t nParsed = 0;
+    long long val = 0;
+    try
+    {
+        val = std::stoll(str, &nParsed);
+    }
+    catch(const std::exception&)
+    {
+        nParsed = 0;
+    }
+    if((nParsed == 0) or (nParsed != str.size()))
+    {
+        throw std::invalid_argument("bad value '" + str + "' in size list '" + spec + "'");
+    }
+    if( (val < static_cast<long long>(std::numeric_limits<T>::min()))
+        or (static_cast<unsigned long long>(val) > static_cast<unsigned long long>(std::numeric_limits<T>::max())) )
+    {
+        throw std::invalid_argument("value '" + str + "' in size list '" + spec + "' is out of range");
+    }
+    return static_cast<T>(val);
+}
+
+// Parse a specification of a list of sizes, e.g. for sweeping
+// over problem shapes.  The specification is a comma-separated
+// list of items, where each item is one of:
+// * a single value, e.g. "1000"
+// * an additive range start:stop[:step], e.g. "128:1024:128"
+//   or "128:1024:+128".  The step defaults to 1.
+// * a multiplicative range start:stop:xFactor, e.g. "64:8192:x2"
+// Ranges include stop if the step lands on it.
+// So "64:256:x2,1000" is 64, 128, 256, 1000.
+template<typename T>
+std::vector<T>
+ParseSizeList(const std::string& spec)
+{
+    std::vector<T> ret;
+
+    size_t itemStart = 0;
+    while(itemStart <= spec.size())
+    {
+        auto itemEnd = spec.find(',', itemStart);
+        if(itemEnd == std::string::npos)
+        {
+            itemEnd = spec.size();
+        }
+        auto item = spec.substr(itemStart, itemEnd - itemStart);
+        itemStart = itemEnd + 1;
+
+        // Split the item into its colon-separated fields.
+        std::vector<std::string> fields;
+        size_t fieldStart = 0;
+        while(true)
+        {
+            auto fieldEnd = item.find(':', fieldStart);
+            fields.push_back(item.substr(fieldStart, fieldEnd - fieldStart));
+            if(fieldEnd == std::string::npos)
+            {
+                break;
+            }
+            fieldStart = fieldEnd + 1;
+        }
+
+        if(fields.size() == 1)
+        {
+            ret.push_back(ParseSizeValue<T>(fields[0], spec));
+        }
+        else if((fields.size() == 2) or (fields.size() == 3))
+        {
+            auto start = ParseSizeValue<T>(fields[0], spec);
+            auto stop = ParseSizeValue<T>(fields[1], spec);
+            bool multiplicative = false;
+            T step = 1;
+            if(fields.size() == 3)
+            {
+                auto stepStr = fields[2];
+                if(not stepStr.empty() and ((stepStr[0] == 'x') or (stepStr[0] == '*')))
+                {
+                    multiplicative = true;
+                    stepStr = stepStr.substr(1);
+                }
+                else if(not stepStr.empty() and (stepStr[0] == '+'))
+                {
+                    stepStr = stepStr.substr(1);
+                }
+                step = ParseSizeValue<T>(stepStr, spec);
+            }
+
+            if((start <= 0) or (stop < start) or (step < (multiplicative ? 2 : 1)))
+            {
+                throw std::invalid_argument("bad range '" + item + "' in size list '" + spec + "'");
+            }
+            for(auto val = start; val <= stop; )
+            {
+                ret.push_back(val);
+
+                // Stop rather than overflow.
+                // (Values are known to be positive here.)
+                auto next = multiplicative
+                    ? static_cast<unsigned long long>(val) * step
+                    : static_cast<unsigned long long>(val) + step;
+                if(next > static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+                {
+                    break;
+                }
+                val = static_cast<T>(next);
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("bad item '" + item + "' in size list '" + spec + "'");
+        }
+    }
+    return ret;
+}
+
+#endif // TEST_SIZE_LIST_H
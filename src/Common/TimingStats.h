@@ -0,0 +1,84 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_TIMING_STATS_H
+#define TEST_TIMING_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+// Summary statistics for a set of timing samples (in milliseconds).
+struct TimingStats
+{
+    size_t nSamples = 0;
+    double minMs = 0;
+    double medianMs = 0;
+    double meanMs = 0;
+    double p95Ms = 0;
+    double maxMs = 0;
+
+    TimingStats(void) = default;
+
+    TimingStats(std::vector<double> samples)
+      : nSamples(samples.size())
+    {
+        if(samples.empty())
+        {
+            return;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        minMs = samples.front();
+        maxMs = samples.back();
+        meanMs = std::accumulate(samples.begin(), samples.end(), 0.0) / nSamples;
+        medianMs = Percentile(samples, 50);
+        p95Ms = Percentile(samples, 95);
+    }
+
+    // Nearest-rank percentile of already-sorted samples.
+    static double Percentile(const std::vector<double>& sorted, double pct)
+    {
+        auto rank = static_cast<size_t>(std::ceil(pct / 100.0 * sorted.size()));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+};
+
+inline
+std::ostream&
+operator<<(std::ostream& os, const TimingStats& stats)
+{
+    auto oldFlags = os.flags();
+    auto oldPrecision = os.precision();
+    os << std::fixed << std::setprecision(4)
+        << "min " << stats.minMs << " ms"
+        << ", median " << stats.medianMs << " ms"
+        << ", mean " << stats.meanMs << " ms"
+        << ", p95 " << stats.p95Ms << " ms"
+        << " (" << stats.nSamples << " samples)";
+    os.flags(oldFlags);
+    os.precision(oldPrecision);
+    return os;
+}
+
+// Achieved rate in GFLOP/s for the given number of floating point
+// operations done in the given number of milliseconds.
+inline
+double
+ToGflops(double nFlops, double ms)
+{
+    return (ms > 0) ? (nFlops / (ms * 1.0e6)) : 0.0;
+}
+
+// Achieved bandwidth in GB/s for the given number of bytes
+// moved in the given number of milliseconds.
+inline
+double
+ToGBps(double nBytes, double ms)
+{
+    return (ms > 0) ? (nBytes / (ms * 1.0e6)) : 0.0;
+}
+
+#endif // TEST_TIMING_STATS_H
@@ -0,0 +1,333 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_TRACE_H
+#define TEST_TRACE_H
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "HipstarException.h"
+
+// Collects timed spans of the phases of a run (allocation, copies,
+// library calls, GEMMs, verification) and writes them as a Chrome
+// trace (JSON trace event format), which chrome://tracing and
+// Perfetto can display.
+//
+// Host spans are timed with the host clock.  Device spans bracket
+// work enqueued on a stream with HIP events, and are placed on the
+// host timeline using an event recorded and waited for when the
+// first device span starts.
+//
+// Tracing is off unless enabled, and then spans cost one check of
+// a flag, so spans can stay in the benchmarked code paths.
+class Tracer
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct HostSpan
+    {
+        std::string name;
+        const char* category;
+        double startUs;
+        double durUs;
+        int tid;
+    };
+
+    struct DeviceSpan
+    {
+        std::string name;
+        int tid;
+        hipEvent_t start;
+        hipEvent_t end;
+    };
+
+    bool enabled = false;
+    Clock::time_point origin;
+
+    std::mutex mutex;
+    std::vector<HostSpan> hostSpans;
+    std::vector<DeviceSpan> deviceSpans;
+
+    // Small ids for host threads and streams, in order of first use.
+    std::map<std::thread::id, int> threadIds;
+    std::map<hipStream_t, int> streamIds;
+
+    // Device time reference: an event, and the host time when it completed.
+    hipEvent_t deviceOrigin = nullptr;
+    double deviceOriginUs = 0;
+
+    Tracer(void) = default;
+
+    double NowUs(void) const
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - origin).count();
+    }
+
+    static void WriteString(std::ostream& os, const std::string& str)
+    {
+        os << '"';
+        for(auto c : str)
+        {
+            if( (c == '"') or (c == '\\') )
+            {
+                os << '\\';
+            }
+            os << c;
+        }
+        os << '"';
+    }
+
+    static void WriteEvent(std::ostream& os,
+                            const std::string& name,
+                            const char* category,
+                            double startUs,
+                            double durUs,
+                            int pid,
+                            int tid)
+    {
+        os << "{\"name\":";
+        WriteString(os, name);
+        os << ",\"cat\":\"" << category << '"'
+            << ",\"ph\":\"X\",\"ts\":" << startUs
+            << ",\"dur\":" << durUs
+            << ",\"pid\":" << pid
+            << ",\"tid\":" << tid
+            << '}';
+    }
+
+    static void WriteMetadata(std::ostream& os,
+                                const char* kind,
+                                int pid,
+                                int tid,
+                                const std::string& name)
+    {
+        os << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":";
+        WriteString(os, name);
+        os << "}}";
+    }
+
+public:
+    // The process's tracer.
+    static Tracer& Get(void)
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    bool IsEnabled(void) const  { return enabled; }
+
+    // Start collecting spans, timed from now.
+    void Enable(void)
+    {
+        origin = Clock::now();
+        enabled = true;
+    }
+
+    // Start timing a span of host work.
+    double BeginHostSpan(void) const
+    {
+        return NowUs();
+    }
+
+    void EndHostSpan(const char* name, const char* category, double startUs)
+    {
+        auto endUs = NowUs();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = threadIds.emplace(std::this_thread::get_id(), static_cast<int>(threadIds.size())).first;
+        hostSpans.push_back(HostSpan{ name, category, startUs, endUs - startUs, iter->second });
+    }
+
+    // Start a span of device work enqueued on the given stream.
+    // Returns an index to pass to EndDeviceSpan.
+    size_t BeginDeviceSpan(const char* name, hipStream_t stream)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(deviceOrigin == nullptr)
+        {
+            CHECK(hipEventCreate(&deviceOrigin));
+            CHECK(hipEventRecord(deviceOrigin, stream));
+            CHECK(hipEventSynchronize(deviceOrigin));
+            deviceOriginUs = NowUs();
+        }
+
+        auto iter = streamIds.emplace(stream, static_cast<int>(streamIds.size())).first;
+        DeviceSpan span{ name, iter->second, nullptr, nullptr };
+        CHECK(hipEventCreate(&span.start));
+        CHECK(hipEventCreate(&span.end));
+        CHECK(hipEventRecord(span.start, stream));
+        deviceSpans.push_back(span);
+        return deviceSpans.size() - 1;
+    }
+
+    void EndDeviceSpan(size_t idx, hipStream_t stream)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CHECK(hipEventRecord(deviceSpans[idx].end, stream));
+    }
+
+    // Wait for the device spans to complete, and write all spans
+    // as a Chrome trace.  Must be called while the HIP runtime
+    // is still usable; releases the HIP events.
+    void WriteTo(std::ostream& os)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        WriteMetadata(os, "process_name", 1, 0, "host");
+        os << ",\n";
+        WriteMetadata(os, "process_name", 2, 0, "device");
+        for(const auto& entry : threadIds)
+        {
+            os << ",\n";
+            WriteMetadata(os, "thread_name", 1, entry.second, "thread " + std::to_string(entry.second));
+        }
+        for(const auto& entry : streamIds)
+        {
+            os << ",\n";
+            WriteMetadata(os, "thread_name", 2, entry.second, "stream " + std::to_string(entry.second));
+        }
+
+        for(const auto& span : hostSpans)
+        {
+            os << ",\n";
+            WriteEvent(os, span.name, span.category, span.startUs, span.durUs, 1, span.tid);
+        }
+
+        for(auto& span : deviceSpans)
+        {
+            float startMs = 0;
+            float endMs = 0;
+            CHECK(hipEventSynchronize(span.end));
+            CHECK(hipEventElapsedTime(&startMs, deviceOrigin, span.start));
+            CHECK(hipEventElapsedTime(&endMs, deviceOrigin, span.end));
+            CHECK(hipEventDestroy(span.start));
+            CHECK(hipEventDestroy(span.end));
+
+            os << ",\n";
+            WriteEvent(os,
+                        span.name,
+                        "device",
+                        deviceOriginUs + startMs * 1000.0,
+                        (endMs - startMs) * 1000.0,
+                        2,
+                        span.tid);
+        }
+        os << "\n]}\n";
+
+        if(deviceOrigin != nullptr)
+        {
+            CHECK(hipEventDestroy(deviceOrigin));
+            deviceOrigin = nullptr;
+        }
+        hostSpans.clear();
+        deviceSpans.clear();
+    }
+
+    // If tracing, write the trace to the given file.
+    void Finish(const std::string& path)
+    {
+        if(enabled)
+        {
+            std::ofstream ofs(path);
+            if(not ofs)
+            {
+                throw std::runtime_error("cannot open trace file " + path);
+            }
+            WriteTo(ofs);
+            enabled = false;
+        }
+    }
+};
+
+// Times the host work done during its lifetime, if tracing.
+// The name and category must outlive the span (e.g., literals).
+class TraceSpan
+{
+private:
+    const char* name;
+    const char* category;
+    bool active;
+    double startUs;
+
+public:
+    TraceSpan(const char* _name, const char* _category)
+      : name(_name),
+        category(_category),
+        active(Tracer::Get().IsEnabled()),
+        startUs(0)
+    {
+        if(active)
+        {
+            startUs = Tracer::Get().BeginHostSpan();
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan(void)
+    {
+        if(active)
+        {
+            Tracer::Get().EndHostSpan(name, category, startUs);
+        }
+    }
+};
+
+// Times the device work enqueued on a stream during its lifetime,
+// if tracing.
+class DeviceTraceSpan
+{
+private:
+    hipStream_t stream;
+    bool active;
+    size_t idx;
+
+public:
+    DeviceTraceSpan(const char* name, hipStream_t _stream)
+      : stream(_stream),
+        active(Tracer::Get().IsEnabled()),
+        idx(0)
+    {
+        // Work being captured into a graph doesn't run now,
+        // so there's nothing to time.
+        hipStreamCaptureStatus captureStatus = hipStreamCaptureStatusNone;
+        if( active
+            and (hipStreamIsCapturing(stream, &captureStatus) == hipSuccess)
+            and (captureStatus != hipStreamCaptureStatusNone) )
+        {
+            active = false;
+        }
+
+        if(active)
+        {
+            idx = Tracer::Get().BeginDeviceSpan(name, stream);
+        }
+    }
+
+    DeviceTraceSpan(const DeviceTraceSpan&) = delete;
+    DeviceTraceSpan& operator=(const DeviceTraceSpan&) = delete;
+
+    ~DeviceTraceSpan(void)
+    {
+        if(active)
+        {
+            Tracer::Get().EndDeviceSpan(idx, stream);
+        }
+    }
+};
+
+#endif // TEST_TRACE_H
@@ -0,0 +1,131 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_TRANSFER_H
+#define TEST_TRANSFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "HipstarException.h"
+#include "HipStream.h"
+
+// Largest number of bytes moved by a single host/device copy call.
+// Large transfers are split into chunks of this size, so that no
+// single copy exceeds what a runtime handles well, and so the
+// chunks can be spread over several streams to overlap.
+// Zero means never split.
+inline
+size_t&
+TransferChunkBytes(void)
+{
+    static size_t chunkBytes = size_t(256) << 20;
+    return chunkBytes;
+}
+
+// Copy nBytes between host and device, synchronously,
+// in chunks of at most TransferChunkBytes().
+inline
+void
+ChunkedCopy(void* dst, const void* src, size_t nBytes, hipMemcpyKind kind)
+{
+    auto chunkBytes = (TransferChunkBytes() > 0) ? TransferChunkBytes() : nBytes;
+    for(size_t offset = 0; offset < nBytes; offset += chunkBytes)
+    {
+        CHECK(hipMemcpy(static_cast<char*>(dst) + offset,
+                        static_cast<const char*>(src) + offset,
+                        std::min(chunkBytes, nBytes - offset),
+                        kind));
+    }
+}
+
+// Copy nBytes between host and device asynchronously, in chunks of
+// at most TransferChunkBytes(), assigning chunks to the given
+// streams round-robin so that chunks on different streams can overlap.
+inline
+void
+ChunkedCopyAsync(void* dst,
+                    const void* src,
+                    size_t nBytes,
+                    hipMemcpyKind kind,
+                    const std::vector<const HipStream*>& streams)
+{
+    auto chunkBytes = (TransferChunkBytes() > 0) ? TransferChunkBytes() : nBytes;
+    size_t chunkIdx = 0;
+    for(size_t offset = 0; offset < nBytes; offset += chunkBytes, ++chunkIdx)
+    {
+        CHECK(hipMemcpyAsync(static_cast<char*>(dst) + offset,
+                                static_cast<const char*>(src) + offset,
+                                std::min(chunkBytes, nBytes - offset),
+                                kind,
+                                streams[chunkIdx % streams.size()]->GetHandle()));
+    }
+}
+
+// Number of whole columns of colBytes bytes each (at least one, at
+// most nCols) that fit in TransferChunkBytes().
+inline
+size_t
+GetChunkCols(size_t colBytes, size_t nCols)
+{
+    auto chunkCols = ((TransferChunkBytes() > 0) and (colBytes > 0)) ?
+                            std::max(TransferChunkBytes() / colBytes, size_t(1)) : nCols;
+    return std::min(chunkCols, std::max(nCols, size_t(1)));
+}
+
+// Copy nCols columns of colBytes bytes each between host and device,
+// synchronously, where consecutive columns are dstPitch and srcPitch
+// bytes apart.  Skips the padding between columns.  Each copy call
+// moves as many whole columns as fit in TransferChunkBytes() (at least one).
+inline
+void
+ChunkedCopy2D(void* dst,
+                size_t dstPitch,
+                const void* src,
+                size_t srcPitch,
+                size_t colBytes,
+                size_t nCols,
+                hipMemcpyKind kind)
+{
+    auto chunkCols = GetChunkCols(colBytes, nCols);
+    for(size_t col = 0; col < nCols; col += chunkCols)
+    {
+        CHECK(hipMemcpy2D(static_cast<char*>(dst) + col * dstPitch,
+                            dstPitch,
+                            static_cast<const char*>(src) + col * srcPitch,
+                            srcPitch,
+                            colBytes,
+                            std::min(chunkCols, nCols - col),
+                            kind));
+    }
+}
+
+// As ChunkedCopy2D, but asynchronously, assigning
+// chunks to the given streams round-robin.
+inline
+void
+ChunkedCopy2DAsync(void* dst,
+                    size_t dstPitch,
+                    const void* src,
+                    size_t srcPitch,
+                    size_t colBytes,
+                    size_t nCols,
+                    hipMemcpyKind kind,
+                    const std::vector<const HipStream*>& streams)
+{
+    auto chunkCols = GetChunkCols(colBytes, nCols);
+    size_t chunkIdx = 0;
+    for(size_t col = 0; col < nCols; col += chunkCols, ++chunkIdx)
+    {
+        CHECK(hipMemcpy2DAsync(static_cast<char*>(dst) + col * dstPitch,
+                                dstPitch,
+                                static_cast<const char*>(src) + col * srcPitch,
+                                srcPitch,
+                                colBytes,
+                                std::min(chunkCols, nCols - col),
+                                kind,
+                                streams[chunkIdx % streams.size()]->GetHandle()));
+    }
+}
+
+#endif // TEST_TRANSFER_H
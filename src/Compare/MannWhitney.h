@@ -0,0 +1,170 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef MANN_WHITNEY_H
+#define MANN_WHITNEY_H
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Result of a Mann-Whitney U (Wilcoxon rank-sum) test.
+struct MannWhitneyResult
+{
+    // U statistic for the first sample set.
+    double u = 0;
+
+    // Two-sided p-value: the probability of a difference at least
+    // this large between the sets' distributions if they were the same.
+    double pValue = 1;
+};
+
+// Below this many samples in either set, the normal approximation
+// to U is poor, so we use U's exact distribution instead.
+constexpr size_t mannWhitneyMinApproxSamples = 9;
+
+// The smallest two-sided p-value the exact test can give for sets
+// of n1 and n2 samples: that of the sets not overlapping at all.
+// If it is not below the significance level, no difference between
+// sets this small can be significant.
+inline
+double
+MannWhitneyMinPValue(size_t n1, size_t n2)
+{
+    if( (n1 == 0) or (n2 == 0) )
+    {
+        return 1;
+    }
+    auto logChoose = std::lgamma(n1 + n2 + 1.0) - std::lgamma(n1 + 1.0) - std::lgamma(n2 + 1.0);
+    return std::min(1.0, 2 * std::exp(-logChoose));
+}
+
+// Two-sided p-value of U from its exact distribution for sets of
+// n1 and n2 samples without ties.  The number of orderings of the
+// sets with each U is a coefficient of the Gaussian binomial
+// coefficient, the product over i = 1..m of
+// (1 - q^(M+i)) / (1 - q^i), with m = min(n1, n2) and M = max(n1, n2).
+// With ties, U may be a half-integer; it is rounded toward the
+// middle of the distribution, which errs on the side of no difference.
+inline
+double
+MannWhitneyExactPValue(double u, size_t n1, size_t n2)
+{
+    auto m = std::min(n1, n2);
+    auto bigM = std::max(n1, n2);
+    std::vector<double> counts(m * bigM + m + 1, 0.0);
+    counts[0] = 1;
+    size_t degree = 0;
+    for(size_t i = 1; i <= m; ++i)
+    {
+        // Multiply by (1 - q^(M+i)), then divide by (1 - q^i).
+        degree += bigM + i;
+        for(auto d = degree; d >= bigM + i; --d)
+        {
+            counts[d] -= counts[d - bigM - i];
+        }
+        for(auto d = i; d <= degree - i; ++d)
+        {
+            counts[d] += counts[d - i];
+        }
+
+        // The quotient is exact, so its terms above its degree vanish.
+        std::fill(counts.begin() + (degree - i + 1), counts.begin() + (degree + 1), 0.0);
+        degree -= i;
+    }
+
+    double total = 0;
+    for(size_t d = 0; d <= m * bigM; ++d)
+    {
+        total += counts[d];
+    }
+    double atMost = 0;
+    double atLeast = 0;
+    for(size_t d = 0; d <= m * bigM; ++d)
+    {
+        if(d <= std::ceil(u))
+        {
+            atMost += counts[d];
+        }
+        if(d >= std::floor(u))
+        {
+            atLeast += counts[d];
+        }
+    }
+    return std::min(1.0, 2 * std::min(atMost, atLeast) / total);
+}
+
+// Test whether two sets of samples (e.g., timings) come from
+// different distributions, without assuming they are normal, which
+// timings rarely are.  Uses the normal approximation to U with
+// corrections for ties and continuity, which is reasonable for
+// more than about eight samples per set, and U's exact distribution
+// for smaller sets.
+inline
+MannWhitneyResult
+MannWhitneyU(const std::vector<double>& x, const std::vector<double>& y)
+{
+    MannWhitneyResult result;
+    auto n1 = static_cast<double>(x.size());
+    auto n2 = static_cast<double>(y.size());
+    if( x.empty() or y.empty() )
+    {
+        return result;
+    }
+
+    // Rank the pooled samples, giving tied samples their mean rank.
+    std::vector<std::pair<double, int>> pooled;
+    for(auto v : x)
+    {
+        pooled.emplace_back(v, 0);
+    }
+    for(auto v : y)
+    {
+        pooled.emplace_back(v, 1);
+    }
+    std::sort(pooled.begin(), pooled.end());
+
+    double rankSumX = 0;
+    double tieSum = 0;
+    for(size_t i = 0; i < pooled.size(); )
+    {
+        auto j = i;
+        while( (j < pooled.size()) and (pooled[j].first == pooled[i].first) )
+        {
+            ++j;
+        }
+        auto nTied = static_cast<double>(j - i);
+        auto meanRank = (i + 1 + j) / 2.0;
+        for(auto t = i; t < j; ++t)
+        {
+            if(pooled[t].second == 0)
+            {
+                rankSumX += meanRank;
+            }
+        }
+        tieSum += nTied * nTied * nTied - nTied;
+        i = j;
+    }
+
+    auto n = n1 + n2;
+    result.u = rankSumX - n1 * (n1 + 1) / 2;
+    if( (x.size() < mannWhitneyMinApproxSamples) or (y.size() < mannWhitneyMinApproxSamples) )
+    {
+        result.pValue = MannWhitneyExactPValue(result.u, x.size(), y.size());
+        return result;
+    }
+
+    auto mean = n1 * n2 / 2;
+    auto variance = n1 * n2 / 12 * ((n + 1) - tieSum / (n * (n - 1)));
+    if(variance <= 0)
+    {
+        return result;
+    }
+
+    auto diff = std::max(std::fabs(result.u - mean) - 0.5, 0.0);
+    auto z = diff / std::sqrt(variance);
+    result.pValue = std::erfc(z / std::sqrt(2.0));
+    return result;
+}
+
+#endif // MANN_WHITNEY_H
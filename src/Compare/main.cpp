@@ -0,0 +1,304 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+//
+// Compare two sets of results written with --json (e.g., from two
+// library versions), matching results by configuration, and flag
+// significant slowdowns.  A result is a regression if its median
+// time grew by more than the threshold and the timing samples
+// differ significantly by a Mann-Whitney U test, so that ordinary
+// run-to-run noise is not reported.  Results that passed verification
+// in the baseline and fail in the candidate are also regressions.
+// Results in one file with the same configuration are merged.
+// Changes past the threshold that can't be tested, for want of
+// samples or of enough of them to be significant at the level given,
+// are reported as slower_untested or faster_untested, and are not
+// regressions.  Exits with 1 if there are any regressions.
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "boost/program_options.hpp"
+#include "boost/property_tree/json_parser.hpp"
+#include "boost/property_tree/ptree.hpp"
+#include "MannWhitney.h"
+#include "TimingStats.h"
+namespace bpo = boost::program_options;
+namespace bpt = boost::property_tree;
+
+// One result, as read from a results file.
+struct StoredResult
+{
+    std::string config;
+    std::vector<double> samplesMs;
+    double timeMs = 0;
+    bool passed = true;
+};
+
+// A results file's environment and results, keyed by configuration.
+struct ResultSet
+{
+    std::map<std::string, std::string> environment;
+    std::map<std::string, StoredResult> results;
+};
+
+// Metrics that are the time of a result, in order of preference,
+// for results without timing samples.  Results with samples are
+// timed by their median, as TimingStats computes it for median_ms.
+const std::vector<std::string> timeMetrics{ "median_ms", "pipelined_ms", "time_to_first_gemm_ms" };
+
+ResultSet
+LoadResults(const std::string& path)
+{
+    bpt::ptree tree;
+    bpt::read_json(path, tree);
+
+    ResultSet ret;
+    for(const auto& entry : tree.get_child("environment"))
+    {
+        ret.environment[entry.first] = entry.second.data();
+    }
+    auto program = tree.get<std::string>("environment.program", "");
+    size_t nDuplicates = 0;
+
+    for(const auto& entry : tree.get_child("results"))
+    {
+        const auto& record = entry.second;
+
+        // The configuration, in a canonical order, identifies the result.
+        std::vector<std::string> fields;
+        for(const auto& field : record.get_child("config"))
+        {
+            fields.push_back(field.first + '=' + field.second.data());
+        }
+        std::sort(fields.begin(), fields.end());
+
+        StoredResult result;
+        result.config = program;
+        for(const auto& field : fields)
+        {
+            result.config += ' ' + field;
+        }
+
+        for(const auto& sample : record.get_child("samples_ms"))
+        {
+            result.samplesMs.push_back(sample.second.get_value<double>());
+        }
+        if(not result.samplesMs.empty())
+        {
+            result.timeMs = TimingStats(result.samplesMs).medianMs;
+        }
+        else
+        {
+            for(const auto& name : timeMetrics)
+            {
+                auto val = record.get_optional<double>("metrics." + name);
+                if(val)
+                {
+                    result.timeMs = *val;
+                    break;
+                }
+            }
+        }
+        result.passed = (record.get<std::string>("status") == "PASS");
+
+        // A configuration can be run more than once (e.g., a size listed
+        // twice).  Treat its runs as one result with all their samples,
+        // which passed only if all of them did.
+        auto [iter, inserted] = ret.results.emplace(result.config, result);
+        if(not inserted)
+        {
+            auto& merged = iter->second;
+            merged.samplesMs.insert(merged.samplesMs.end(), result.samplesMs.begin(), result.samplesMs.end());
+            if(not merged.samplesMs.empty())
+            {
+                merged.timeMs = TimingStats(merged.samplesMs).medianMs;
+            }
+            merged.passed = merged.passed and result.passed;
+            ++nDuplicates;
+        }
+    }
+    if(nDuplicates > 0)
+    {
+        std::cerr << "note: merged " << nDuplicates << " repeated result(s) in " << path
+            << " into earlier ones with the same configuration" << std::endl;
+    }
+    return ret;
+}
+
+std::tuple<bool, int, std::string, std::string, double, double>
+ParseCommandLine(int argc, char* argv[])
+{
+    int ret = 0;
+    bool shouldRun = true;
+
+    bpo::options_description desc("Compare ExtTest results files.\nSupported options");
+    desc.add_options()
+        ("help,h", "show this help message")
+        ("baseline", bpo::value<std::string>(), "Results file to compare against")
+        ("candidate", bpo::value<std::string>(), "Results file to check for regressions")
+        ("threshold", bpo::value<double>()->default_value(5), "Smallest change in median time, in percent, that counts")
+        ("alpha", bpo::value<double>()->default_value(0.01), "Significance level for the Mann-Whitney U test")
+    ;
+    bpo::positional_options_description positional;
+    positional.add("baseline", 1).add("candidate", 1);
+
+    bpo::variables_map opts;
+    bpo::store(bpo::command_line_parser(argc, argv).options(desc).positional(positional).run(), opts);
+    bpo::notify(opts);
+
+    if(opts.count("help") > 0)
+    {
+        std::cout << "usage: " << argv[0] << " [options] baseline.json candidate.json\n"
+            << desc << std::endl;
+        shouldRun = false;
+    }
+    else if( (opts.count("baseline") == 0) or (opts.count("candidate") == 0) )
+    {
+        std::cerr << "need baseline and candidate results files" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    auto threshold = opts["threshold"].as<double>();
+    auto alpha = opts["alpha"].as<double>();
+    if( (threshold < 0) or (alpha <= 0) or (alpha >= 1) )
+    {
+        std::cerr << "threshold must be >=0 and alpha must be in (0, 1)" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    return std::make_tuple(shouldRun,
+                            ret,
+                            shouldRun ? opts["baseline"].as<std::string>() : "",
+                            shouldRun ? opts["candidate"].as<std::string>() : "",
+                            threshold,
+                            alpha);
+}
+
+int
+main(int argc, char* argv[])
+{
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::string baselinePath;
+        std::string candidatePath;
+        double threshold;
+        double alpha;
+        std::tie(shouldRun, ret, baselinePath, candidatePath, threshold, alpha) = ParseCommandLine(argc, argv);
+
+        if(shouldRun)
+        {
+            auto baseline = LoadResults(baselinePath);
+            auto candidate = LoadResults(candidatePath);
+
+            // Differences in environment explain differences in results.
+            for(const auto& entry : candidate.environment)
+            {
+                auto iter = baseline.environment.find(entry.first);
+                auto baseVal = (iter != baseline.environment.end()) ? iter->second : "";
+                if( (baseVal != entry.second) and (entry.first != "timestamp") )
+                {
+                    std::cout << "# " << entry.first << ": " << baseVal << " -> " << entry.second << '\n';
+                }
+            }
+
+            std::cout << "config,base_ms,new_ms,change_pct,p_value,verdict" << std::endl;
+            size_t nRegressions = 0;
+            size_t nUntested = 0;
+            for(const auto& entry : candidate.results)
+            {
+                const auto& result = entry.second;
+                auto iter = baseline.results.find(entry.first);
+                if(iter == baseline.results.end())
+                {
+                    std::cout << '"' << entry.first << "\",," << result.timeMs << ",,,new" << std::endl;
+                    continue;
+                }
+                const auto& base = iter->second;
+
+                auto changePct = (base.timeMs > 0) ? (100.0 * (result.timeMs - base.timeMs) / base.timeMs) : 0.0;
+                auto test = MannWhitneyU(base.samplesMs, result.samplesMs);
+                auto hasSamples = not (base.samplesMs.empty() or result.samplesMs.empty());
+                auto canTest = hasSamples
+                    and (MannWhitneyMinPValue(base.samplesMs.size(), result.samplesMs.size()) < alpha);
+
+                // Without enough samples, we can't tell a change from
+                // noise, so we report large changes without judging them.
+                std::string verdict = "same";
+                if(base.passed and not result.passed)
+                {
+                    verdict = "fail";
+                }
+                else if(std::fabs(changePct) > threshold)
+                {
+                    if(not canTest)
+                    {
+                        verdict = (changePct > 0) ? "slower_untested" : "faster_untested";
+                    }
+                    else if(test.pValue < alpha)
+                    {
+                        verdict = (changePct > 0) ? "regression" : "improvement";
+                    }
+                    else
+                    {
+                        verdict = "noise";
+                    }
+                }
+                if( (verdict == "fail") or (verdict == "regression") )
+                {
+                    ++nRegressions;
+                }
+                else if(verdict == "slower_untested")
+                {
+                    ++nUntested;
+                }
+
+                std::cout << '"' << entry.first << '"'
+                    << ',' << base.timeMs
+                    << ',' << result.timeMs
+                    << ',' << changePct
+                    << ',';
+                if(hasSamples)
+                {
+                    std::cout << test.pValue;
+                }
+                std::cout << ',' << verdict << std::endl;
+            }
+            for(const auto& entry : baseline.results)
+            {
+                if(candidate.results.count(entry.first) == 0)
+                {
+                    std::cout << '"' << entry.first << "\"," << entry.second.timeMs << ",,,,missing" << std::endl;
+                }
+            }
+
+            std::cout << "# " << nRegressions << " regressions";
+            if(nUntested > 0)
+            {
+                std::cout << ", " << nUntested << " slower results with too few samples to test (not counted)";
+            }
+            std::cout << std::endl;
+            ret = (nRegressions > 0) ? 1 : 0;
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}
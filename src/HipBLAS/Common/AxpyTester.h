@@ -0,0 +1,158 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef AXPY_TESTER_H
+#define AXPY_TESTER_H
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "HipStream.h"
+#include "Matrix.h"
+#include "MatrixChecker.h"
+#include "GemmInputs.h"
+#include "Trace.h"
+
+// Tests y = alpha * x + y, with x and y vectors of length n.
+// Vectors are n x 1 matrices.
+class AxpyTester
+{
+protected:
+    Matrix<float> x;
+    Matrix<float> y;
+
+    float alpha;
+
+    const HipStream& hipStream;
+
+    // How the inputs are filled, and the initial value of y.
+    InitOptions init;
+    std::vector<float> initialY;
+
+    // Fill x and y with small integers, so that the result
+    // is exact for alpha with few significant bits (like 0.5):
+    // x[i] = (i % 7) - 3 and y[i] = (i % 5) - 2.
+    void FillPatternInputs(void)
+    {
+        for(auto i = 0; i < GetLength(); ++i)
+        {
+            x.El(i, 0) = static_cast<float>((i % 7) - 3);
+            y.El(i, 0) = static_cast<float>((i % 5) - 2);
+        }
+    }
+
+    // Fill the vectors and copy them to the device.
+    void InitVectors(void)
+    {
+        TraceSpan span("InitVectors", "init");
+
+        if(init.random)
+        {
+            std::mt19937 genX(init.seed);
+            std::mt19937 genY(init.seed + 1);
+            FillRandom(x, genX);
+            FillRandom(y, genY);
+        }
+        else
+        {
+            FillPatternInputs();
+        }
+
+        // Reading back the result overwrites the host copy of y.
+        initialY.assign(y.GetHostData(), y.GetHostData() + y.GetNumStoredItems());
+
+        x.CopyHostToDeviceAsync(hipStream);
+        y.CopyHostToDeviceAsync(hipStream);
+    }
+
+public:
+    AxpyTester(int n,
+                float _alpha,
+                const HipStream& _hipStream,
+                const InitOptions& _init = InitOptions())
+      : x(n, 1),
+        y(n, 1),
+        alpha(_alpha),
+        hipStream(_hipStream),
+        init(_init)
+    {
+        InitVectors();
+    }
+
+    virtual ~AxpyTester(void)
+    {
+        // nothing to do.
+    }
+
+    void DumpTo(std::ostream& os) const
+    {
+        os << "alpha: " << alpha
+            << "\nx: " << x
+            << "\ny: " << y
+            << std::endl;
+    }
+
+    // Enqueue the axpy on our stream, without waiting for it
+    // to complete or reading its result back to the host.
+    virtual void Enqueue(void) = 0;
+
+    // Do the axpy and read its result back to the host.
+    void Do(void)
+    {
+        Enqueue();
+        y.CopyDeviceToHostAsync(hipStream);
+        hipStream.Synchronize();
+    }
+
+    // Restore y on the device to its initial value, in case
+    // repeated calls have overwritten it.
+    void ResetOutput(void)
+    {
+        std::copy(initialY.begin(), initialY.end(), y.GetHostData());
+        y.CopyHostToDeviceAsync(hipStream);
+    }
+
+    int GetLength(void) const   { return x.GetNumRows(); }
+
+    // Number of floating point operations done by one call.
+    double GetFlopCount(void) const     { return 2.0 * GetLength(); }
+
+    // Number of bytes one call must move to or from device
+    // memory: x and y are read, and y is written.
+    double GetBytesMoved(void) const    { return 3.0 * GetLength() * sizeof(float); }
+
+    // Compare y against alpha * x + y computed on the host.
+    // With pattern inputs and a suitable alpha, the result is exact.
+    // Unless quiet, describe the outcome on standard output.
+    CheckResult CheckComputation(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
+    {
+        TraceSpan span("CheckComputation", "check");
+
+        auto fillExpected = [this](int, float* expected) {
+            for(auto i = 0; i < GetLength(); ++i)
+            {
+                expected[i] = alpha * x.El(i, 0) + initialY[i];
+            }
+        };
+        // One rounding of a product and one of a sum.
+        auto result = CheckMatrix(y,
+                                    fillExpected,
+                                    init.random ? WithRandomInputTolerance<float>(opts, 1, alpha, 1) : opts);
+        if(not quiet)
+        {
+            ReportCheck(std::cout, result);
+        }
+        return result;
+    }
+};
+
+inline
+std::ostream&
+operator<<(std::ostream& os, const AxpyTester& tester)
+{
+    tester.DumpTo(os);
+    return os;
+}
+
+#endif // AXPY_TESTER_H
@@ -0,0 +1,252 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef BATCHED_SGEMM_TESTER_H
+#define BATCHED_SGEMM_TESTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "HipStream.h"
+#include "BatchedMatrix.h"
+#include "MatrixChecker.h"
+#include "GemmInputs.h"
+#include "ReferenceGemm.h"
+#include "Trace.h"
+
+// Like SgemmTester, but for a batch of independent GEMMs
+// of the same shape: C[b] = alpha * A[b] * op(B[b]) + beta * C[b].
+template<bool Transpose = false>
+class BatchedSgemmTester
+{
+protected:
+    BatchedMatrix<float> A;
+    BatchedMatrix<float> B;
+    BatchedMatrix<float> C;
+
+    float alpha;
+    float beta;
+
+    const HipStream& hipStream;
+
+    // How the inputs are filled, and the initial value of C.
+    InitOptions init;
+    std::vector<float> initialC;
+
+    // Fill the input matrices with a pattern whose result is known.
+    // As for SgemmTester, but column 0 of A[b] is all b+1, so
+    // that a GEMM using the wrong matrix from the batch is caught.
+    // After the GEMMs, C[b][r,c] should be alpha * (b+1) + beta * r * c
+    void FillPatternInputs(void)
+    {
+        for(auto b = 0; b < A.GetBatchCount(); ++b)
+        {
+            for(auto r = 0; r < A.GetNumRows(); ++r)
+            {
+                A.El(b, r, 0) = b + 1;
+            }
+
+            auto nLogicalCols = Transpose ? B.GetNumRows() : B.GetNumMatrixCols();
+            for(auto c = 0; c < nLogicalCols; ++c)
+            {
+                if(Transpose)
+                {
+                    B.El(b, c, 0) = 1;
+                }
+                else
+                {
+                    B.El(b, 0, c) = 1;
+                }
+            }
+
+            for(auto c = 0; c < C.GetNumMatrixCols(); ++c)
+            {
+                for(auto r = 0; r < C.GetNumRows(); ++r)
+                {
+                    C.El(b, r, c) = static_cast<int64_t>(r) * c;
+                }
+            }
+        }
+    }
+
+    // Fill A, B, and C with random values in [-1, 1].
+    void FillRandomInputs(void)
+    {
+        std::mt19937 genA(init.seed);
+        std::mt19937 genB(init.seed + 1);
+        std::mt19937 genC(init.seed + 2);
+        FillRandom(A, genA);
+        FillRandom(B, genB);
+        FillRandom(C, genC);
+    }
+
+    // Fill the input matrices and copy them to the device.
+    void InitMatrices(void)
+    {
+        TraceSpan span("InitMatrices", "init");
+
+        if(init.lean)
+        {
+            throw std::invalid_argument("lean mode is supported only by the SGEMM tester");
+        }
+
+        if(init.random)
+        {
+            FillRandomInputs();
+        }
+        else
+        {
+            FillPatternInputs();
+        }
+        initialC.assign(C.GetHostData(), C.GetHostData() + C.GetNumStoredItems());
+
+        A.CopyHostToDeviceAsync(hipStream);
+        B.CopyHostToDeviceAsync(hipStream);
+        C.CopyHostToDeviceAsync(hipStream);
+    }
+
+public:
+    BatchedSgemmTester(int m,
+                        int n,
+                        int k,
+                        int nBatch,
+                        float _alpha,
+                        float _beta,
+                        const HipStream& _hipStream,
+                        const InitOptions& _init = InitOptions())
+      : A(m, k, nBatch, _init.layout),
+        B( Transpose ? n : k, Transpose ? k : n, nBatch, _init.layout ),
+        C(m, n, nBatch, _init.layout),
+        alpha(_alpha),
+        beta(_beta),
+        hipStream(_hipStream),
+        init(_init)
+    {
+        InitMatrices();
+    }
+
+    virtual ~BatchedSgemmTester(void)
+    {
+        // nothing to do.
+    }
+
+    void DumpTo(std::ostream& os) const
+    {
+        os << "alpha: " << alpha
+            << "\nbeta: " << beta
+            << "\nbatch count: " << A.GetBatchCount()
+            << "\nA: " << A
+            << "\nB: " << B
+            << "\nC: " << C
+            << std::endl;
+    }
+
+    // Enqueue the batch of GEMMs on our stream, without waiting for
+    // them to complete or reading their results back to the host.
+    virtual void EnqueueSgemm(void) = 0;
+
+    // Do the batch of GEMMs and read the results back to the host.
+    void DoSgemm(void)
+    {
+        EnqueueSgemm();
+        C.CopyDeviceToHostAsync(hipStream);
+        hipStream.Synchronize();
+    }
+
+    // Restore C on the device to its initial value, in case
+    // repeated GEMMs have overwritten it.
+    void ResetOutput(void)
+    {
+        std::copy(initialC.begin(), initialC.end(), C.GetHostData());
+        C.CopyHostToDeviceAsync(hipStream);
+    }
+
+    int GetBatchCount(void) const   { return A.GetBatchCount(); }
+
+    // Leading dimensions of the stored matrices.
+    int GetLda(void) const  { return A.GetLeadingDim(); }
+    int GetLdb(void) const  { return B.GetLeadingDim(); }
+    int GetLdc(void) const  { return C.GetLeadingDim(); }
+
+    // Number of floating point operations done by one batch.
+    double GetFlopCount(void) const
+    {
+        return 2.0 * A.GetNumRows() * C.GetNumMatrixCols() * A.GetNumMatrixCols() * A.GetBatchCount();
+    }
+
+    // Compare the GEMMs' output against the expected values:
+    // C[b][r,c] = alpha * (b+1) + beta * r * c for the pattern inputs,
+    // or the result of a host reference GEMM for random inputs.
+    // Unless quiet, describe the outcome on standard output.
+    // Mismatch columns are columns of the whole batch, so
+    // column c is column c % n of matrix c / n.
+    CheckResult CheckComputation(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
+    {
+        TraceSpan span("CheckComputation", "check");
+
+        auto m = C.GetNumRows();
+        auto n = C.GetNumMatrixCols();
+        auto k = A.GetNumMatrixCols();
+
+        CheckResult result;
+        if(init.random)
+        {
+            std::vector<float> expectedC(initialC);
+            for(auto b = 0; b < C.GetBatchCount(); ++b)
+            {
+                ReferenceGemm<float, float>(false,
+                                            Transpose,
+                                            m,
+                                            n,
+                                            k,
+                                            alpha,
+                                            A.GetHostMatrix(b),
+                                            A.GetLeadingDim(),
+                                            B.GetHostMatrix(b),
+                                            B.GetLeadingDim(),
+                                            beta,
+                                            &expectedC[b * C.GetStride()],
+                                            C.GetLeadingDim(),
+                                            opts.nThreads);
+            }
+
+            auto ldc = C.GetLeadingDim();
+            auto fillExpected = [m, ldc, &expectedC](int c, float* expected) {
+                std::copy_n(&expectedC[static_cast<size_t>(c) * ldc], m, expected);
+            };
+            result = CheckMatrix(C,
+                                    fillExpected,
+                                    WithRandomInputTolerance<float>(opts, k, alpha, beta));
+        }
+        else
+        {
+            auto fillExpected = [this, m, n](int c, float* expected) {
+                auto b = c / n;
+                auto col = c % n;
+                for(auto r = 0; r < m; ++r)
+                {
+                    expected[r] = alpha * (b + 1) + beta * static_cast<float>(static_cast<int64_t>(r) * col);
+                }
+            };
+            result = CheckMatrix(C, fillExpected, opts);
+        }
+        if(not quiet)
+        {
+            ReportCheck(std::cout, result);
+        }
+        return result;
+    }
+};
+
+template<bool Transpose>
+std::ostream&
+operator<<(std::ostream& os, const BatchedSgemmTester<Transpose>& tester)
+{
+    tester.DumpTo(os);
+    return os;
+}
+
+#endif // BATCHED_SGEMM_TESTER_H
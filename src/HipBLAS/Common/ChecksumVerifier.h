@@ -0,0 +1,293 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef CHECKSUM_VERIFIER_H
+#define CHECKSUM_VERIFIER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "Matrix.h"
+#include "GemmInputs.h"
+
+// The outcome of checking a GEMM's output checksums.
+struct ChecksumResult
+{
+    // Rows and columns of the output whose sums are out of tolerance.
+    // An element that went wrong on its own shows up as one bad
+    // row and one bad column, which locates it.
+    std::vector<int> badRows;
+    std::vector<int> badCols;
+
+    // The checksum with the largest (non-NaN) error, and its tolerance.
+    double maxErr = 0;
+    double maxErrTol = 0;
+    bool maxErrInRow = false;
+    int maxErrAt = 0;
+
+    bool Passed(void) const { return badRows.empty() and badCols.empty(); }
+};
+
+// Algorithm-based fault tolerance (ABFT) check of a GEMM
+//   D = alpha * op(A) * op(B) + beta * C
+// with column major storage, op(A) m x k, op(B) k x n, and C, D m x n.
+// Rather than computing D, we compare its row and column sums
+// against ones predicted from sums of the inputs:
+//   colsum(D) = alpha * (colsum(op(A)) * op(B)) + beta * colsum(C)
+//   rowsum(D) = alpha * (op(A) * rowsum(op(B))) + beta * rowsum(C)
+// which costs O(mk + kn) once per A and B, and O(mn) per output,
+// instead of O(mnk).
+//
+// Each sum's tolerance is a probabilistic bound on rounding error
+// (see Higham and Mary, "A New Approach to Probabilistic Rounding
+// Error Analysis", 2019).  Rounding errors in a length k dot product
+// in ComputeType grow like sqrt(k) * eps times the root-sum-square of
+// its products, and errors in different elements are independent,
+// so those of a row or column sum add in root-sum-square too.
+// Rounding to OutType adds eps for OutType times the root-sum-square
+// of the elements.  Bounds in terms of sums of absolute values grow
+// with the number of terms, not its square root, and are so loose for
+// large k that they hide errors in whole elements.
+template<typename OutType, typename ComputeType = float>
+class ChecksumVerifier
+{
+private:
+    // Confidence parameter for the rounding error bound.  The chance
+    // that a correct dot product's error exceeds the bound is less
+    // than 2 * exp(-lambda^2 / 2), about 1e-5 for lambda = 5.
+    static constexpr double lambda = 5;
+
+    int m;
+    int n;
+    double beta;
+
+    // Rounding error allowed per unit of root-sum-square,
+    // for the dot products and for rounding to OutType.
+    double dotTolScale;
+    double outTolScale;
+
+    // Sums of alpha * op(A) * op(B), down its columns and across
+    // its rows, and sums of the squares of the products
+    // alpha * op(A)[i, p] * op(B)[p, j] that make them up.
+    std::vector<double> abColSums;
+    std::vector<double> abSqColSums;
+    std::vector<double> abRowSums;
+    std::vector<double> abSqRowSums;
+
+    // Sums of the input C, and of its squares.
+    std::vector<double> cColSums;
+    std::vector<double> cSqColSums;
+    std::vector<double> cRowSums;
+    std::vector<double> cSqRowSums;
+
+    // Call f(i, j, x) for each element x = op(X)[i, j],
+    // visiting them in storage order.
+    template<typename T, typename F>
+    static void ForEachElement(bool trans, int nOpRows, int nOpCols, const T* X, size_t ldx, F f)
+    {
+        auto nStoredRows = trans ? nOpCols : nOpRows;
+        auto nStoredCols = trans ? nOpRows : nOpCols;
+        for(auto sc = 0; sc < nStoredCols; ++sc)
+        {
+            auto col = &X[static_cast<size_t>(sc) * ldx];
+            for(auto sr = 0; sr < nStoredRows; ++sr)
+            {
+                auto x = static_cast<double>(ToFloat(col[sr]));
+                if(trans)
+                {
+                    f(sc, sr, x);
+                }
+                else
+                {
+                    f(sr, sc, x);
+                }
+            }
+        }
+    }
+
+    // Row and column sums of an m x n matrix, and of its squares.
+    void SumMatrix(const OutType* X,
+                    size_t ldx,
+                    std::vector<double>& colSums,
+                    std::vector<double>& sqColSums,
+                    std::vector<double>& rowSums,
+                    std::vector<double>& sqRowSums) const
+    {
+        colSums.assign(n, 0);
+        sqColSums.assign(n, 0);
+        rowSums.assign(m, 0);
+        sqRowSums.assign(m, 0);
+        for(auto j = 0; j < n; ++j)
+        {
+            auto col = &X[static_cast<size_t>(j) * ldx];
+            double sum = 0;
+            double sqSum = 0;
+            for(auto i = 0; i < m; ++i)
+            {
+                auto x = static_cast<double>(ToFloat(col[i]));
+                sum += x;
+                sqSum += x * x;
+                rowSums[i] += x;
+                sqRowSums[i] += x * x;
+            }
+            colSums[j] = sum;
+            sqColSums[j] = sqSum;
+        }
+    }
+
+public:
+    template<typename InType>
+    ChecksumVerifier(bool transA,
+                        bool transB,
+                        int _m,
+                        int _n,
+                        int k,
+                        double alpha,
+                        const InType* A,
+                        size_t lda,
+                        const InType* B,
+                        size_t ldb,
+                        double _beta)
+      : m(_m),
+        n(_n),
+        beta(_beta),
+        dotTolScale(lambda * std::sqrt(static_cast<double>(k)) * Epsilon<ComputeType>()),
+        outTolScale(lambda * 2 * Epsilon<OutType>()),
+        abColSums(_n, 0),
+        abSqColSums(_n, 0),
+        abRowSums(_m, 0),
+        abSqRowSums(_m, 0),
+        cColSums(_n, 0),
+        cSqColSums(_n, 0),
+        cRowSums(_m, 0),
+        cSqRowSums(_m, 0)
+    {
+        // Column sums of op(A) and row sums of op(B), length k,
+        // and the same of their squares.
+        std::vector<double> aColSums(k, 0);
+        std::vector<double> aSqColSums(k, 0);
+        ForEachElement(transA, m, k, A, lda, [&](int, int p, double x) {
+            aColSums[p] += x;
+            aSqColSums[p] += x * x;
+        });
+        std::vector<double> bRowSums(k, 0);
+        std::vector<double> bSqRowSums(k, 0);
+        ForEachElement(transB, k, n, B, ldb, [&](int p, int, double x) {
+            bRowSums[p] += x;
+            bSqRowSums[p] += x * x;
+        });
+
+        // Push them through the other operand.  The sum of squares of
+        // the products in column j is sum_p aSqColSums[p] * op(B)[p, j]^2.
+        ForEachElement(transB, k, n, B, ldb, [&](int p, int j, double x) {
+            abColSums[j] += aColSums[p] * x;
+            abSqColSums[j] += aSqColSums[p] * x * x;
+        });
+        ForEachElement(transA, m, k, A, lda, [&](int i, int p, double x) {
+            abRowSums[i] += x * bRowSums[p];
+            abSqRowSums[i] += x * x * bSqRowSums[p];
+        });
+
+        auto scale = [](std::vector<double>& v, double s) {
+            std::transform(v.begin(), v.end(), v.begin(), [s](double x){ return s * x; });
+        };
+        scale(abColSums, alpha);
+        scale(abSqColSums, alpha * alpha);
+        scale(abRowSums, alpha);
+        scale(abSqRowSums, alpha * alpha);
+    }
+
+    // Take the sums of the GEMM's input C.
+    // As in BLAS, C is not read if beta is zero.
+    void SetInput(const OutType* C, size_t ldc)
+    {
+        if(beta != 0)
+        {
+            SumMatrix(C, ldc, cColSums, cSqColSums, cRowSums, cSqRowSums);
+        }
+    }
+
+    // Compare the sums of the GEMM's output D against
+    // those predicted from its inputs.
+    ChecksumResult Check(const OutType* D, size_t ldd) const
+    {
+        std::vector<double> dColSums;
+        std::vector<double> dSqColSums;
+        std::vector<double> dRowSums;
+        std::vector<double> dSqRowSums;
+        SumMatrix(D, ldd, dColSums, dSqColSums, dRowSums, dSqRowSums);
+
+        ChecksumResult result;
+        auto compare = [this, &result](bool isRow,
+                                        int idx,
+                                        double computed,
+                                        double expected,
+                                        double productSqSum,
+                                        double outSqSum,
+                                        std::vector<int>& bad) {
+            auto err = std::fabs(computed - expected);
+            auto tol = dotTolScale * std::sqrt(productSqSum) + outTolScale * std::sqrt(outSqSum);
+            if(not (err <= tol))   // NaN counts as bad
+            {
+                bad.push_back(idx);
+            }
+            if(err > result.maxErr)
+            {
+                result.maxErr = err;
+                result.maxErrTol = tol;
+                result.maxErrInRow = isRow;
+                result.maxErrAt = idx;
+            }
+        };
+        for(auto j = 0; j < n; ++j)
+        {
+            compare(false,
+                    j,
+                    dColSums[j],
+                    abColSums[j] + beta * cColSums[j],
+                    abSqColSums[j] + beta * beta * cSqColSums[j],
+                    dSqColSums[j],
+                    result.badCols);
+        }
+        for(auto i = 0; i < m; ++i)
+        {
+            compare(true,
+                    i,
+                    dRowSums[i],
+                    abRowSums[i] + beta * cRowSums[i],
+                    abSqRowSums[i] + beta * beta * cSqRowSums[i],
+                    dSqRowSums[i],
+                    result.badRows);
+        }
+        return result;
+    }
+};
+
+// Describe a checksum check's outcome, listing at most
+// maxReported of the bad rows and columns.
+inline
+void
+ReportChecksums(std::ostream& os, const ChecksumResult& result, size_t maxReported)
+{
+    auto listSome = [&os, maxReported](const char* what, const std::vector<int>& idxs) {
+        os << "Checksum mismatches in " << what << ": " << idxs.size();
+        for(size_t i = 0; i < std::min(maxReported, idxs.size()); ++i)
+        {
+            os << ((i == 0) ? " (" : ", ") << idxs[i];
+        }
+        if(idxs.size() > maxReported)
+        {
+            os << ", ...";
+        }
+        os << ((std::min(maxReported, idxs.size()) > 0) ? ")\n" : "\n");
+    };
+    listSome("rows", result.badRows);
+    listSome("columns", result.badCols);
+    os << "Max checksum error: " << result.maxErr
+        << " (tolerance " << result.maxErrTol << ")"
+        << " in " << (result.maxErrInRow ? "row " : "column ") << result.maxErrAt
+        << std::endl;
+}
+
+#endif // CHECKSUM_VERIFIER_H
@@ -3,28 +3,293 @@
 #ifndef TEST_COMMAND_LINE_H
 #define TEST_COMMAND_LINE_H
 
+#include <algorithm>
+#include <limits>
+#include <string>
 #include <tuple>
+#include <vector>
 
 #include "boost/program_options.hpp"
+#include "hipblas.h"
+#include "src/Common/ExtTestConfig.h"
+#include "Benchmark.h"
+#include "GemmInputs.h"
+#include "GemmOp.h"
+#include "Matrix.h"
+#include "MatrixChecker.h"
+#include "ResultsWriter.h"
+#include "SizeList.h"
+#include "Trace.h"
 namespace bpo = boost::program_options;
 
+// Options that affect how a test runs,
+// as opposed to which problem it solves.
+struct RunOptions
+{
+    // Whether and how to time repeated operations.
+    BenchmarkOptions bench;
+
+    // Whether Matrix storage comes from the caching memory pools.
+    bool usePools = true;
+
+    // Largest host/device copy, in bytes.  Zero means no limit.
+    size_t transferChunkBytes = size_t(256) << 20;
+
+    // How to fill the input matrices.
+    InitOptions init;
+
+    // How to verify results.
+    CheckOptions check;
+
+    // Whether to verify results with checksums (see ChecksumVerifier)
+    // instead of comparing every element.
+    bool verifyChecksums = false;
+
+    // Number of GEMMs to run after verification, each on the previous
+    // one's output and each verified with checksums.
+    int nSoakIters = 0;
+
+    // Number of independent problems to run through the pipelined
+    // runner per shape (zero to not use it), and its number of streams.
+    int nPipelineProblems = 0;
+    int nStreams = 2;
+
+    // Device memory, in bytes, for GEMMs streamed through the device
+    // in tiles with A, B, and C kept on the host (see RunTiled),
+    // on nStreams streams (zero to not use the tiled runner).
+    size_t deviceBudgetBytes = 0;
+
+    // Number of GEMMs to capture into a HIP graph and replay, to compare
+    // per-GEMM latency against direct submission (zero to not), and
+    // whether the graph also holds the input and output copies.
+    int nGraphGemms = 0;
+    bool graphCopies = false;
+
+    // Length of the chains of dependent GEMMs to time with alpha and
+    // beta in host memory and in device memory (zero to not).
+    int nChainGemms = 0;
+
+    // Whether to profile startup (see ProfileStartup) instead of
+    // running the usual tests, and whether to pre-warm the library
+    // (see PrewarmHipblas) before running GEMMs.
+    bool profileStartup = false;
+    bool prewarm = false;
+
+    // Number of fresh processes to profile startup in, for each of
+    // cold and pre-warmed, since one process's times are noisy.
+    int nStartupRuns = 5;
+
+    // Most host threads to run GEMMs from at once, to measure how
+    // throughput scales with concurrent submission (zero to not).
+    int nHostThreads = 0;
+
+    // A trace of an application's GEMM calls to replay
+    // (see ReadGemmTrace) instead of the given shapes, or empty.
+    std::string replayPath;
+
+    // Batch counts to sweep, for the batched GEMM programs.
+    std::vector<int> batchCounts{ 1 };
+
+    // Leading dimension paddings to sweep.  The first is also the
+    // padding in init.layout, used by programs that don't sweep them.
+    std::vector<int> pads{ 0 };
+
+    // Ops for A and B to run, for the program that compares them.
+    std::vector<GemmOpPair> ops{ { GemmOp::N, GemmOp::N } };
+
+    // Matrix storage to run with, for the program that compares them.
+    std::vector<MatrixStorage> storages{ MatrixStorage::Pinned };
+
+    // Where to write a Chrome trace of the run's phases
+    // (see Tracer), or empty to not trace.
+    std::string tracePath;
+
+    // Where to write the results as JSON (see ResultsWriter),
+    // or empty to not write them.
+    std::string resultsPath;
+};
+
+// What a program is, for its help text, and which
+// of the options it takes.
+struct ProgramInfo
+{
+    // First line of the help text.
+    std::string description = "GEMM using hipBLAS over HIPLZ.";
+
+    // Whether the program runs GEMMs, and so takes the GEMM options,
+    // or is one of the memory-bound operations (see DoBandwidthMain).
+    bool runsGemms = true;
+
+    // Whether a memory-bound operation takes matrices, and so n
+    // and the matrix layout options, rather than only vectors.
+    bool hasMatrices = true;
+
+    // Whether the program can run GEMMs out of core (see RunTiled),
+    // and so takes a device budget.
+    bool runsTiled = false;
+
+    // Whether the program times GEMMs only when asked (with --bench)
+    // rather than always.
+    bool takesBench = false;
+
+    // Whether the program runs its shapes with RunShape, and so takes
+    // its ways of verifying, scalars, lean mode, soak, graph, and chain.
+    bool runsShapes = false;
+
+    // Whether the program has DoSgemmMain's other ways of running
+    // shapes: pipelined, from several threads, replayed from a trace,
+    // and profiled at startup.
+    bool runsModes = false;
+
+    // Whether the program compares batched ways of doing GEMMs,
+    // and so takes batch counts.
+    bool takesBatch = false;
+
+    // Whether the program compares ops for A and B, and so takes them.
+    bool takesOps = false;
+
+    // Whether the program compares kinds of Matrix storage,
+    // and so takes them.
+    bool takesStorage = false;
+
+    // Whether the program can use random inputs, rather than
+    // only the pattern whose result is known in closed form.
+    bool takesInit = true;
+
+    // Programs whose problems are best swept over other sizes
+    // can give their own defaults for m, n, and k.
+    std::string defaultM = "8";
+    std::string defaultN = "12";
+    std::string defaultK = "4";
+};
 
 template<typename ScalarType>
-std::tuple<bool, int, int, int, int, ScalarType, ScalarType, bool>
-ParseCommandLine(int argc, char* argv[])
+std::tuple<bool, int, std::vector<int>, std::vector<int>, std::vector<int>, ScalarType, ScalarType, bool, RunOptions>
+ParseCommandLine(int argc, char* argv[], const ProgramInfo& program)
 {
     int ret = 0;
     bool shouldRun = true;
+    const auto runsGemms = program.runsGemms;
+    const auto hasMatrices = runsGemms or program.hasMatrices;
 
-    bpo::options_description desc("GEMM using hipBLAS over HIPLZ.\nSupported options");
+    bpo::options_description desc(program.description + "\nSupported options");
+    desc.add_options()
+        ("help,h", "show this help message");
+    if(runsGemms)
+    {
+        desc.add_options()
+            ("nRowsA,m", bpo::value<std::string>()->default_value(program.defaultM), "Number of rows in A (value, list, or range like 64:8192:x2)")
+            ("nColsA,k", bpo::value<std::string>()->default_value(program.defaultK), "Number of columns in A (value, list, or range)")
+            ("nColsC,n", bpo::value<std::string>()->default_value(program.defaultN), "Number of columns in C (value, list, or range)")
+            ("alpha,a", bpo::value<ScalarType>()->default_value(0.5), "Scale for A*B")
+            ("beta,b", bpo::value<ScalarType>()->default_value(0.25), "Scale for C input");
+    }
+    else if(hasMatrices)
+    {
+        desc.add_options()
+            ("nRowsA,m", bpo::value<std::string>()->default_value(program.defaultM), "Number of rows in A (value, list, or range like 64:8192:x2)")
+            ("nColsC,n", bpo::value<std::string>()->default_value(program.defaultN), "Number of columns in A (value, list, or range)")
+            ("alpha,a", bpo::value<ScalarType>()->default_value(0.5), "Scale for A*x")
+            ("beta,b", bpo::value<ScalarType>()->default_value(0.25), "Scale for y input");
+    }
+    else
+    {
+        desc.add_options()
+            ("nRowsA,m", bpo::value<std::string>()->default_value(program.defaultM), "Vector length (value, list, or range like 64:8192:x2)")
+            ("alpha,a", bpo::value<ScalarType>()->default_value(0.5), "Scale for x, for operations that take one");
+    }
     desc.add_options()
-        ("help,h", "show this help message")
-        ("nRowsA,m", bpo::value<int>()->default_value(8), "Number of rows in A")
-        ("nColsA,k", bpo::value<int>()->default_value(4), "Number of columns in A")
-        ("nColsC,n", bpo::value<int>()->default_value(12), "Number of columns in C")
-        ("alpha,a", bpo::value<ScalarType>()->default_value(0.5), "Scale for A*B")
-        ("beta,b", bpo::value<ScalarType>()->default_value(0.25), "Scale for C input")
-        ("verbose,v", "Output debug information to standard output")
+        ("verbose,v", "Output debug information to standard output");
+    if(runsGemms and program.takesBench)
+    {
+        desc.add_options()
+            ("bench", "Time repeated GEMMs and report latency and GFLOP/s")
+            ("warmup", bpo::value<int>()->default_value(5), "Number of untimed GEMMs before timing (with --bench)")
+            ("iters", bpo::value<int>()->default_value(20), "Number of timed GEMMs (with --bench)");
+    }
+    else if(runsGemms)
+    {
+        desc.add_options()
+            ("warmup", bpo::value<int>()->default_value(5), "Number of untimed GEMMs before timing")
+            ("iters", bpo::value<int>()->default_value(20), "Number of timed GEMMs");
+    }
+    else
+    {
+        desc.add_options()
+            ("warmup", bpo::value<int>()->default_value(5), "Number of untimed calls before timing")
+            ("iters", bpo::value<int>()->default_value(20), "Number of timed calls");
+    }
+    desc.add_options()
+        ("no-pool", "Allocate matrix storage directly from HIP instead of caching pools")
+        ("chunk-mib", bpo::value<size_t>()->default_value(256), "Split host/device copies into chunks of this many MiB (0 for no split)");
+    if(program.takesInit)
+    {
+        desc.add_options()
+            ("init", bpo::value<std::string>()->default_value("pattern"), "Input values: 'pattern' (result known in closed form) or 'random' (checked against a host reference)")
+            ("seed", bpo::value<unsigned int>()->default_value(1), "Seed for random input values (with --init random)");
+    }
+    desc.add_options()
+        ("abs-tol", bpo::value<double>()->default_value(0), "Absolute error allowed when verifying results (with random inputs, all-zero tolerances mean choose ones based on the problem size)")
+        ("rel-tol", bpo::value<double>()->default_value(0), "Relative error allowed when verifying results")
+        ("ulp-tol", bpo::value<uint32_t>()->default_value(0), "Error in units in the last place allowed when verifying results");
+    if(runsGemms and program.runsShapes)
+    {
+        desc.add_options()
+            ("verify", bpo::value<std::string>()->default_value("full"), "How to verify results: 'full' (every element) or 'abft' (row and column checksums, O(mn))")
+            ("soak", bpo::value<int>()->default_value(0), "Number of GEMMs to run after verification, each on the previous output and verified with checksums")
+            ("scalars", bpo::value<std::string>()->default_value("host"), "Where the library reads alpha and beta from: 'host' or 'device' memory")
+            ("graph", bpo::value<int>()->default_value(0), "Also time this many GEMMs captured into a HIP graph and replayed, against direct submission (with --bench)")
+            ("graph-copies", "Include the input and output copies in the graph and in the direct submission it is compared with (with --graph)")
+            ("chain", bpo::value<int>()->default_value(0), "Also time chains of this many dependent GEMMs with scalars in host and in device memory (with --bench)")
+            ("lean", "Fill inputs on the device and check results in chunks, keeping no full host copies, for problems too big for them (pattern inputs, full verification)");
+    }
+    if(runsGemms and program.runsModes)
+    {
+        desc.add_options()
+            ("pipeline", bpo::value<int>()->default_value(0), "Run this many independent problems per shape, serialized and pipelined over several streams, and compare throughput")
+            ("threads", bpo::value<int>()->default_value(0), "Run GEMMs from 1, 2, 4, ... up to this many host threads at once, each with its own stream, handle, and matrices, and report scaling")
+            ("replay", bpo::value<std::string>()->default_value(""), "Replay the GEMM calls in this trace file (one call per line: OPS m n k [alpha= beta= lda= ldb= ldc= stream= after=]) and report time by shape class")
+            ("startup", "Time the steps up to the first and second GEMM of the first shape in fresh processes, without and with pre-warming")
+            ("startup-runs", bpo::value<int>()->default_value(5), "Number of fresh processes to profile startup in, cold and pre-warmed each (with --startup)")
+            ("prewarm", "Pre-warm the library with tiny GEMMs before running the tests");
+    }
+    if(runsGemms and (program.runsModes or program.runsTiled))
+    {
+        desc.add_options()
+            ("streams", bpo::value<int>()->default_value(2), "Number of streams for the pipelined or tiled runner (with --pipeline or --device-budget)");
+    }
+    if(runsGemms and program.takesBatch)
+    {
+        desc.add_options()
+            ("batch", bpo::value<std::string>()->default_value("1,8,64,512"), "Batch counts (value, list, or range)");
+    }
+    if(runsGemms and program.runsTiled)
+    {
+        desc.add_options()
+            ("device-budget", bpo::value<long long>()->default_value(0), "Run each shape out of core, keeping A, B, and C on the host and streaming tiles through this many MiB of device memory, and compare with the in-core GEMM where it fits (0 to not)");
+    }
+    if(hasMatrices)
+    {
+        desc.add_options()
+            ("pad", bpo::value<std::string>()->default_value("0"), "Elements of padding at the end of each matrix column (value or list, swept by sweeps)")
+            ("ld-multiple", bpo::value<int>()->default_value(1), "Round leading dimensions up to a multiple of this many elements")
+            ("align", bpo::value<size_t>()->default_value(0), "Alignment of each matrix's first element in bytes, a power of two (0 for the allocator's)");
+    }
+    if(runsGemms and program.takesOps)
+    {
+        desc.add_options()
+            ("ops", bpo::value<std::string>()->default_value("NN,NT,TN,TT"), "Ops for A and B (list of N, T, or C pairs, like NT for A * B^T)");
+    }
+    if(runsGemms and program.takesStorage)
+    {
+        desc.add_options()
+            ("storage", bpo::value<std::string>()->default_value("pinned,pageable,managed,device"), "Matrix storage (list of pinned, pageable, managed, or device)");
+    }
+    desc.add_options()
+        ("trace", bpo::value<std::string>()->default_value(""), "Write a Chrome trace (chrome://tracing or Perfetto JSON) of the run's phases to this file")
+        ("json", bpo::value<std::string>()->default_value(""), "Write the results, with version information, as JSON to this file (for exttest_compare)")
+        ("max-report", bpo::value<size_t>()->default_value(10), "Most mismatches to print individually")
+        ("check-threads", bpo::value<unsigned int>()->default_value(0), "Host threads for verification (0 for one per hardware thread)")
     ;
 
     bpo::variables_map opts;
@@ -43,11 +308,20 @@ ParseCommandLine(int argc, char* argv[])
         verbose = true;
     }
 
-    auto m = opts["nRowsA"].as<int>();
-    auto k = opts["nColsA"].as<int>();
-    auto n = opts["nColsC"].as<int>();
+    // Each dimension may be a list of sizes.
+    // We run every combination of them.  Programs that don't
+    // take a dimension get its default.
+    auto sizeList = [&opts](const char* name, const std::string& defaultSizes) {
+        return ParseSizeList<int>((opts.count(name) > 0) ? opts[name].as<std::string>() : defaultSizes);
+    };
+    auto m = sizeList("nRowsA", program.defaultM);
+    auto k = sizeList("nColsA", program.defaultK);
+    auto n = sizeList("nColsC", program.defaultN);
 
-    if( (m <= 0) or (k <= 0) or (n <= 0) )
+    auto hasBadDim = [](const std::vector<int>& dims) {
+        return std::any_of(dims.begin(), dims.end(), [](int dim){ return dim <= 0; });
+    };
+    if( hasBadDim(m) or hasBadDim(k) or hasBadDim(n) )
     {
         std::cerr << "m, n, and k must each be >=1" << std::endl;
         shouldRun = false;
@@ -55,9 +329,323 @@ ParseCommandLine(int argc, char* argv[])
     }
 
     auto alpha = opts["alpha"].as<ScalarType>();
-    auto beta = opts["beta"].as<ScalarType>();
+    auto beta = (opts.count("beta") > 0) ? opts["beta"].as<ScalarType>() : ScalarType(0);
+
+    RunOptions runOpts;
+    runOpts.bench.enabled = (opts.count("bench") > 0);
+    runOpts.bench.nWarmup = opts["warmup"].as<int>();
+    runOpts.bench.nIters = opts["iters"].as<int>();
+    if( (runOpts.bench.nWarmup < 0) or (runOpts.bench.nIters <= 0) )
+    {
+        std::cerr << "warmup must be >=0 and iters must be >=1" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    runOpts.usePools = (opts.count("no-pool") == 0);
+    runOpts.transferChunkBytes = opts["chunk-mib"].as<size_t>() << 20;
 
-    return std::make_tuple(shouldRun, ret, m, k, n, alpha, beta, verbose);
+    if(program.takesInit)
+    {
+        auto initKind = opts["init"].as<std::string>();
+        if( (initKind != "pattern") and (initKind != "random") )
+        {
+            std::cerr << "init must be 'pattern' or 'random'" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+        runOpts.init.random = (initKind == "random");
+        runOpts.init.seed = opts["seed"].as<unsigned int>();
+    }
+
+    runOpts.check.absTol = opts["abs-tol"].as<double>();
+    runOpts.check.relTol = opts["rel-tol"].as<double>();
+    runOpts.check.ulpTol = opts["ulp-tol"].as<uint32_t>();
+    runOpts.check.maxReported = opts["max-report"].as<size_t>();
+    runOpts.check.nThreads = opts["check-threads"].as<unsigned int>();
+    if( (runOpts.check.absTol < 0) or (runOpts.check.relTol < 0) )
+    {
+        std::cerr << "tolerances must be >=0" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    if(hasMatrices)
+    {
+        runOpts.pads = ParseSizeList<int>(opts["pad"].as<std::string>());
+        runOpts.init.layout.pad = runOpts.pads[0];
+        runOpts.init.layout.ldMultiple = opts["ld-multiple"].as<int>();
+        runOpts.init.layout.baseAlignment = opts["align"].as<size_t>();
+        auto isPowerOfTwo = [](size_t x) { return (x & (x - 1)) == 0; };
+        if( std::any_of(runOpts.pads.begin(), runOpts.pads.end(), [](int pad){ return pad < 0; })
+            or (runOpts.init.layout.ldMultiple <= 0)
+            or not isPowerOfTwo(runOpts.init.layout.baseAlignment) )
+        {
+            std::cerr << "pads must be >=0, ld-multiple must be >=1, and align must be 0 or a power of two" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+    }
+
+    if(runsGemms and program.runsShapes)
+    {
+        auto verifyKind = opts["verify"].as<std::string>();
+        if( (verifyKind != "full") and (verifyKind != "abft") )
+        {
+            std::cerr << "verify must be 'full' or 'abft'" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+        runOpts.verifyChecksums = (verifyKind == "abft");
+        runOpts.nSoakIters = opts["soak"].as<int>();
+        if(runOpts.nSoakIters < 0)
+        {
+            std::cerr << "soak must be >=0" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+        runOpts.init.checksums = runOpts.verifyChecksums or (runOpts.nSoakIters > 0);
+
+        runOpts.nGraphGemms = opts["graph"].as<int>();
+        runOpts.graphCopies = (opts.count("graph-copies") > 0);
+        if(runOpts.nGraphGemms < 0)
+        {
+            std::cerr << "graph must be >=0" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+
+        auto scalars = opts["scalars"].as<std::string>();
+        if( (scalars != "host") and (scalars != "device") )
+        {
+            std::cerr << "scalars must be 'host' or 'device'" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+        runOpts.init.deviceScalars = (scalars == "device");
+
+        runOpts.nChainGemms = opts["chain"].as<int>();
+        if(runOpts.nChainGemms < 0)
+        {
+            std::cerr << "chain must be >=0" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+
+        runOpts.init.lean = (opts.count("lean") > 0);
+    }
+
+    if(runsGemms)
+    {
+        if(program.takesBatch)
+        {
+            runOpts.batchCounts = ParseSizeList<int>(opts["batch"].as<std::string>());
+            if(hasBadDim(runOpts.batchCounts))
+            {
+                std::cerr << "batch counts must each be >=1" << std::endl;
+                shouldRun = false;
+                ret = 1;
+            }
+        }
+
+        if(program.takesOps)
+        {
+            try
+            {
+                runOpts.ops = ParseGemmOpPairList(opts["ops"].as<std::string>());
+            }
+            catch(const std::invalid_argument& e)
+            {
+                std::cerr << e.what() << std::endl;
+                shouldRun = false;
+                ret = 1;
+            }
+        }
+
+        if(program.takesStorage)
+        {
+            try
+            {
+                runOpts.storages = ParseStorageList(opts["storage"].as<std::string>());
+            }
+            catch(const std::invalid_argument& e)
+            {
+                std::cerr << e.what() << std::endl;
+                shouldRun = false;
+                ret = 1;
+            }
+        }
+    }
+
+    if(runsGemms and program.runsModes)
+    {
+        runOpts.nPipelineProblems = opts["pipeline"].as<int>();
+        if(runOpts.nPipelineProblems < 0)
+        {
+            std::cerr << "pipeline must be >=0" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+
+        runOpts.profileStartup = (opts.count("startup") > 0);
+        runOpts.nStartupRuns = opts["startup-runs"].as<int>();
+        if(runOpts.nStartupRuns <= 0)
+        {
+            std::cerr << "startup-runs must be >=1" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+        runOpts.prewarm = (opts.count("prewarm") > 0);
+
+        runOpts.nHostThreads = opts["threads"].as<int>();
+        if(runOpts.nHostThreads < 0)
+        {
+            std::cerr << "threads must be >=0" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+
+        runOpts.replayPath = opts["replay"].as<std::string>();
+    }
+
+    if(runsGemms and (program.runsModes or program.runsTiled))
+    {
+        runOpts.nStreams = opts["streams"].as<int>();
+        if(runOpts.nStreams <= 0)
+        {
+            std::cerr << "streams must be >=1" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+    }
+
+    if(runsGemms and program.runsTiled)
+    {
+        // Parsed signed, so that a negative budget is
+        // rejected rather than wrapping to a huge one.
+        auto budgetMiB = opts["device-budget"].as<long long>();
+        const auto maxBudgetMiB = std::numeric_limits<size_t>::max() >> 20;
+        if( (budgetMiB < 0) or (static_cast<unsigned long long>(budgetMiB) > maxBudgetMiB) )
+        {
+            std::cerr << "device-budget must be >=0 and at most " << maxBudgetMiB << " MiB" << std::endl;
+            shouldRun = false;
+            ret = 1;
+        }
+        else
+        {
+            runOpts.deviceBudgetBytes = static_cast<size_t>(budgetMiB) << 20;
+        }
+    }
+
+    if( runOpts.init.lean
+        and (runOpts.init.random
+                or runOpts.init.checksums
+                or (runOpts.nPipelineProblems > 0)
+                or (runOpts.deviceBudgetBytes > 0)
+                or runOpts.graphCopies) )
+    {
+        std::cerr << "lean mode supports only pattern inputs with full verification, without soak, pipeline, device budget, or graph copies" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    // DoSgemmMain runs only one of these modes.
+    auto nModes = (not runOpts.replayPath.empty())
+        + (runOpts.nPipelineProblems > 0)
+        + (runOpts.deviceBudgetBytes > 0)
+        + (runOpts.nHostThreads > 0)
+        + runOpts.profileStartup;
+    if(nModes > 1)
+    {
+        std::cerr << "replay, pipeline, device budget, threads, and startup cannot be combined" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    if( (runOpts.deviceBudgetBytes > 0)
+        and (runOpts.init.checksums
+                or runOpts.init.deviceScalars
+                or (runOpts.nGraphGemms > 0)
+                or (runOpts.nChainGemms > 0)) )
+    {
+        std::cerr << "device budget (tiled mode) supports only full verification with host scalars, without soak, graph, or chain" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    // Graph and chain are comparisons made per shape in the plain sweep.
+    if( (runOpts.nPipelineProblems > 0)
+        and ((runOpts.nSoakIters > 0) or (runOpts.nGraphGemms > 0) or (runOpts.nChainGemms > 0)) )
+    {
+        std::cerr << "pipeline supports neither soak, graph, nor chain" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+    if( (runOpts.nHostThreads > 0)
+        and ((runOpts.nGraphGemms > 0) or (runOpts.nChainGemms > 0)) )
+    {
+        std::cerr << "threads supports neither graph nor chain" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    // Replay times an application's calls and verifies nothing.
+    if( not runOpts.replayPath.empty()
+        and (runOpts.init.random
+                or runOpts.init.checksums
+                or runOpts.init.deviceScalars
+                or runOpts.init.lean
+                or (runOpts.nGraphGemms > 0)
+                or (runOpts.nChainGemms > 0)) )
+    {
+        std::cerr << "replay supports none of random inputs, abft verification, soak, device scalars, lean, graph, or chain" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    runOpts.tracePath = opts["trace"].as<std::string>();
+    if(shouldRun and not runOpts.tracePath.empty())
+    {
+        Tracer::Get().Enable();
+    }
+
+    runOpts.resultsPath = opts["json"].as<std::string>();
+    if(shouldRun and not runOpts.resultsPath.empty())
+    {
+        auto& results = ResultsWriter::Get();
+        results.Enable(argv[0]);
+#if defined(H4I_USE_HOST_STANDIN)
+        results.AddEnvironment("blas_library", "host stand-in hipBLAS");
+#elif defined(H4I_USE_ROCM_LIBS)
+        results.AddEnvironment("blas_library", "ROCm hipBLAS");
+#else
+        results.AddEnvironment("blas_library", "H4I hipBLAS");
+#endif // defined(H4I_USE_ROCM_LIBS)
+#if defined(hipblasVersionMajor)
+        results.AddEnvironment("hipblas_version",
+                                std::to_string(hipblasVersionMajor)
+                                    + '.' + std::to_string(hipblasVersionMinor)
+                                    + '.' + std::to_string(hipblasVersionPatch));
+#endif // defined(hipblasVersionMajor)
+    }
+
+    return std::make_tuple(shouldRun, ret, m, k, n, alpha, beta, verbose, runOpts);
+}
+
+// A GEMM program, with its own defaults for m, n, and k.
+template<typename ScalarType>
+std::tuple<bool, int, std::vector<int>, std::vector<int>, std::vector<int>, ScalarType, ScalarType, bool, RunOptions>
+ParseCommandLine(int argc,
+                    char* argv[],
+                    const char* defaultM = "8",
+                    const char* defaultN = "12",
+                    const char* defaultK = "4")
+{
+    ProgramInfo program;
+    program.defaultM = defaultM;
+    program.defaultN = defaultN;
+    program.defaultK = defaultK;
+    return ParseCommandLine<ScalarType>(argc, argv, program);
 }
 
 #endif // TEST_COMMAND_LINE_H
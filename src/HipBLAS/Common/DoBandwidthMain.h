@@ -0,0 +1,225 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef DO_BANDWIDTH_MAIN_H
+#define DO_BANDWIDTH_MAIN_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "CommandLine.h"
+#include "HipStream.h"
+#include "Benchmark.h"
+#include "Matrix.h"
+#include "MemoryPool.h"
+#include "ResultsWriter.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// Time repeated device-to-device copies of nBytes bytes
+// (rounded up to whole floats), for a baseline of the memory
+// bandwidth the device can reach.  Each copy reads and writes
+// nBytes, so moves 2 * nBytes.
+inline
+std::vector<double>
+TimeDeviceCopy(const HipStream& hipStream,
+                size_t nBytes,
+                const BenchmarkOptions& bench)
+{
+    TraceSpan span("TimeDeviceCopy", "benchmark");
+
+    auto nItems = static_cast<int>((nBytes + sizeof(float) - 1) / sizeof(float));
+    Matrix<float> src(nItems, 1);
+    Matrix<float> dst(nItems, 1);
+
+    // Allocate the storage before timing.
+    src.GetDeviceData();
+    dst.GetDeviceData();
+    return TimeOnStream(hipStream,
+                        bench,
+                        [&](){
+                            CHECK(hipMemcpyAsync(dst.GetDeviceData(),
+                                                    src.GetDeviceData(),
+                                                    src.GetSize(),
+                                                    hipMemcpyDeviceToDevice,
+                                                    hipStream.GetHandle()));
+                        });
+}
+
+// For the memory-bound BLAS operations (level 1 and GEMV), time
+// repeated calls for each problem size, then do one more and verify
+// it.  Report the bandwidth achieved from the bytes the operation
+// must move, next to that of a device-to-device copy moving the
+// same number of bytes, measured at each size since both depend
+// on whether the data fits in the device's caches.
+// Vector operations take their length from m; GEMVs sweep m and n.
+template<typename TesterType>
+int
+DoBandwidthMain(int argc,
+                char* argv[],
+                const char* defaultM,
+                const char* defaultN = "12")
+{
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::vector<int> ms;
+        std::vector<int> ks;
+        std::vector<int> ns;
+        float alpha;
+        float beta;
+        bool verbose;
+        RunOptions runOpts;
+
+        ProgramInfo program;
+        program.description = std::string("Bandwidth of hipBLAS ") + TesterType::GetName() + " over HIPLZ.";
+        program.runsGemms = false;
+        program.hasMatrices = TesterType::hasN;
+        program.defaultM = defaultM;
+        program.defaultN = defaultN;
+
+        std::tie(shouldRun,
+                    ret,
+                    ms,
+                    ks,
+                    ns,
+                    alpha,
+                    beta,
+                    verbose,
+                    runOpts) = ParseCommandLine<float>(argc, argv, program);
+
+        if(shouldRun)
+        {
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            TransferChunkBytes() = runOpts.transferChunkBytes;
+
+            HipStream hipStream;
+            typename TesterType::ContextType libContext(hipStream);
+
+            if(not TesterType::hasN)
+            {
+                ns = { 1 };
+            }
+
+            // Every size is timed, as if with --bench.
+            const auto& bench = runOpts.bench;
+            std::cout << "# op: " << TesterType::GetName()
+                << ", inputs: " << (runOpts.init.random ? "random" : "pattern") << '\n'
+                << "m,n,bytes,warmup,iters,min_ms,median_ms,p95_ms,gbps,copy_median_ms,copy_gbps,pct_of_copy,gflops,mismatches,max_abs_err,status"
+                << std::endl;
+            for(auto m : ms)
+            {
+                for(auto n : ns)
+                {
+                    TesterType tester(m, n, alpha, beta, hipStream, libContext, runOpts.init);
+                    hipStream.Synchronize();
+
+                    std::vector<double> samples;
+                    {
+                        TraceSpan span("benchmark", "blas");
+                        samples = TimeOnStream(hipStream,
+                                                bench,
+                                                [&tester](){ tester.Enqueue(); });
+                    }
+                    TimingStats stats(samples);
+
+                    auto nBytes = tester.GetBytesMoved();
+                    auto copyBytes = static_cast<size_t>(nBytes / 2);
+                    TimingStats copyStats(TimeDeviceCopy(hipStream, copyBytes, bench));
+
+                    auto gbps = ToGBps(nBytes, stats.medianMs);
+                    auto copyGbps = ToGBps(2.0 * copyBytes, copyStats.medianMs);
+                    auto pctOfCopy = (copyGbps > 0) ? (100 * gbps / copyGbps) : 0;
+
+                    // The timed calls accumulated into the output,
+                    // so start over for the verification run.
+                    tester.ResetOutput();
+                    tester.Do();
+                    if(verbose)
+                    {
+                        std::cout << tester << std::endl;
+                    }
+                    auto check = tester.CheckComputation(runOpts.check, true);
+
+                    std::cout << tester.GetM() << ',' << tester.GetN()
+                        << ',' << static_cast<size_t>(nBytes)
+                        << ',' << bench.nWarmup
+                        << ',' << bench.nIters
+                        << ',' << stats.minMs
+                        << ',' << stats.medianMs
+                        << ',' << stats.p95Ms
+                        << ',' << gbps
+                        << ',' << copyStats.medianMs
+                        << ',' << copyGbps
+                        << ',' << pctOfCopy
+                        << ',' << ToGflops(tester.GetFlopCount(), stats.medianMs)
+                        << ',' << check.nMismatches
+                        << ',' << check.maxAbsErr
+                        << ',' << ((check.nMismatches == 0) ? "PASS" : "FAIL")
+                        << std::endl;
+
+                    ResultRecord record;
+                    record.config.Add("kind", TesterType::GetName())
+                        .Add("m", tester.GetM())
+                        .Add("n", tester.GetN())
+                        .Add("init", runOpts.init.random ? "random" : "pattern");
+                    record.metrics.Add("bytes", static_cast<size_t>(nBytes))
+                        .Add("min_ms", stats.minMs)
+                        .Add("median_ms", stats.medianMs)
+                        .Add("mean_ms", stats.meanMs)
+                        .Add("p95_ms", stats.p95Ms)
+                        .Add("gbps", gbps)
+                        .Add("copy_median_ms", copyStats.medianMs)
+                        .Add("copy_gbps", copyGbps)
+                        .Add("pct_of_copy", pctOfCopy)
+                        .Add("gflops", ToGflops(tester.GetFlopCount(), stats.medianMs))
+                        .Add("mismatches", check.nMismatches)
+                        .Add("max_abs_err", check.maxAbsErr);
+                    record.samplesMs = samples;
+                    record.passed = (check.nMismatches == 0);
+                    ResultsWriter::Get().Add(std::move(record));
+                }
+            }
+
+            std::cout << "# ";
+            ReportPeakMemory(std::cout);
+
+            // Write the trace now, while the HIP runtime is still usable.
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+
+            // A result that failed verification fails the program.
+            if(ResultsWriter::Get().AnyFailed())
+            {
+                ret = 1;
+            }
+            ReleaseMemoryPools();
+        }
+    }
+    catch(const HipException& e)
+    {
+        std::cerr << "HIP Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const typename TesterType::ExceptionType& e)
+    {
+        std::cerr << "hipBLAS Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}
+
+#endif // DO_BANDWIDTH_MAIN_H
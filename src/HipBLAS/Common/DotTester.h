@@ -0,0 +1,152 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef DOT_TESTER_H
+#define DOT_TESTER_H
+
+#include <iostream>
+#include <random>
+#include "HipStream.h"
+#include "Matrix.h"
+#include "MatrixChecker.h"
+#include "GemmInputs.h"
+#include "Trace.h"
+
+// Tests result = x . y, with x and y vectors of length n.
+// Vectors are n x 1 matrices, and the result is a 1 x 1 matrix
+// that the library writes in device memory, so that calls can be
+// enqueued without the host waiting for each one.
+class DotTester
+{
+protected:
+    Matrix<float> x;
+    Matrix<float> y;
+    Matrix<float> result;
+
+    const HipStream& hipStream;
+
+    InitOptions init;
+
+    // Fill x and y with small integers whose products sum to zero
+    // over every 35 consecutive elements, so that partial sums
+    // stay small and the result is exact in the orders libraries
+    // usually sum in (and in any order, for n below 2^24 / 6):
+    // x[i] = (i % 7) - 3 and y[i] = (i % 5) - 2.
+    void FillPatternInputs(void)
+    {
+        for(auto i = 0; i < GetLength(); ++i)
+        {
+            x.El(i, 0) = static_cast<float>((i % 7) - 3);
+            y.El(i, 0) = static_cast<float>((i % 5) - 2);
+        }
+    }
+
+    // Fill the vectors and copy them to the device.
+    void InitVectors(void)
+    {
+        TraceSpan span("InitVectors", "init");
+
+        if(init.random)
+        {
+            std::mt19937 genX(init.seed);
+            std::mt19937 genY(init.seed + 1);
+            FillRandom(x, genX);
+            FillRandom(y, genY);
+        }
+        else
+        {
+            FillPatternInputs();
+        }
+
+        x.CopyHostToDeviceAsync(hipStream);
+        y.CopyHostToDeviceAsync(hipStream);
+    }
+
+public:
+    DotTester(int n,
+                const HipStream& _hipStream,
+                const InitOptions& _init = InitOptions())
+      : x(n, 1),
+        y(n, 1),
+        result(1, 1),
+        hipStream(_hipStream),
+        init(_init)
+    {
+        InitVectors();
+    }
+
+    virtual ~DotTester(void)
+    {
+        // nothing to do.
+    }
+
+    void DumpTo(std::ostream& os) const
+    {
+        os << "x: " << x
+            << "\ny: " << y
+            << "\nresult: " << result
+            << std::endl;
+    }
+
+    // Enqueue the dot product on our stream, without waiting for it
+    // to complete or reading its result back to the host.
+    virtual void Enqueue(void) = 0;
+
+    // Do the dot product and read its result back to the host.
+    void Do(void)
+    {
+        Enqueue();
+        result.CopyDeviceToHostAsync(hipStream);
+        hipStream.Synchronize();
+    }
+
+    // The result is overwritten, not accumulated into,
+    // so there is nothing to restore.
+    void ResetOutput(void)
+    {
+    }
+
+    int GetLength(void) const   { return x.GetNumRows(); }
+
+    // Number of floating point operations done by one call.
+    double GetFlopCount(void) const     { return 2.0 * GetLength(); }
+
+    // Number of bytes one call must move to or from device
+    // memory: x and y are read.
+    double GetBytesMoved(void) const    { return 2.0 * GetLength() * sizeof(float); }
+
+    // Compare the result against the dot product computed on the
+    // host in double precision.  With pattern inputs, it is exact.
+    // Unless quiet, describe the outcome on standard output.
+    CheckResult CheckComputation(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
+    {
+        TraceSpan span("CheckComputation", "check");
+
+        auto fillExpected = [this](int, float* expected) {
+            double sum = 0;
+            for(auto i = 0; i < GetLength(); ++i)
+            {
+                sum += static_cast<double>(x.El(i, 0)) * y.El(i, 0);
+            }
+            expected[0] = static_cast<float>(sum);
+        };
+        auto check = CheckMatrix(result,
+                                    fillExpected,
+                                    init.random ? WithRandomInputTolerance<float>(opts, GetLength(), 1, 0) : opts);
+        if(not quiet)
+        {
+            ReportCheck(std::cout, check);
+        }
+        return check;
+    }
+};
+
+inline
+std::ostream&
+operator<<(std::ostream& os, const DotTester& tester)
+{
+    tester.DumpTo(os);
+    return os;
+}
+
+#endif // DOT_TESTER_H
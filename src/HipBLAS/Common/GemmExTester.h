@@ -3,9 +3,19 @@
 #ifndef GEMMEX_TESTER_H
 #define GEMMEX_TESTER_H
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
 #include "HipStream.h"
 #include "Matrix.h"
+#include "MatrixChecker.h"
+#include "ChecksumVerifier.h"
+#include "GemmInputs.h"
+#include "ReferenceGemm.h"
+#include "Trace.h"
 
 template<typename InType, typename OutType, bool Transpose = false>
 class GemmExTester
@@ -28,20 +38,39 @@ protected:
 
     const HipStream& hipStream;
 
-    // Create the input matrices with known values.
+    // How the inputs are filled, and the initial value of C.
+    InitOptions init;
+    std::vector<float> initialC;
+
+    // Random inputs as drawn, before rounding to InType and OutType,
+    // so MeasureError can count the accuracy lost to that rounding.
+    std::vector<float> drawnA;
+    std::vector<float> drawnB;
+    std::vector<float> drawnC;
+
+    // Pattern values for C repeat with this period, so they are
+    // integers OutType holds exactly (and binary16 doesn't overflow).
+    static constexpr int64_t patternPeriod = int64_t(1) << ((sizeof(OutType) == 2) ? 11 : 24);
+
+    static int64_t PatternC(int r, int c)  { return (static_cast<int64_t>(r) * c) % patternPeriod; }
+
+    // Sums of the inputs, for checking the output with checksums.
+    // Only built if init.checksums is set.
+    std::unique_ptr<ChecksumVerifier<OutType, ComputeType>> checksums;
+
+    // Fill the input matrices with a pattern whose result is known.
     // Current test is:
     // * Items in col 0 of A are all 1.  Otherwise 0.
     // * Items in logical row 0 of B are all 1.  Otherwise 0.
     // * Storage for B in memory may be transposed.
-    // * C[r, c] = r*c.
-    // After the SGEMM, C[r,c] should be alpha + beta * r * c
-    void InitMatrices(void)
+    // * C[r, c] = r*c, modulo patternPeriod.
+    // After the SGEMM, C[r,c] should be alpha + beta * C[r, c]
+    void FillPatternInputs(void)
     {
         for(auto r = 0; r < A.GetNumRows(); ++r)
         {
             A.El(r, 0) = 1;
         }
-        A.CopyHostToDeviceAsync(hipStream);
 
         for(auto c = 0; c < (Transpose ? B.GetNumRows() : B.GetNumCols()); ++c)
         {
@@ -55,22 +84,159 @@ protected:
                 B.El(0, c) = val;
             }
         }
-        B.CopyHostToDeviceAsync(hipStream);
 
         for(auto c = 0; c < C.GetNumCols(); ++c)
         {
             for(auto r = 0; r < C.GetNumRows(); ++r)
             {
-                C.El(r, c) = r*c;
+                C.El(r, c) = static_cast<float>(PatternC(r, c));
             }
         }
+    }
+
+    // Fill A, B, and C with random values in [-1, 1].
+    // Each matrix has its own generator, so its values
+    // depend only on the seed and its own shape.
+    void FillRandomInputs(void)
+    {
+        std::mt19937 genA(init.seed);
+        std::mt19937 genB(init.seed + 1);
+        std::mt19937 genC(init.seed + 2);
+        FillRandom(A, genA, drawnA);
+        FillRandom(B, genB, drawnB);
+        FillRandom(C, genC, drawnC);
+    }
+
+    // Fill the input matrices and copy them to the device.
+    void InitMatrices(void)
+    {
+        TraceSpan span("InitMatrices", "init");
+
+        if(init.lean)
+        {
+            throw std::invalid_argument("lean mode is supported only by the SGEMM tester");
+        }
+
+        if(init.random)
+        {
+            FillRandomInputs();
+        }
+        else
+        {
+            FillPatternInputs();
+        }
+
+        // Keep C's initial value, since reading back
+        // the GEMM's result overwrites the host copy.
+        initialC.resize(C.GetNumStoredItems());
+        for(size_t i = 0; i < C.GetNumStoredItems(); ++i)
+        {
+            initialC[i] = ToFloat(C.GetHostData()[i]);
+        }
+
+        A.CopyHostToDeviceAsync(hipStream);
+        B.CopyHostToDeviceAsync(hipStream);
         C.CopyHostToDeviceAsync(hipStream);
 
+        if(init.checksums)
+        {
+            checksums = std::make_unique<ChecksumVerifier<OutType, ComputeType>>(false,
+                                                                                 Transpose,
+                                                                                 A.GetNumRows(),
+                                                                                 C.GetNumCols(),
+                                                                                 A.GetNumCols(),
+                                                                                 ToFloat(alpha),
+                                                                                 A.GetHostData(),
+                                                                                 A.GetLeadingDim(),
+                                                                                 B.GetHostData(),
+                                                                                 B.GetLeadingDim(),
+                                                                                 ToFloat(beta));
+            checksums->SetInput(C.GetHostData(), C.GetLeadingDim());
+        }
+
         // We don't need to initialize any values in D. 
         // Either it is only used as an output, or
         // it is not used by the GemmEx() implementation.
     }
 
+    // Compare the output against expected values, optionally
+    // rounded to OutType.  For random inputs, the expected values
+    // come from the inputs the GEMM was given, or optionally from
+    // the inputs as drawn, before rounding to InType and OutType.
+    CheckResult CompareToReference(const CheckOptions& opts,
+                                    bool roundToOutType,
+                                    bool fromDrawnInputs) const
+    {
+        auto& outputMatrix = this->UsesD() ? D : C;
+        auto round = [roundToOutType](float val) {
+            return roundToOutType ? ToFloat(static_cast<OutType>(val)) : val;
+        };
+
+        if(init.random)
+        {
+            // The reference accumulates in float, whatever InType is.
+            std::vector<float> expectedC(fromDrawnInputs ? drawnC : initialC);
+            if(fromDrawnInputs)
+            {
+                ReferenceGemm<float, float>(false,
+                                            Transpose,
+                                            A.GetNumRows(),
+                                            C.GetNumCols(),
+                                            A.GetNumCols(),
+                                            ToFloat(alpha),
+                                            drawnA.data(),
+                                            A.GetLeadingDim(),
+                                            drawnB.data(),
+                                            B.GetLeadingDim(),
+                                            ToFloat(beta),
+                                            expectedC.data(),
+                                            C.GetLeadingDim(),
+                                            opts.nThreads);
+            }
+            else
+            {
+                ReferenceGemm<InType, float>(false,
+                                                Transpose,
+                                                A.GetNumRows(),
+                                                C.GetNumCols(),
+                                                A.GetNumCols(),
+                                                ToFloat(alpha),
+                                                A.GetHostData(),
+                                                A.GetLeadingDim(),
+                                                B.GetHostData(),
+                                                B.GetLeadingDim(),
+                                                ToFloat(beta),
+                                                expectedC.data(),
+                                                C.GetLeadingDim(),
+                                                opts.nThreads);
+            }
+
+            auto fillExpected = [this, &expectedC, &round](int c, float* expected) {
+                auto col = &expectedC[static_cast<size_t>(c) * C.GetLeadingDim()];
+                for(auto r = 0; r < C.GetNumRows(); ++r)
+                {
+                    expected[r] = round(col[r]);
+                }
+            };
+            return CheckMatrix(outputMatrix,
+                                fillExpected,
+                                WithRandomInputTolerance<OutType, ComputeType>(opts,
+                                                                                A.GetNumCols(),
+                                                                                ToFloat(alpha),
+                                                                                ToFloat(beta)));
+        }
+        else
+        {
+            auto fillExpected = [this, &round](int c, float* expected) {
+                for(auto r = 0; r < C.GetNumRows(); ++r)
+                {
+                    expected[r] = round(ToFloat(alpha) + ToFloat(beta) * static_cast<float>(PatternC(r, c)));
+                }
+            };
+            return CheckMatrix(outputMatrix, fillExpected, opts);
+        }
+    }
+
     virtual bool UsesD(void) const = 0;
 
 public:
@@ -79,14 +245,16 @@ public:
                     int k,
                     OutType _alpha,
                     OutType _beta,
-                    const HipStream& _hipStream)
-      : A(m, k),
-        B( Transpose ? n : k, Transpose ? k : n ),
-        C(m, n),
-        D(m, n),
+                    const HipStream& _hipStream,
+                    const InitOptions& _init = InitOptions())
+      : A(m, k, _init.layout),
+        B( Transpose ? n : k, Transpose ? k : n, _init.layout ),
+        C(m, n, _init.layout),
+        D(m, n, _init.layout),
         alpha(_alpha),
         beta(_beta),
-        hipStream(_hipStream)
+        hipStream(_hipStream),
+        init(_init)
     {
         InitMatrices();
     }
@@ -102,36 +270,105 @@ public:
             << "\nbeta: " << beta
             << "\nA: " << A
             << "\nB: " << B
-            << "\nC: " << C
-            << "\nD: " << D
-            << std::endl;
+            << "\nC: " << C;
+        if(this->UsesD())
+        {
+            os << "\nD: " << D;
+        }
+        os << std::endl;
     }
 
+    // Enqueue the GEMM on our stream, without waiting for it
+    // to complete or reading its result back to the host.
+    virtual void EnqueueGemmEx(void) = 0;
+
+    // Do the GEMM and read its result back to the host.
     virtual void DoGemmEx(void) = 0;
-    
-    void CheckComputation(void) const
+
+    // Restore C on the device to its initial value, in case
+    // repeated GEMMs have overwritten it.
+    void ResetOutput(void)
+    {
+        for(size_t i = 0; i < C.GetNumStoredItems(); ++i)
+        {
+            C.GetHostData()[i] = static_cast<OutType>(initialC[i]);
+        }
+        C.CopyHostToDeviceAsync(hipStream);
+    }
+
+    // Number of floating point operations done by one GEMM.
+    double GetFlopCount(void) const
+    {
+        return 2.0 * A.GetNumRows() * C.GetNumCols() * A.GetNumCols();
+    }
+
+    // Compare the GEMM's output against the expected values:
+    // C[r,c] = alpha + beta * PatternC(r, c) for the pattern inputs, or
+    // the result of a host reference GEMM for random inputs.
+    // Expected values are rounded to OutType, as the GEMM's would be.
+    // Unless quiet, describe the outcome on standard output.
+    CheckResult CheckComputation(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
     {
+        TraceSpan span("CheckComputation", "check");
+
+        auto result = CompareToReference(opts, true, false);
+        if(not quiet)
+        {
+            ReportCheck(std::cout, result);
+        }
+        return result;
+    }
+
+    // Measure how far the GEMM's output is from the expected values
+    // computed in float, from random inputs as drawn, and *not* rounded
+    // to OutType, i.e., the accuracy lost by using InType, OutType,
+    // and ComputeType instead of float.
+    // Only the error statistics of the result are meaningful.
+    CheckResult MeasureError(const CheckOptions& opts = CheckOptions()) const
+    {
+        TraceSpan span("MeasureError", "check");
+
+        auto exactOpts = opts;
+        exactOpts.absTol = 0;
+        exactOpts.relTol = 0;
+        exactOpts.ulpTol = 0;
+        exactOpts.maxReported = 0;
+        return CompareToReference(exactOpts, false, true);
+    }
+
+    // Check the GEMM's output using row and column checksums
+    // (see ChecksumVerifier), in O(mn) time rather than the O(mnk)
+    // of CheckComputation with random inputs.
+    // Requires that the tester was built with init.checksums set.
+    // Unless quiet, describe the outcome on standard output.
+    ChecksumResult CheckChecksums(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
+    {
+        TraceSpan span("CheckChecksums", "check");
+
+        if(not checksums)
+        {
+            throw std::logic_error("checksums were not requested when the inputs were initialized");
+        }
         auto& outputMatrix = this->UsesD() ? D : C;
+        auto result = checksums->Check(outputMatrix.GetHostData(), outputMatrix.GetLeadingDim());
+        if(not quiet)
+        {
+            ReportChecksums(std::cout, result, opts.maxReported);
+        }
+        return result;
+    }
 
-        // Assumes column major ordering.
-        uint32_t nMismatches = 0;
-        for(auto c = 0; c < outputMatrix.GetNumCols(); c++)
+    // For soak tests that repeat the GEMM on its own output:
+    // take the output now on the host as the next GEMM's input C.
+    // (If we use D, the GEMM's input C doesn't change.)
+    void ChainChecksums(void)
+    {
+        if(checksums and not this->UsesD())
         {
-            for(auto r = 0; r < outputMatrix.GetNumRows(); r++)
-            {
-                auto expVal = (alpha + beta * r * c);
-                auto compVal = outputMatrix.El(r,c);
-                if(compVal != expVal)
-                {
-                    ++nMismatches;
-                    std::cout << "mismatch at: (" << r << ", " << c << ")"
-                        << " expected " << expVal
-                        << ", got " << compVal
-                        << std::endl;
-                }
-            }
+            checksums->SetInput(C.GetHostData(), C.GetLeadingDim());
         }
-        std::cout << "Total mismatches: " << nMismatches << std::endl;
     }
 };
 
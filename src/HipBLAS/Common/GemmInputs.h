@@ -0,0 +1,107 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef GEMM_INPUTS_H
+#define GEMM_INPUTS_H
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "Matrix.h"
+#include "MatrixChecker.h"
+
+// How testers lay out and fill their matrices.
+struct InitOptions
+{
+    // If false, use a rank-1 pattern whose result is known in
+    // closed form.  If true, use uniform random values in [-1, 1]
+    // and check the result against a host reference GEMM.
+    // Random inputs exercise the accumulation paths (tiling edges,
+    // k-splitting) that the rank-1 pattern doesn't.
+    bool random = false;
+
+    // Seed for the random values, so runs are reproducible.
+    unsigned int seed = 1;
+
+    // Whether to take sums of the inputs, so the output can
+    // be checked cheaply with checksums.
+    bool checksums = false;
+
+    // Leading dimension padding and alignment of all the matrices.
+    MatrixLayout layout;
+
+    // Lean mode, for problems too big for full host copies: inputs
+    // are filled on the device and results are checked in streamed
+    // chunks, so the matrices need no host storage.  Only pattern
+    // inputs are supported.
+    bool lean = false;
+
+    // Whether the matrices stay on the host, for GEMMs too big for
+    // device memory that stream them through the device in tiles
+    // (see RunTiled).  The inputs are not copied to the device.
+    bool hostOnly = false;
+
+    // Whether the library reads alpha and beta from device memory
+    // rather than host memory, for libraries that can do either.
+    bool deviceScalars = false;
+};
+
+// Fill a matrix's host data with uniform random values in [-1, 1].
+template<typename T>
+void
+FillRandom(Matrix<T>& matrix, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(auto c = 0; c < matrix.GetNumCols(); ++c)
+    {
+        for(auto r = 0; r < matrix.GetNumRows(); ++r)
+        {
+            matrix.El(r, c) = static_cast<T>(dist(gen));
+        }
+    }
+}
+
+// As above, also keeping the values as drawn, before any rounding
+// to T, in values (laid out like the matrix's storage).
+template<typename T>
+void
+FillRandom(Matrix<T>& matrix, std::mt19937& gen, std::vector<float>& values)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    values.assign(matrix.GetNumStoredItems(), 0.0f);
+    for(auto c = 0; c < matrix.GetNumCols(); ++c)
+    {
+        for(auto r = 0; r < matrix.GetNumRows(); ++r)
+        {
+            auto val = dist(gen);
+            values[static_cast<size_t>(c) * matrix.GetLeadingDim() + r] = val;
+            matrix.El(r, c) = static_cast<T>(val);
+        }
+    }
+}
+
+// Machine epsilon for the element types we test.
+template<typename T>
+constexpr double
+Epsilon(void)
+{
+    // binary16 has a 10 bit significand, binary32 a 23 bit one.
+    return (sizeof(T) == 2) ? std::ldexp(1.0, -10) : std::ldexp(1.0, -23);
+}
+
+// If the caller didn't ask for specific tolerances, choose ones
+// suited to comparing a GEMM on random inputs in [-1, 1] against
+// a host reference that sums in a different order: rounding
+// error in ComputeType that grows with k, plus one rounding to OutType.
+template<typename OutType, typename ComputeType = float>
+CheckOptions
+WithRandomInputTolerance(CheckOptions opts, int k, double alpha, double beta)
+{
+    if((opts.absTol == 0) and (opts.relTol == 0) and (opts.ulpTol == 0))
+    {
+        opts.absTol = 2 * Epsilon<ComputeType>() * (k * std::fabs(alpha) + std::fabs(beta));
+        opts.relTol = Epsilon<OutType>();
+    }
+    return opts;
+}
+
+#endif // GEMM_INPUTS_H
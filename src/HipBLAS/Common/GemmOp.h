@@ -0,0 +1,84 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef GEMM_OP_H
+#define GEMM_OP_H
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// How a GEMM operand is used: as is, transposed,
+// or conjugate transposed (the same as transposed for real
+// types, but often a separate code path in BLAS libraries).
+enum class GemmOp
+{
+    N,
+    T,
+    C
+};
+
+constexpr
+bool
+IsTransposed(GemmOp op)
+{
+    return op != GemmOp::N;
+}
+
+inline
+char
+GetOpName(GemmOp op)
+{
+    return (op == GemmOp::N) ? 'N' : ((op == GemmOp::T) ? 'T' : 'C');
+}
+
+inline
+GemmOp
+ParseGemmOp(char c)
+{
+    switch(c)
+    {
+    case 'N': case 'n': return GemmOp::N;
+    case 'T': case 't': return GemmOp::T;
+    case 'C': case 'c': return GemmOp::C;
+    default:
+        throw std::invalid_argument(std::string("bad GEMM op '") + c + "' (expected N, T, or C)");
+    }
+}
+
+// The ops for A and B, e.g., (N, T) for A * B^T.
+using GemmOpPair = std::pair<GemmOp, GemmOp>;
+
+inline
+std::string
+GetOpPairName(const GemmOpPair& ops)
+{
+    return std::string{ GetOpName(ops.first), GetOpName(ops.second) };
+}
+
+// Parse a comma-separated list of op pairs, like "NN,NT,TN,TT".
+inline
+std::vector<GemmOpPair>
+ParseGemmOpPairList(const std::string& str)
+{
+    std::vector<GemmOpPair> ret;
+
+    std::istringstream istr(str);
+    std::string item;
+    while(std::getline(istr, item, ','))
+    {
+        if(item.size() != 2)
+        {
+            throw std::invalid_argument("bad GEMM op pair '" + item + "' (expected two of N, T, or C, like NT)");
+        }
+        ret.emplace_back(ParseGemmOp(item[0]), ParseGemmOp(item[1]));
+    }
+    if(ret.empty())
+    {
+        throw std::invalid_argument("empty GEMM op pair list");
+    }
+    return ret;
+}
+
+#endif // GEMM_OP_H
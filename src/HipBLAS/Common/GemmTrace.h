@@ -0,0 +1,220 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef GEMM_TRACE_H
+#define GEMM_TRACE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "GemmOp.h"
+#include "SizeList.h"
+
+// One GEMM call recorded from an application:
+//   C = alpha * op(A) * op(B) + beta * C
+// with op(A) m x k, op(B) k x n, and C m x n, column major.
+struct TracedGemm
+{
+    GemmOpPair ops{ GemmOp::N, GemmOp::N };
+    int m = 0;
+    int n = 0;
+    int k = 0;
+    float alpha = 1;
+    float beta = 0;
+
+    // Leading dimensions of the stored A, B, and C.
+    int lda = 0;
+    int ldb = 0;
+    int ldc = 0;
+
+    // The application's stream.  Calls on a stream run in trace order.
+    int stream = 0;
+
+    // Indices of earlier calls (on other streams) that must
+    // finish before this one starts.
+    std::vector<size_t> after;
+
+    // Where the call is in the trace file, for reporting.
+    size_t lineNumber = 0;
+
+    // Stored shapes of A and B, which depend on the ops.
+    int GetRowsA(void) const    { return IsTransposed(ops.first) ? k : m; }
+    int GetColsA(void) const    { return IsTransposed(ops.first) ? m : k; }
+    int GetRowsB(void) const    { return IsTransposed(ops.second) ? n : k; }
+    int GetColsB(void) const    { return IsTransposed(ops.second) ? k : n; }
+
+    size_t GetNumStoredA(void) const    { return static_cast<size_t>(lda) * GetColsA(); }
+    size_t GetNumStoredB(void) const    { return static_cast<size_t>(ldb) * GetColsB(); }
+    size_t GetNumStoredC(void) const    { return static_cast<size_t>(ldc) * n; }
+
+    double GetFlopCount(void) const     { return 2.0 * m * n * k; }
+};
+
+// A recorded sequence of GEMM calls, in the order the application
+// issued them.
+struct GemmTrace
+{
+    std::vector<TracedGemm> calls;
+
+    // One more than the largest stream number used.
+    int nStreams = 0;
+};
+
+// Read a GEMM trace.  Each line that is not blank or a comment
+// (starting with '#') is one call:
+//   OPS m n k [key=value ...]
+// where OPS is two of N, T, or C (as for --ops), and the optional
+// keys are:
+//   alpha, beta    the scalars (default 1 and 0)
+//   lda, ldb, ldc  the leading dimensions (default the smallest allowed)
+//   stream         the application's stream, from 0 (default 0)
+//   after          comma-separated indices (from 0, in trace order)
+//                  of earlier calls that must finish first
+// For example,
+//   NT 4096 4096 64 alpha=0.5 beta=1 stream=1 after=3,7
+// The name is used in error messages.
+inline
+GemmTrace
+ReadGemmTrace(std::istream& is, const std::string& name)
+{
+    // Streams are created for the replay, so keep their number modest.
+    constexpr int maxStreams = 64;
+
+    GemmTrace ret;
+    std::string line;
+    size_t lineNumber = 0;
+    while(std::getline(is, line))
+    {
+        ++lineNumber;
+        auto fail = [&name, lineNumber](const std::string& what) {
+            return std::invalid_argument(name + ':' + std::to_string(lineNumber) + ": " + what);
+        };
+
+        std::istringstream fields(line);
+        std::string opsName;
+        if( not (fields >> opsName) or (opsName[0] == '#') )
+        {
+            continue;
+        }
+
+        TracedGemm call;
+        call.lineNumber = lineNumber;
+        try
+        {
+            auto ops = ParseGemmOpPairList(opsName);
+            if(ops.size() != 1)
+            {
+                throw std::invalid_argument("expected one GEMM op pair, like NT");
+            }
+            call.ops = ops[0];
+        }
+        catch(const std::invalid_argument& e)
+        {
+            throw fail(e.what());
+        }
+
+        if( not (fields >> call.m >> call.n >> call.k)
+            or (call.m <= 0) or (call.n <= 0) or (call.k <= 0) )
+        {
+            throw fail("expected m, n, and k, each >=1, after the ops");
+        }
+
+        std::string field;
+        while(fields >> field)
+        {
+            auto eq = field.find('=');
+            if(eq == std::string::npos)
+            {
+                throw fail("expected key=value, got '" + field + "'");
+            }
+            auto key = field.substr(0, eq);
+            auto val = field.substr(eq + 1);
+            try
+            {
+                if(key == "alpha")
+                {
+                    call.alpha = std::stof(val);
+                }
+                else if(key == "beta")
+                {
+                    call.beta = std::stof(val);
+                }
+                else if(key == "lda")
+                {
+                    call.lda = ParseSizeValue<int>(val, field);
+                }
+                else if(key == "ldb")
+                {
+                    call.ldb = ParseSizeValue<int>(val, field);
+                }
+                else if(key == "ldc")
+                {
+                    call.ldc = ParseSizeValue<int>(val, field);
+                }
+                else if(key == "stream")
+                {
+                    call.stream = ParseSizeValue<int>(val, field);
+                }
+                else if(key == "after")
+                {
+                    for(auto idx : ParseSizeList<long long>(val))
+                    {
+                        if( (idx < 0) or (static_cast<size_t>(idx) >= ret.calls.size()) )
+                        {
+                            throw std::invalid_argument("after must name earlier calls");
+                        }
+                        call.after.push_back(static_cast<size_t>(idx));
+                    }
+                }
+                else
+                {
+                    throw std::invalid_argument("unknown key '" + key + "'");
+                }
+            }
+            catch(const std::invalid_argument& e)
+            {
+                throw fail(e.what());
+            }
+        }
+
+        // Unspecified leading dimensions are the smallest allowed.
+        call.lda = (call.lda == 0) ? call.GetRowsA() : call.lda;
+        call.ldb = (call.ldb == 0) ? call.GetRowsB() : call.ldb;
+        call.ldc = (call.ldc == 0) ? call.m : call.ldc;
+        if( (call.lda < call.GetRowsA()) or (call.ldb < call.GetRowsB()) or (call.ldc < call.m) )
+        {
+            throw fail("leading dimensions must be at least the stored rows");
+        }
+        if( (call.stream < 0) or (call.stream >= maxStreams) )
+        {
+            throw fail("stream must be in [0, " + std::to_string(maxStreams) + ')');
+        }
+
+        ret.nStreams = std::max(ret.nStreams, call.stream + 1);
+        ret.calls.push_back(std::move(call));
+    }
+
+    if(ret.calls.empty())
+    {
+        throw std::invalid_argument(name + ": no GEMM calls in trace");
+    }
+    return ret;
+}
+
+inline
+GemmTrace
+LoadGemmTrace(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if(not ifs)
+    {
+        throw std::runtime_error("cannot open GEMM trace " + path);
+    }
+    return ReadGemmTrace(ifs, path);
+}
+
+#endif // GEMM_TRACE_H
@@ -0,0 +1,222 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef GEMV_TESTER_H
+#define GEMV_TESTER_H
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "HipStream.h"
+#include "Matrix.h"
+#include "MatrixChecker.h"
+#include "GemmInputs.h"
+#include "GemmOp.h"
+#include "ReferenceGemm.h"
+#include "Trace.h"
+
+// Tests y = alpha * op(A) * x + beta * y, with A stored m x n
+// and the op fixed at compile time.  As in BLAS, x has as many
+// elements as op(A) has columns, and y as many as it has rows.
+// Vectors are column matrices.
+template<GemmOp Op = GemmOp::N>
+class GemvTester
+{
+protected:
+    Matrix<float> A;
+    Matrix<float> x;
+    Matrix<float> y;
+
+    float alpha;
+    float beta;
+
+    const HipStream& hipStream;
+
+    // How the inputs are filled, and the initial value of y.
+    InitOptions init;
+    std::vector<float> initialY;
+
+    // Fill A, x, and y with small integers, so that every partial
+    // sum is an integer no larger than 2 * GetLengthX() and the
+    // result is exact for alpha and beta with few significant bits:
+    // A[r, c] = ((r + 2c) % 5) - 2, x[i] = (i % 3) - 1,
+    // and y[i] = (i % 4) - 1.
+    void FillPatternInputs(void)
+    {
+        for(auto c = 0; c < A.GetNumCols(); ++c)
+        {
+            for(auto r = 0; r < A.GetNumRows(); ++r)
+            {
+                A.El(r, c) = static_cast<float>(((r + 2 * c) % 5) - 2);
+            }
+        }
+        for(auto i = 0; i < GetLengthX(); ++i)
+        {
+            x.El(i, 0) = static_cast<float>((i % 3) - 1);
+        }
+        for(auto i = 0; i < GetLengthY(); ++i)
+        {
+            y.El(i, 0) = static_cast<float>((i % 4) - 1);
+        }
+    }
+
+    // Fill the inputs and copy them to the device.
+    void InitInputs(void)
+    {
+        TraceSpan span("InitInputs", "init");
+
+        if(init.lean)
+        {
+            throw std::invalid_argument("lean mode is not supported for GEMV");
+        }
+
+        if(init.random)
+        {
+            std::mt19937 genA(init.seed);
+            std::mt19937 genX(init.seed + 1);
+            std::mt19937 genY(init.seed + 2);
+            FillRandom(A, genA);
+            FillRandom(x, genX);
+            FillRandom(y, genY);
+        }
+        else
+        {
+            FillPatternInputs();
+        }
+
+        // Reading back the result overwrites the host copy of y.
+        initialY.assign(y.GetHostData(), y.GetHostData() + y.GetNumStoredItems());
+
+        A.CopyHostToDeviceAsync(hipStream);
+        x.CopyHostToDeviceAsync(hipStream);
+        y.CopyHostToDeviceAsync(hipStream);
+    }
+
+public:
+    GemvTester(int m,
+                int n,
+                float _alpha,
+                float _beta,
+                const HipStream& _hipStream,
+                const InitOptions& _init = InitOptions())
+      : A(m, n, _init.layout),
+        x(IsTransposed(Op) ? m : n, 1),
+        y(IsTransposed(Op) ? n : m, 1),
+        alpha(_alpha),
+        beta(_beta),
+        hipStream(_hipStream),
+        init(_init)
+    {
+        InitInputs();
+    }
+
+    virtual ~GemvTester(void)
+    {
+        // nothing to do.
+    }
+
+    void DumpTo(std::ostream& os) const
+    {
+        os << "alpha: " << alpha
+            << "\nbeta: " << beta
+            << "\nA: " << A
+            << "\nx: " << x
+            << "\ny: " << y
+            << std::endl;
+    }
+
+    // Enqueue the GEMV on our stream, without waiting for it
+    // to complete or reading its result back to the host.
+    virtual void Enqueue(void) = 0;
+
+    // Do the GEMV and read its result back to the host.
+    void Do(void)
+    {
+        Enqueue();
+        y.CopyDeviceToHostAsync(hipStream);
+        hipStream.Synchronize();
+    }
+
+    // Restore y on the device to its initial value, in case
+    // repeated calls have overwritten it.
+    void ResetOutput(void)
+    {
+        std::copy(initialY.begin(), initialY.end(), y.GetHostData());
+        y.CopyHostToDeviceAsync(hipStream);
+    }
+
+    // The dimensions of the stored A.
+    int GetM(void) const    { return A.GetNumRows(); }
+    int GetN(void) const    { return A.GetNumCols(); }
+
+    int GetLengthX(void) const  { return x.GetNumRows(); }
+    int GetLengthY(void) const  { return y.GetNumRows(); }
+
+    int GetLda(void) const  { return A.GetLeadingDim(); }
+
+    // The op, like "T".
+    static std::string GetOpName(void)  { return std::string(1, ::GetOpName(Op)); }
+
+    // Number of floating point operations done by one call.
+    double GetFlopCount(void) const     { return 2.0 * GetM() * GetN(); }
+
+    // Number of bytes one call must move to or from device memory:
+    // A and x are read, y is written, and y is also read unless
+    // beta is zero.
+    double GetBytesMoved(void) const
+    {
+        double nItems = static_cast<double>(GetM()) * GetN()
+            + GetLengthX()
+            + ((beta != 0) ? 2.0 : 1.0) * GetLengthY();
+        return nItems * sizeof(float);
+    }
+
+    // Compare y against the result of a host reference GEMM with
+    // one column.  With pattern inputs, the result is exact.
+    // Unless quiet, describe the outcome on standard output.
+    CheckResult CheckComputation(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
+    {
+        TraceSpan span("CheckComputation", "check");
+
+        std::vector<float> expectedY(initialY);
+        ReferenceGemm<float, float>(IsTransposed(Op),
+                                    false,
+                                    GetLengthY(),
+                                    1,
+                                    GetLengthX(),
+                                    alpha,
+                                    A.GetHostData(),
+                                    A.GetLeadingDim(),
+                                    x.GetHostData(),
+                                    x.GetLeadingDim(),
+                                    beta,
+                                    expectedY.data(),
+                                    y.GetLeadingDim(),
+                                    opts.nThreads);
+
+        auto fillExpected = [&expectedY](int, float* expected) {
+            std::copy(expectedY.begin(), expectedY.end(), expected);
+        };
+        auto result = CheckMatrix(y,
+                                    fillExpected,
+                                    init.random ? WithRandomInputTolerance<float>(opts, GetLengthX(), alpha, beta) : opts);
+        if(not quiet)
+        {
+            ReportCheck(std::cout, result);
+        }
+        return result;
+    }
+};
+
+template<GemmOp Op>
+std::ostream&
+operator<<(std::ostream& os, const GemvTester<Op>& tester)
+{
+    tester.DumpTo(os);
+    return os;
+}
+
+#endif // GEMV_TESTER_H
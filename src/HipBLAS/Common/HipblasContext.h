@@ -0,0 +1,54 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_HIPBLAS_CONTEXT_H
+#define TEST_HIPBLAS_CONTEXT_H
+
+#include "hip/hip_runtime_api.h"
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipblasException.h"
+#include "Trace.h"
+
+class HipblasContext
+{
+private:
+    hipblasHandle_t handle;
+
+    // The handle's pointer mode, so testers sharing the handle
+    // can switch it only when it needs to change.
+    mutable hipblasPointerMode_t pointerMode;
+
+public:
+    HipblasContext(const HipStream& stream)
+    {
+        TraceSpan span("hipblasCreate", "setup");
+        CHECK(hipblasCreate(&handle));
+        CHECK(hipblasSetStream(handle, stream.GetHandle()));
+        CHECK(hipblasGetPointerMode(handle, &pointerMode));
+    }
+
+    // The handle is shared by reference, never duplicated.
+    HipblasContext(const HipblasContext&) = delete;
+    HipblasContext& operator=(const HipblasContext&) = delete;
+
+    ~HipblasContext(void)
+    {
+        // std::cerr << "In ~HipblasContext" << std::endl;
+        CHECK(hipblasDestroy(handle));
+    }
+
+    hipblasHandle_t GetHandle(void) const   { return handle; }
+
+    // Have the handle read scalars (e.g., alpha and beta) from host
+    // memory or device memory, as given.
+    void UsePointerMode(hipblasPointerMode_t mode) const
+    {
+        if(mode != pointerMode)
+        {
+            CHECK(hipblasSetPointerMode(handle, mode));
+            pointerMode = mode;
+        }
+    }
+};
+
+#endif // TEST_HIPBLAS_CONTEXT_H
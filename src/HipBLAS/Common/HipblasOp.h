@@ -0,0 +1,17 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HIPBLAS_OP_H
+#define HIPBLAS_OP_H
+
+#include "hipblas.h"
+#include "GemmOp.h"
+
+// The hipBLAS equivalent of a GemmOp.
+constexpr
+hipblasOperation_t
+ToHipblasOperation(GemmOp op)
+{
+    return (op == GemmOp::N) ? HIPBLAS_OP_N : ((op == GemmOp::T) ? HIPBLAS_OP_T : HIPBLAS_OP_C);
+}
+
+#endif // HIPBLAS_OP_H
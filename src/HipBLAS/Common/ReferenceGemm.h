@@ -0,0 +1,80 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef REFERENCE_GEMM_H
+#define REFERENCE_GEMM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "BlockedGemm.h"
+#include "Trace.h"
+
+// A host GEMM for checking results computed by GPU libraries:
+//   C = alpha * op(A) * op(B) + beta * C
+// with column major storage, op(A) m x k, op(B) k x n, and C m x n.
+// Elements are converted to ComputeType (float by default) as they
+// are loaded, so this works for any InType/OutType combination
+// the GemmEx testers use, and it does not depend on HIP.
+//
+// The tiles of C computed by BlockedGemm are handed out to host threads.
+template<typename InType, typename OutType, typename ComputeType = float>
+void
+ReferenceGemm(bool transA,
+                bool transB,
+                int m,
+                int n,
+                int k,
+                ComputeType alpha,
+                const InType* A,
+                size_t lda,
+                const InType* B,
+                size_t ldb,
+                ComputeType beta,
+                OutType* C,
+                size_t ldc,
+                unsigned int nThreads = 0)
+{
+    TraceSpan span("ReferenceGemm", "check");
+
+    using Gemm = BlockedGemm<InType, OutType, ComputeType>;
+    Gemm gemm(transA, transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    auto nTiles = gemm.GetNumTiles();
+    if(nTiles == 0)
+    {
+        return;
+    }
+
+    if(nThreads == 0)
+    {
+        nThreads = std::thread::hardware_concurrency();
+    }
+    nThreads = std::max(1u, std::min(nThreads, static_cast<unsigned int>(nTiles)));
+
+    std::atomic<int> nextTile(0);
+    auto worker = [&]() {
+        typename Gemm::Workspace ws;
+        for(auto tile = nextTile++; tile < nTiles; tile = nextTile++)
+        {
+            gemm.ComputeTile(tile, ws);
+        }
+    };
+
+    if(nThreads == 1)
+    {
+        worker();
+        return;
+    }
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < nThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    for(auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+#endif // REFERENCE_GEMM_H
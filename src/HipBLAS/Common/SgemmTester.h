@@ -2,16 +2,33 @@
 // See LICENSE.txt in the root of the source distribution for license info.
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "HipGraph.h"
 #include "HipStream.h"
 #include "Matrix.h"
+#include "MatrixChecker.h"
+#include "ChecksumVerifier.h"
+#include "GemmInputs.h"
+#include "GemmOp.h"
+#include "ReferenceGemm.h"
+#include "Trace.h"
 
-template<bool Transpose = false>
+// Tests C = alpha * op(A) * op(B) + beta * C, with op(A) m x k
+// and op(B) k x n, where the ops are fixed at compile time.
+template<GemmOp OpA = GemmOp::N, GemmOp OpB = GemmOp::N>
 class SgemmTester
 {
 protected:
     // Our matrices.
-    // We define a D matrix even if the GEMM library we use doesn't use it.
+    // We define a D matrix even if the GEMM library we use doesn't use it,
+    // but since Matrix storage is allocated on first use, it costs nothing.
     Matrix<float> A;
     Matrix<float> B;
     Matrix<float> C;
@@ -22,25 +39,43 @@ protected:
 
     const HipStream& hipStream;
 
-    // Create the input matrices with known values.
+    // How the inputs are filled, and the initial value of C
+    // (not kept in lean mode).
+    InitOptions init;
+    std::vector<float> initialC;
+
+    // Sums of the inputs, for checking the output with checksums.
+    // Only built if init.checksums is set.
+    std::unique_ptr<ChecksumVerifier<float>> checksums;
+
+    // A captured sequence of GEMMs to replay, if CaptureGraph succeeded.
+    std::unique_ptr<HipGraph> graph;
+
+    // Fill the input matrices with a pattern whose result is known.
     // Current test is:
-    // * Items in col 0 of A are all 1.  Otherwise 0.
+    // * Items in logical col 0 of A are all 1.  Otherwise 0.
     // * Items in logical row 0 of B are all 1.  Otherwise 0.
-    // * Storage for B in memory may be transposed.
+    // * Storage for A and B in memory may be transposed.
     // * C[r, c] = r*c.
     // After the SGEMM, C[r,c] should be alpha + beta * r * c
-    void InitMatrices(void)
+    void FillPatternInputs(void)
     {
-        for(auto r = 0; r < A.GetNumRows(); ++r)
+        for(auto r = 0; r < GetM(); ++r)
         {
-            A.El(r, 0) = 1;
+            if(IsTransposed(OpA))
+            {
+                A.El(0, r) = 1;
+            }
+            else
+            {
+                A.El(r, 0) = 1;
+            }
         }
-        A.CopyHostToDeviceAsync(hipStream);
 
-        for(auto c = 0; c < (Transpose ? B.GetNumRows() : B.GetNumCols()); ++c)
+        for(auto c = 0; c < GetN(); ++c)
         {
             auto val = 1;
-            if(Transpose)
+            if(IsTransposed(OpB))
             {
                 B.El(c, 0) = val;
             }
@@ -49,16 +84,152 @@ protected:
                 B.El(0, c) = val;
             }
         }
-        B.CopyHostToDeviceAsync(hipStream);
 
         for(auto c = 0; c < C.GetNumCols(); ++c)
         {
             for(auto r = 0; r < C.GetNumRows(); ++r)
             {
-                C.El(r, c) = r*c;
+                C.El(r, c) = static_cast<int64_t>(r) * c;
             }
         }
-        C.CopyHostToDeviceAsync(hipStream);
+    }
+
+    // Fill A, B, and C with random values in [-1, 1].
+    // Each matrix has its own generator, so its values
+    // depend only on the seed and its own shape.
+    void FillRandomInputs(void)
+    {
+        std::mt19937 genA(init.seed);
+        std::mt19937 genB(init.seed + 1);
+        std::mt19937 genC(init.seed + 2);
+        FillRandom(A, genA);
+        FillRandom(B, genB);
+        FillRandom(C, genC);
+    }
+
+    // Write C's initial pattern (see FillPatternInputs) to the device
+    // through a host buffer of GetChunkCols columns, waiting for it.
+    void UploadPatternC(void)
+    {
+        auto colBytes = static_cast<size_t>(GetM()) * sizeof(float);
+        auto chunkCols = static_cast<int>(GetChunkCols(colBytes, GetN()));
+        Matrix<float> buffer(GetM(), chunkCols);
+        for(auto firstCol = 0; firstCol < GetN(); firstCol += chunkCols)
+        {
+            auto lastCol = std::min(GetN(), firstCol + chunkCols);
+            for(auto c = firstCol; c < lastCol; ++c)
+            {
+                for(auto r = 0; r < GetM(); ++r)
+                {
+                    buffer.El(r, c - firstCol) = static_cast<int64_t>(r) * c;
+                }
+            }
+            CHECK(hipMemcpy2DAsync(&C.GetDeviceData()[static_cast<size_t>(firstCol) * C.GetLeadingDim()],
+                                    C.GetLeadingDim() * sizeof(float),
+                                    buffer.GetHostData(),
+                                    colBytes,
+                                    colBytes,
+                                    lastCol - firstCol,
+                                    hipMemcpyHostToDevice,
+                                    hipStream.GetHandle()));
+
+            // The buffer is refilled for the next chunk.
+            hipStream.Synchronize();
+        }
+    }
+
+    // Lean mode's version of FillPatternInputs, writing the pattern
+    // straight to device storage, which starts zeroed: the ones in
+    // A and B are copied from a small host vector with 2D copies
+    // that step over the matrix, and C is streamed in chunks.
+    void FillPatternInputsOnDevice(void)
+    {
+        Matrix<float> ones(std::max(GetM(), GetN()), 1);
+        for(auto i = 0; i < ones.GetNumRows(); ++i)
+        {
+            ones.El(i, 0) = 1;
+        }
+
+        // Logical col 0 of A is stored as col 0, or as row 0 if transposed.
+        auto aPitch = (IsTransposed(OpA) ? A.GetLeadingDim() : 1) * sizeof(float);
+        CHECK(hipMemcpy2DAsync(A.GetDeviceData(), aPitch,
+                                ones.GetHostData(), sizeof(float),
+                                sizeof(float), GetM(),
+                                hipMemcpyHostToDevice,
+                                hipStream.GetHandle()));
+
+        // Logical row 0 of B is stored as row 0, or as col 0 if transposed.
+        auto bPitch = (IsTransposed(OpB) ? 1 : B.GetLeadingDim()) * sizeof(float);
+        CHECK(hipMemcpy2DAsync(B.GetDeviceData(), bPitch,
+                                ones.GetHostData(), sizeof(float),
+                                sizeof(float), GetN(),
+                                hipMemcpyHostToDevice,
+                                hipStream.GetHandle()));
+
+        // This also waits for the copies from ones.
+        UploadPatternC();
+    }
+
+    // Put C's initial value back in its host copy.
+    void RestoreHostC(void)
+    {
+        std::copy(initialC.begin(), initialC.end(), C.GetHostData());
+    }
+
+    // Fill the input matrices and copy them to the device.
+    void InitMatrices(void)
+    {
+        TraceSpan span("InitMatrices", "init");
+
+        if(init.lean)
+        {
+            if(init.random or init.checksums)
+            {
+                throw std::invalid_argument("lean mode supports only pattern inputs, verified in full");
+            }
+            FillPatternInputsOnDevice();
+            return;
+        }
+
+        if(init.random)
+        {
+            FillRandomInputs();
+        }
+        else
+        {
+            FillPatternInputs();
+        }
+
+        // Keep C's initial value, since reading back
+        // the GEMM's result overwrites the host copy.
+        initialC.resize(C.GetNumStoredItems());
+        for(size_t i = 0; i < C.GetNumStoredItems(); ++i)
+        {
+            initialC[i] = ToFloat(C.GetHostData()[i]);
+        }
+
+        if(not init.hostOnly)
+        {
+            A.CopyHostToDeviceAsync(hipStream);
+            B.CopyHostToDeviceAsync(hipStream);
+            C.CopyHostToDeviceAsync(hipStream);
+        }
+
+        if(init.checksums)
+        {
+            checksums = std::make_unique<ChecksumVerifier<float>>(IsTransposed(OpA),
+                                                                  IsTransposed(OpB),
+                                                                  GetM(),
+                                                                  GetN(),
+                                                                  GetK(),
+                                                                  alpha,
+                                                                  A.GetHostData(),
+                                                                  A.GetLeadingDim(),
+                                                                  B.GetHostData(),
+                                                                  B.GetLeadingDim(),
+                                                                  beta);
+            checksums->SetInput(C.GetHostData(), C.GetLeadingDim());
+        }
 
         // We don't need to initialize any values in D. 
         // Either it is only used as an output, or
@@ -73,14 +244,16 @@ public:
                     int k,
                     float _alpha,
                     float _beta,
-                    const HipStream& _hipStream)
-      : A(m, k),
-        B( Transpose ? n : k, Transpose ? k : n ),
-        C(m, n),
-        D(m, n),
+                    const HipStream& _hipStream,
+                    const InitOptions& _init = InitOptions())
+      : A( IsTransposed(OpA) ? k : m, IsTransposed(OpA) ? m : k, _init.layout ),
+        B( IsTransposed(OpB) ? n : k, IsTransposed(OpB) ? k : n, _init.layout ),
+        C(m, n, _init.layout),
+        D(m, n, _init.layout),
         alpha(_alpha),
         beta(_beta),
-        hipStream(_hipStream)
+        hipStream(_hipStream),
+        init(_init)
     {
         InitMatrices();
     }
@@ -96,42 +269,233 @@ public:
             << "\nbeta: " << beta
             << "\nA: " << A
             << "\nB: " << B
-            << "\nC: " << C
-            << "\nD: " << D
-            << std::endl;
+            << "\nC: " << C;
+        if(this->UsesD())
+        {
+            os << "\nD: " << D;
+        }
+        os << std::endl;
     }
 
+    // Enqueue the GEMM on our stream, without waiting for it
+    // to complete or reading its result back to the host.
+    virtual void EnqueueSgemm(void) = 0;
+
+    // Do the GEMM and read its result back to the host.
     virtual void DoSgemm(void) = 0;
+
+    // Restore C on the device to its initial value, in case
+    // repeated GEMMs have overwritten it.
+    // The host copy of C must not be the target of a
+    // download that is still in progress.
+    // In lean mode, this waits for C to be rewritten.
+    // If the matrices are host only, only the host copy is restored.
+    void ResetOutput(void)
+    {
+        if(init.lean)
+        {
+            UploadPatternC();
+            return;
+        }
+        RestoreHostC();
+        if(not init.hostOnly)
+        {
+            C.CopyHostToDeviceAsync(hipStream);
+        }
+    }
+
+    bool IsLean(void) const     { return init.lean; }
+
+    // For running a queue of GEMMs through this tester's matrices:
+    // enqueue the uploads of all the inputs, as if for a new problem.
+    // As with ResetOutput, no download into C may be in progress.
+    void EnqueueUpload(void)
+    {
+        RestoreHostC();
+        A.CopyHostToDeviceAsync(hipStream);
+        B.CopyHostToDeviceAsync(hipStream);
+        C.CopyHostToDeviceAsync(hipStream);
+    }
+
+    // Enqueue the download of the GEMM's result.
+    void EnqueueDownload(void)
+    {
+        (this->UsesD() ? D : C).CopyDeviceToHostAsync(hipStream);
+    }
+
+    // Enqueue nGemms GEMMs, with the input uploads before them and
+    // the output download after them if withCopies.  The uploads
+    // send the host matrices as they are; repeating the sequence
+    // is safe because the download is ordered before the next upload.
+    void EnqueueSequence(int nGemms, bool withCopies)
+    {
+        if(withCopies)
+        {
+            A.CopyHostToDeviceAsync(hipStream);
+            B.CopyHostToDeviceAsync(hipStream);
+            C.CopyHostToDeviceAsync(hipStream);
+        }
+        for(auto i = 0; i < nGemms; ++i)
+        {
+            EnqueueSgemm();
+        }
+        if(withCopies)
+        {
+            EnqueueDownload();
+        }
+    }
+
+    // Capture EnqueueSequence(nGemms, withCopies) on our stream into
+    // a graph for EnqueueGraph to replay.  Returns false, saying why
+    // in whyNot, if the runtime or library can't capture it; the
+    // tester can still be used with direct submission.
+    bool CaptureGraph(int nGemms, bool withCopies, std::string& whyNot)
+    {
+        TraceSpan span("CaptureGraph", "setup");
+
+        graph.reset();
+        auto enqueue = [this, nGemms, withCopies](void) {
+            EnqueueSequence(nGemms, withCopies);
+        };
+        graph = HipGraph::TryCapture(hipStream, enqueue, whyNot);
+        return static_cast<bool>(graph);
+    }
+
+    bool HasGraph(void) const   { return static_cast<bool>(graph); }
+
+    // Enqueue a replay of the GEMMs captured by CaptureGraph.
+    void EnqueueGraph(void)
+    {
+        if(not graph)
+        {
+            throw std::logic_error("no GEMMs have been captured");
+        }
+        graph->Launch(hipStream);
+    }
+
+    // The GEMM's dimensions: op(A) is m x k, op(B) is k x n.
+    int GetM(void) const    { return C.GetNumRows(); }
+    int GetN(void) const    { return C.GetNumCols(); }
+    int GetK(void) const    { return IsTransposed(OpA) ? A.GetNumRows() : A.GetNumCols(); }
+
+    static GemmOpPair GetOps(void)  { return { OpA, OpB }; }
+
+    // The ops for A and B, like "NT".
+    static std::string GetOpsName(void)    { return GetOpPairName({ OpA, OpB }); }
+
+    // Leading dimensions of the stored matrices.
+    int GetLda(void) const  { return A.GetLeadingDim(); }
+    int GetLdb(void) const  { return B.GetLeadingDim(); }
+    int GetLdc(void) const  { return C.GetLeadingDim(); }
+
+    // The host copies of the stored matrices, for callers that move
+    // them to the device themselves (see RunTiled).  C holds its
+    // initial value until the GEMM's result is written over it.
+    const float* GetHostA(void) const   { return A.GetHostData(); }
+    const float* GetHostB(void) const   { return B.GetHostData(); }
+    float* GetHostC(void)   { return C.GetHostData(); }
+
+    // Number of floating point operations done by one GEMM.
+    double GetFlopCount(void) const
+    {
+        return 2.0 * GetM() * GetN() * GetK();
+    }
     
-    void CheckComputation(void) const
+    // Compare the GEMM's output against the expected values:
+    // C[r,c] = alpha + beta * r * c for the pattern inputs, or
+    // the result of a host reference GEMM for random inputs.
+    // Unless quiet, describe the outcome on standard output.
+    CheckResult CheckComputation(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
     {
+        TraceSpan span("CheckComputation", "check");
+
         auto& outputMatrix = this->UsesD() ? D : C;
 
-        // Assumes column major ordering.
-        uint32_t nMismatches = 0;
-        for(auto c = 0; c < outputMatrix.GetNumCols(); c++)
+        CheckResult result;
+        if(init.random)
         {
-            for(auto r = 0; r < outputMatrix.GetNumRows(); r++)
-            {
-                auto expVal = (alpha + beta * r * c);
-                auto compVal = outputMatrix.El(r,c);
-                if(compVal != expVal)
+            std::vector<float> expectedC(initialC);
+            ReferenceGemm<float, float>(IsTransposed(OpA),
+                                        IsTransposed(OpB),
+                                        GetM(),
+                                        GetN(),
+                                        GetK(),
+                                        alpha,
+                                        A.GetHostData(),
+                                        A.GetLeadingDim(),
+                                        B.GetHostData(),
+                                        B.GetLeadingDim(),
+                                        beta,
+                                        expectedC.data(),
+                                        C.GetLeadingDim(),
+                                        opts.nThreads);
+
+            auto fillExpected = [this, &expectedC](int c, float* expected) {
+                std::copy_n(&expectedC[static_cast<size_t>(c) * C.GetLeadingDim()], C.GetNumRows(), expected);
+            };
+            result = CheckMatrix(outputMatrix,
+                                    fillExpected,
+                                    WithRandomInputTolerance<float>(opts, GetK(), alpha, beta));
+        }
+        else
+        {
+            auto fillExpected = [this](int c, float* expected) {
+                for(auto r = 0; r < C.GetNumRows(); ++r)
                 {
-                    ++nMismatches;
-                    std::cout << "mismatch at: (" << r << ", " << c << ")"
-                        << " expected " << expVal
-                        << ", got " << compVal
-                        << std::endl;
+                    expected[r] = alpha + beta * static_cast<float>(static_cast<int64_t>(r) * c);
                 }
-            }
+            };
+            // In lean mode, the output is only on the device.
+            result = init.lean
+                ? CheckMatrixStreamed(outputMatrix, fillExpected, opts)
+                : CheckMatrix(outputMatrix, fillExpected, opts);
+        }
+        if(not quiet)
+        {
+            ReportCheck(std::cout, result);
+        }
+        return result;
+    }
+
+    // Check the GEMM's output using row and column checksums
+    // (see ChecksumVerifier), in O(mn) time rather than the O(mnk)
+    // of CheckComputation with random inputs.
+    // Requires that the tester was built with init.checksums set.
+    // Unless quiet, describe the outcome on standard output.
+    ChecksumResult CheckChecksums(const CheckOptions& opts = CheckOptions(),
+                                    bool quiet = false) const
+    {
+        TraceSpan span("CheckChecksums", "check");
+
+        if(not checksums)
+        {
+            throw std::logic_error("checksums were not requested when the inputs were initialized");
+        }
+        auto& outputMatrix = this->UsesD() ? D : C;
+        auto result = checksums->Check(outputMatrix.GetHostData(), outputMatrix.GetLeadingDim());
+        if(not quiet)
+        {
+            ReportChecksums(std::cout, result, opts.maxReported);
+        }
+        return result;
+    }
+
+    // For soak tests that repeat the GEMM on its own output:
+    // take the output now on the host as the next GEMM's input C.
+    // (If we use D, the GEMM's input C doesn't change.)
+    void ChainChecksums(void)
+    {
+        if(checksums and not this->UsesD())
+        {
+            checksums->SetInput(C.GetHostData(), C.GetLeadingDim());
         }
-        std::cout << "Total mismatches: " << nMismatches << std::endl;
     }
 };
 
-template<bool Transpose>
+template<GemmOp OpA, GemmOp OpB>
 std::ostream&
-operator<<(std::ostream& os, const SgemmTester<Transpose>& tester)
+operator<<(std::ostream& os, const SgemmTester<OpA, OpB>& tester)
 {
     tester.DumpTo(os);
     return os;
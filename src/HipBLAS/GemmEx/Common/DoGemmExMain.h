@@ -0,0 +1,166 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef DO_GEMMEX_MAIN_H
+#define DO_GEMMEX_MAIN_H
+
+#include <iostream>
+#include <vector>
+#include "CommandLine.h"
+#include "HipStream.h"
+#include "Benchmark.h"
+#include "MemoryPool.h"
+#include "ResultsWriter.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// For each problem shape, time repeated GemmEx calls, then do one
+// more and report its throughput next to its accuracy: the max and
+// mean error against a float reference (unrounded), plus whether it
+// matches the reference rounded to OutType within the tolerances.
+// Use --init random for meaningful errors; the pattern inputs
+// are exact in most types.
+template<typename TesterType>
+int
+DoGemmExMain(int argc, char* argv[])
+{
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::vector<int> ms;
+        std::vector<int> ks;
+        std::vector<int> ns;
+        float alpha;
+        float beta;
+        bool verbose;
+        RunOptions runOpts;
+
+        // alpha and beta are read as floats, and converted to
+        // the tester's compute type.
+        std::tie(shouldRun,
+                    ret,
+                    ms,
+                    ks,
+                    ns,
+                    alpha,
+                    beta,
+                    verbose,
+                    runOpts) = ParseCommandLine<float>(argc, argv);
+
+        if(shouldRun)
+        {
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            TransferChunkBytes() = runOpts.transferChunkBytes;
+
+            using ComputeType = typename TesterType::ComputeType;
+
+            HipStream hipStream;
+            typename TesterType::ContextType libContext(hipStream);
+
+            std::cout << "# inputs: " << (runOpts.init.random ? "random" : "pattern") << '\n'
+                << "m,n,k,in_type,out_type,compute_type,min_ms,median_ms,gflops,max_abs_err,mean_abs_err,mismatches,status"
+                << std::endl;
+            for(auto m : ms)
+            {
+                for(auto n : ns)
+                {
+                    for(auto k : ks)
+                    {
+                        TesterType tester(m, n, k,
+                                            static_cast<ComputeType>(alpha),
+                                            static_cast<ComputeType>(beta),
+                                            hipStream,
+                                            libContext,
+                                            runOpts.init);
+                        hipStream.Synchronize();
+
+                        auto samples = TimeOnStream(hipStream,
+                                                    runOpts.bench,
+                                                    [&tester](){ tester.EnqueueGemmEx(); });
+                        TimingStats stats(samples);
+
+                        tester.ResetOutput();
+                        tester.DoGemmEx();
+                        if(verbose)
+                        {
+                            std::cout << tester << std::endl;
+                        }
+
+                        auto check = tester.CheckComputation(runOpts.check, true);
+                        auto error = tester.MeasureError(runOpts.check);
+                        std::cout << m << ',' << n << ',' << k
+                            << ',' << TesterType::GetInTypeName()
+                            << ',' << TesterType::GetOutTypeName()
+                            << ',' << TesterType::GetComputeTypeName()
+                            << ',' << stats.minMs
+                            << ',' << stats.medianMs
+                            << ',' << ToGflops(tester.GetFlopCount(), stats.medianMs)
+                            << ',' << error.maxAbsErr
+                            << ',' << error.GetMeanAbsErr()
+                            << ',' << check.nMismatches
+                            << ',' << ((check.nMismatches == 0) ? "PASS" : "FAIL")
+                            << std::endl;
+
+                        ResultRecord record;
+                        record.config.Add("kind", "gemmex")
+                            .Add("m", m)
+                            .Add("n", n)
+                            .Add("k", k)
+                            .Add("in_type", TesterType::GetInTypeName())
+                            .Add("out_type", TesterType::GetOutTypeName())
+                            .Add("compute_type", TesterType::GetComputeTypeName())
+                            .Add("init", runOpts.init.random ? "random" : "pattern");
+                        record.metrics.Add("min_ms", stats.minMs)
+                            .Add("median_ms", stats.medianMs)
+                            .Add("gflops", ToGflops(tester.GetFlopCount(), stats.medianMs))
+                            .Add("max_abs_err", error.maxAbsErr)
+                            .Add("mean_abs_err", error.GetMeanAbsErr())
+                            .Add("mismatches", check.nMismatches);
+                        record.samplesMs = samples;
+                        record.passed = (check.nMismatches == 0);
+                        ResultsWriter::Get().Add(std::move(record));
+                    }
+                }
+            }
+
+            std::cout << "# ";
+            ReportPeakMemory(std::cout);
+
+            // Write the trace now, while the HIP runtime is still usable.
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+
+            // A result that failed verification fails the program.
+            if(ResultsWriter::Get().AnyFailed())
+            {
+                ret = 1;
+            }
+            ReleaseMemoryPools();
+        }
+    }
+    catch(const HipException& e)
+    {
+        std::cerr << "HIP Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const typename TesterType::ExceptionType& e)
+    {
+        std::cerr << "hipBLAS Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}
+
+#endif // DO_GEMMEX_MAIN_H
@@ -0,0 +1,104 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HIPBLAS_GEMMEX_TESTER_H
+#define HIPBLAS_GEMMEX_TESTER_H
+
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipblasException.h"
+#include "GemmExTester.h"
+#include "HipblasContext.h"
+#include "Trace.h"
+
+// The hipBLAS data type tag and a printable name for each element type.
+template<typename T>
+struct HipblasDatatype;
+
+template<>
+struct HipblasDatatype<float>
+{
+    static constexpr hipblasDatatype_t value = HIPBLAS_R_32F;
+    static const char* GetName(void)    { return "float"; }
+};
+
+#if defined(TEST_HALF_PRECISION)
+template<>
+struct HipblasDatatype<__half>
+{
+    static constexpr hipblasDatatype_t value = HIPBLAS_R_16F;
+    static const char* GetName(void)    { return "half"; }
+};
+#endif // defined(TEST_HALF_PRECISION)
+
+template<typename InType, typename OutType, bool Transpose = false>
+class HipblasGemmExTester : public GemmExTester<InType, OutType, Transpose>
+{
+public:
+    using ExceptionType = HipblasException;
+    using ContextType = HipblasContext;
+    using typename GemmExTester<InType, OutType, Transpose>::ComputeType;
+
+protected:
+    // The hipBLAS handle to use, bound to our stream,
+    // owned by our caller as with HipblasSgemmTester.
+    const HipblasContext& blasContext;
+
+    bool UsesD(void) const override { return false; }
+
+public:
+    HipblasGemmExTester(int m,
+                        int n,
+                        int k,
+                        OutType alpha,
+                        OutType beta,
+                        const HipStream& hipStream,
+                        const HipblasContext& _blasContext,
+                        const InitOptions& init = InitOptions())
+      : GemmExTester<InType, OutType, Transpose>(m, n, k, alpha, beta, hipStream, init),
+        blasContext(_blasContext)
+    {
+        // nothing else to do.
+    }
+
+    static const char* GetInTypeName(void)      { return HipblasDatatype<InType>::GetName(); }
+    static const char* GetOutTypeName(void)     { return HipblasDatatype<OutType>::GetName(); }
+    static const char* GetComputeTypeName(void) { return HipblasDatatype<ComputeType>::GetName(); }
+
+    // Enqueue the GEMM on the GPU.
+    // alpha and beta are of ComputeType, as hipblasGemmEx requires.
+    void
+    EnqueueGemmEx(void) override
+    {
+        DeviceTraceSpan span("hipblasGemmEx", this->hipStream.GetHandle());
+        CHECK(hipblasGemmEx(blasContext.GetHandle(),
+                            HIPBLAS_OP_N,
+                            Transpose ? HIPBLAS_OP_T : HIPBLAS_OP_N,
+                            this->A.GetNumRows(),
+                            this->C.GetNumCols(),
+                            this->A.GetNumCols(),
+                            &(this->alpha),
+                            this->A.GetDeviceData(),
+                            HipblasDatatype<InType>::value,
+                            this->A.GetLeadingDim(),
+                            this->B.GetDeviceData(),
+                            HipblasDatatype<InType>::value,
+                            this->B.GetLeadingDim(),
+                            &(this->beta),
+                            this->C.GetDeviceData(),
+                            HipblasDatatype<OutType>::value,
+                            this->C.GetLeadingDim(),
+                            HipblasDatatype<ComputeType>::value,
+                            HIPBLAS_GEMM_DEFAULT));
+    }
+
+    // Do the GEMM on the GPU and read the result back.
+    void
+    DoGemmEx(void) override
+    {
+        EnqueueGemmEx();
+        this->C.CopyDeviceToHostAsync(this->hipStream);
+        this->hipStream.Synchronize();
+    }
+};
+
+#endif // HIPBLAS_GEMMEX_TESTER_H
@@ -0,0 +1,10 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include "HipblasGemmExTester.h"
+#include "DoGemmExMain.h"
+
+int
+main(int argc, char* argv[])
+{
+    return DoGemmExMain<HipblasGemmExTester<__half, __half>>(argc, argv);
+}
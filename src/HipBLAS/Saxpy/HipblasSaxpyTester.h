@@ -0,0 +1,63 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HIPBLAS_SAXPY_TESTER_H
+#define HIPBLAS_SAXPY_TESTER_H
+
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipblasException.h"
+#include "AxpyTester.h"
+#include "HipblasContext.h"
+#include "Trace.h"
+
+class HipblasSaxpyTester : public AxpyTester
+{
+public:
+    using ExceptionType = HipblasException;
+    using ContextType = HipblasContext;
+
+    // Whether problems have a second dimension to sweep.
+    static constexpr bool hasN = false;
+
+protected:
+    // The hipBLAS handle to use, bound to our stream,
+    // owned by our caller.
+    const HipblasContext& blasContext;
+
+public:
+    // The length is m, as for the other bandwidth
+    // testers; n and beta are not used.
+    HipblasSaxpyTester(int m,
+                        int /* n */,
+                        float alpha,
+                        float /* beta */,
+                        const HipStream& hipStream,
+                        const HipblasContext& _blasContext,
+                        const InitOptions& init = InitOptions())
+      : AxpyTester(m, alpha, hipStream, init),
+        blasContext(_blasContext)
+    { }
+
+    static const char* GetName(void)    { return "saxpy"; }
+
+    int GetM(void) const    { return GetLength(); }
+    int GetN(void) const    { return 1; }
+
+    // Enqueue the axpy on the GPU.
+    void
+    Enqueue(void) override
+    {
+        blasContext.UsePointerMode(HIPBLAS_POINTER_MODE_HOST);
+
+        DeviceTraceSpan span("hipblasSaxpy", hipStream.GetHandle());
+        CHECK(hipblasSaxpy(blasContext.GetHandle(),
+                            GetLength(),
+                            &alpha,
+                            x.GetDeviceData(),
+                            1,
+                            y.GetDeviceData(),
+                            1));
+    }
+};
+
+#endif // HIPBLAS_SAXPY_TESTER_H
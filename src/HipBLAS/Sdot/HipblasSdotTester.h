@@ -0,0 +1,65 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HIPBLAS_SDOT_TESTER_H
+#define HIPBLAS_SDOT_TESTER_H
+
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipblasException.h"
+#include "DotTester.h"
+#include "HipblasContext.h"
+#include "Trace.h"
+
+class HipblasSdotTester : public DotTester
+{
+public:
+    using ExceptionType = HipblasException;
+    using ContextType = HipblasContext;
+
+    // Whether problems have a second dimension to sweep.
+    static constexpr bool hasN = false;
+
+protected:
+    // The hipBLAS handle to use, bound to our stream,
+    // owned by our caller.
+    const HipblasContext& blasContext;
+
+public:
+    // The length is m, as for the other bandwidth
+    // testers; n, alpha, and beta are not used.
+    HipblasSdotTester(int m,
+                        int /* n */,
+                        float /* alpha */,
+                        float /* beta */,
+                        const HipStream& hipStream,
+                        const HipblasContext& _blasContext,
+                        const InitOptions& init = InitOptions())
+      : DotTester(m, hipStream, init),
+        blasContext(_blasContext)
+    { }
+
+    static const char* GetName(void)    { return "sdot"; }
+
+    int GetM(void) const    { return GetLength(); }
+    int GetN(void) const    { return 1; }
+
+    // Enqueue the dot product on the GPU.  The result is written
+    // to device memory; in host pointer mode, hipBLAS would wait
+    // for each dot product to finish before returning it.
+    void
+    Enqueue(void) override
+    {
+        blasContext.UsePointerMode(HIPBLAS_POINTER_MODE_DEVICE);
+
+        DeviceTraceSpan span("hipblasSdot", hipStream.GetHandle());
+        CHECK(hipblasSdot(blasContext.GetHandle(),
+                            GetLength(),
+                            x.GetDeviceData(),
+                            1,
+                            y.GetDeviceData(),
+                            1,
+                            result.GetDeviceData()));
+    }
+};
+
+#endif // HIPBLAS_SDOT_TESTER_H
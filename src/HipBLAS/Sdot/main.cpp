@@ -0,0 +1,10 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include "HipblasSdotTester.h"
+#include "DoBandwidthMain.h"
+
+int
+main(int argc, char* argv[])
+{
+    return DoBandwidthMain<HipblasSdotTester>(argc, argv, "1024:16777216:x4");
+}
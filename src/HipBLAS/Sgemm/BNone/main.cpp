@@ -6,6 +6,6 @@
 int
 main(int argc, char* argv[])
 {
-    return DoMain<HipblasSgemmTester<false>>(argc, argv);
+    return DoMain<HipblasSgemmTester<GemmOp::N, GemmOp::N>>(argc, argv);
 }
 
@@ -6,6 +6,6 @@
 int
 main(int argc, char* argv[])
 {
-    return DoMain<HipblasSgemmTester<true>>(argc, argv);
+    return DoMain<HipblasSgemmTester<GemmOp::N, GemmOp::T>>(argc, argv);
 }
 
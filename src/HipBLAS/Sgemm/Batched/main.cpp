@@ -0,0 +1,12 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include "HipblasBatchedSgemmTester.h"
+#include "DoBatchedMain.h"
+
+int
+main(int argc, char* argv[])
+{
+    return DoBatchedMain<HipblasLoopedSgemmTester<false>,
+                            HipblasStridedBatchedSgemmTester<false>,
+                            HipblasPointerBatchedSgemmTester<false>>(argc, argv);
+}
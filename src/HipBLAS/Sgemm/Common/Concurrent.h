@@ -0,0 +1,196 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef CONCURRENT_H
+#define CONCURRENT_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CommandLine.h"
+#include "HipStream.h"
+#include "HostTimer.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// What we learned from running GEMMs of one shape from
+// several host threads at once.
+struct ConcurrentResult
+{
+    int nThreads = 0;
+    size_t nGemms = 0;
+
+    // Wall clock time from releasing the threads until the
+    // last one finished its timed GEMMs.
+    double wallMs = 0;
+    double gemmsPerSec = 0;
+    double gflops = 0;
+
+    // Aggregate throughput relative to nThreads times that of one
+    // thread; set by the caller, who knows the one-thread throughput.
+    double scalingEfficiency = 0;
+
+    // Latency of each GEMM, as seen by its thread (enqueue to
+    // completion), over all threads, and the median of the
+    // slowest thread.
+    std::vector<double> latencySamples;
+    TimingStats latency;
+    double worstThreadMedianMs = 0;
+
+    size_t nMismatches = 0;
+    size_t nSoakFailures = 0;
+};
+
+// Run nThreads host threads at once, each with its own stream,
+// library context (e.g., hipBLAS handle), and matrices, each
+// timing runOpts.bench.nIters GEMMs waited for one at a time.
+// Threads set up and warm up before being released together, so
+// the timed part measures only concurrent submission, where locks
+// in the library or runtime shared by the threads would show up.
+// Each thread's last result is verified, and soaked, as RunShape does.
+template<typename TesterType>
+ConcurrentResult
+RunConcurrent(int m,
+                int n,
+                int k,
+                float alpha,
+                float beta,
+                int nThreads,
+                const RunOptions& runOpts)
+{
+    using Clock = std::chrono::steady_clock;
+
+    ConcurrentResult result;
+    result.nThreads = nThreads;
+    result.nGemms = static_cast<size_t>(nThreads) * runOpts.bench.nIters;
+
+    // Threads wait at the gate until all are ready.
+    std::mutex mtx;
+    std::condition_variable cv;
+    int nReady = 0;
+    bool released = false;
+
+    std::vector<std::vector<double>> samples(nThreads);
+    std::vector<Clock::time_point> finishTimes(nThreads);
+    std::vector<size_t> nMismatches(nThreads, 0);
+    std::vector<size_t> nSoakFailures(nThreads, 0);
+    std::vector<std::exception_ptr> errors(nThreads);
+
+    auto work = [&](int t) {
+        try
+        {
+            HipStream hipStream;
+            typename TesterType::ContextType libContext(hipStream);
+            TesterType tester(m, n, k, alpha, beta, hipStream, libContext, runOpts.init);
+            for(auto i = 0; i < runOpts.bench.nWarmup; ++i)
+            {
+                tester.EnqueueSgemm();
+            }
+            hipStream.Synchronize();
+
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                ++nReady;
+                cv.notify_all();
+                cv.wait(lock, [&released](){ return released; });
+            }
+
+            {
+                TraceSpan span("concurrent GEMMs", "gemm");
+                samples[t].reserve(runOpts.bench.nIters);
+                HostTimer timer;
+                for(auto i = 0; i < runOpts.bench.nIters; ++i)
+                {
+                    timer.Restart();
+                    tester.EnqueueSgemm();
+                    hipStream.Synchronize();
+                    samples[t].push_back(timer.ElapsedMs());
+                }
+                finishTimes[t] = Clock::now();
+            }
+
+            tester.ResetOutput();
+            tester.DoSgemm();
+            hipStream.Synchronize();
+            if(runOpts.verifyChecksums)
+            {
+                auto check = tester.CheckChecksums(runOpts.check, true);
+                nMismatches[t] = check.badRows.size() + check.badCols.size();
+            }
+            else
+            {
+                nMismatches[t] = tester.CheckComputation(runOpts.check, true).nMismatches;
+            }
+
+            for(auto iter = 0; iter < runOpts.nSoakIters; ++iter)
+            {
+                tester.ChainChecksums();
+                tester.DoSgemm();
+                hipStream.Synchronize();
+                if(not tester.CheckChecksums(runOpts.check, true).Passed())
+                {
+                    ++nSoakFailures[t];
+                }
+            }
+        }
+        catch(...)
+        {
+            errors[t] = std::current_exception();
+
+            // Don't leave the others waiting for us at the gate.
+            std::lock_guard<std::mutex> lock(mtx);
+            if(not released)
+            {
+                ++nReady;
+                cv.notify_all();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(auto t = 0; t < nThreads; ++t)
+    {
+        threads.emplace_back(work, t);
+    }
+
+    Clock::time_point start;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&](){ return nReady == nThreads; });
+        start = Clock::now();
+        released = true;
+        cv.notify_all();
+    }
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+    for(const auto& error : errors)
+    {
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    auto finish = *std::max_element(finishTimes.begin(), finishTimes.end());
+    result.wallMs = std::chrono::duration<double, std::milli>(finish - start).count();
+    result.gemmsPerSec = (result.wallMs > 0) ? (1000.0 * result.nGemms / result.wallMs) : 0;
+    result.gflops = ToGflops(2.0 * m * n * k * result.nGemms, result.wallMs);
+
+    for(auto t = 0; t < nThreads; ++t)
+    {
+        result.worstThreadMedianMs = std::max(result.worstThreadMedianMs, TimingStats(samples[t]).medianMs);
+        result.latencySamples.insert(result.latencySamples.end(), samples[t].begin(), samples[t].end());
+        result.nMismatches += nMismatches[t];
+        result.nSoakFailures += nSoakFailures[t];
+    }
+    result.latency = TimingStats(result.latencySamples);
+
+    return result;
+}
+
+#endif // CONCURRENT_H
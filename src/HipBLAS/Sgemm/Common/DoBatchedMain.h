@@ -0,0 +1,200 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef DO_BATCHED_MAIN_H
+#define DO_BATCHED_MAIN_H
+
+#include <iostream>
+#include <vector>
+#include "CommandLine.h"
+#include "DoSgemmMain.h"
+#include "HipStream.h"
+#include "Benchmark.h"
+#include "MemoryPool.h"
+#include "ResultsWriter.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// Time one way of doing a batch of GEMMs, then do
+// the batch once more and verify it.
+template<typename TesterType>
+ShapeResult
+RunBatch(int m,
+            int n,
+            int k,
+            int nBatch,
+            float alpha,
+            float beta,
+            bool verbose,
+            const RunOptions& runOpts,
+            const HipStream& hipStream,
+            const typename TesterType::ContextType& libContext)
+{
+    ShapeResult result;
+    result.m = m;
+    result.n = n;
+    result.k = k;
+
+    TesterType tester(m, n, k, nBatch, alpha, beta, hipStream, libContext, runOpts.init);
+    hipStream.Synchronize();
+    result.lda = tester.GetLda();
+    result.ldb = tester.GetLdb();
+    result.ldc = tester.GetLdc();
+
+    auto samples = TimeOnStream(hipStream,
+                                runOpts.bench,
+                                [&tester](){ tester.EnqueueSgemm(); });
+    result.samples = samples;
+    result.stats = TimingStats(samples);
+    result.gflops = ToGflops(tester.GetFlopCount(), result.stats.medianMs);
+
+    tester.ResetOutput();
+    tester.DoSgemm();
+    if(verbose)
+    {
+        std::cout << tester << std::endl;
+    }
+
+    auto check = tester.CheckComputation(runOpts.check, true);
+    result.nMismatches = check.nMismatches;
+    result.maxAbsErr = check.maxAbsErr;
+    return result;
+}
+
+// For each problem shape and batch count, time a loop of individual
+// GEMMs (LoopTesterType) and each of the batched ways of doing the
+// same GEMMs (BatchedTesterTypes), and report them as CSV, so we can
+// see at which batch counts batching pays off.
+template<typename LoopTesterType, typename... BatchedTesterTypes>
+int
+DoBatchedMain(int argc, char* argv[])
+{
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::vector<int> ms;
+        std::vector<int> ks;
+        std::vector<int> ns;
+        float alpha;
+        float beta;
+        bool verbose;
+        RunOptions runOpts;
+
+        ProgramInfo program;
+        program.takesBatch = true;
+
+        std::tie(shouldRun,
+                    ret,
+                    ms,
+                    ks,
+                    ns,
+                    alpha,
+                    beta,
+                    verbose,
+                    runOpts) = ParseCommandLine<float>(argc, argv, program);
+
+        if(shouldRun)
+        {
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            TransferChunkBytes() = runOpts.transferChunkBytes;
+
+            HipStream hipStream;
+            typename LoopTesterType::ContextType libContext(hipStream);
+
+            std::cout << "m,n,k,batch,method,min_ms,median_ms,gflops,gemms_per_s,speedup_vs_loop,mismatches,status"
+                << std::endl;
+            for(auto m : ms)
+            {
+                for(auto n : ns)
+                {
+                    for(auto k : ks)
+                    {
+                        for(auto nBatch : runOpts.batchCounts)
+                        {
+                            double loopMs = 0;
+                            auto report = [&](const char* method, const ShapeResult& result) {
+                                std::cout << m << ',' << n << ',' << k
+                                    << ',' << nBatch
+                                    << ',' << method
+                                    << ',' << result.stats.minMs
+                                    << ',' << result.stats.medianMs
+                                    << ',' << result.gflops
+                                    << ',' << (nBatch / (result.stats.medianMs * 1.0e-3))
+                                    << ',' << (loopMs / result.stats.medianMs)
+                                    << ',' << result.nMismatches
+                                    << ',' << ((result.nMismatches == 0) ? "PASS" : "FAIL")
+                                    << std::endl;
+
+                                auto record = MakeShapeRecord("sgemm_batched", result, runOpts);
+                                record.config.Add("batch", nBatch)
+                                    .Add("method", method);
+                                record.metrics.Add("gemms_per_s", nBatch / (result.stats.medianMs * 1.0e-3));
+                                ResultsWriter::Get().Add(std::move(record));
+                            };
+
+                            auto loopResult = RunBatch<LoopTesterType>(m, n, k, nBatch,
+                                                                        alpha, beta,
+                                                                        verbose,
+                                                                        runOpts,
+                                                                        hipStream, libContext);
+                            loopMs = loopResult.stats.medianMs;
+                            report(LoopTesterType::GetName(), loopResult);
+
+                            // Each of the batched testers, in order.
+                            (report(BatchedTesterTypes::GetName(),
+                                    RunBatch<BatchedTesterTypes>(m, n, k, nBatch,
+                                                                    alpha, beta,
+                                                                    verbose,
+                                                                    runOpts,
+                                                                    hipStream, libContext)), ...);
+                        }
+                    }
+                }
+            }
+
+            std::cout << "# ";
+            PinnedHostPool().ReportTo(std::cout);
+            std::cout << "# ";
+            DevicePool().ReportTo(std::cout);
+
+            std::cout << "# ";
+            ReportPeakMemory(std::cout);
+
+            // Write the trace now, while the HIP runtime is still usable.
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+
+            // A result that failed verification fails the program.
+            if(ResultsWriter::Get().AnyFailed())
+            {
+                ret = 1;
+            }
+            ReleaseMemoryPools();
+        }
+    }
+    catch(const HipException& e)
+    {
+        std::cerr << "HIP Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const typename LoopTesterType::ExceptionType& e)
+    {
+        std::cerr << "hipBLAS Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}
+
+#endif // DO_BATCHED_MAIN_H
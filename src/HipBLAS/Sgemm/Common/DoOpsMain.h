@@ -0,0 +1,182 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef DO_OPS_MAIN_H
+#define DO_OPS_MAIN_H
+
+#include <iostream>
+#include <vector>
+#include "CommandLine.h"
+#include "DoSgemmMain.h"
+#include "GemmOp.h"
+#include "HipStream.h"
+#include "MemoryPool.h"
+#include "ResultsWriter.h"
+#include "Trace.h"
+
+// A table of RunShape for every instantiation of TesterTemplate,
+// so the ops can be chosen at run time.
+template<template<GemmOp, GemmOp> class TesterTemplate>
+class OpsDispatcher
+{
+public:
+    using BaseTesterType = TesterTemplate<GemmOp::N, GemmOp::N>;
+    using ContextType = typename BaseTesterType::ContextType;
+    using RunFunc = ShapeResult (*)(int, int, int,
+                                    float, float,
+                                    bool, bool,
+                                    const RunOptions&,
+                                    const HipStream&,
+                                    const ContextType&);
+
+private:
+    template<GemmOp OpA>
+    static constexpr RunFunc GetRunFunc(GemmOp opB)
+    {
+        return (opB == GemmOp::N) ? &RunShape<TesterTemplate<OpA, GemmOp::N>>
+            : ((opB == GemmOp::T) ? &RunShape<TesterTemplate<OpA, GemmOp::T>>
+                : &RunShape<TesterTemplate<OpA, GemmOp::C>>);
+    }
+
+public:
+    static RunFunc Get(const GemmOpPair& ops)
+    {
+        switch(ops.first)
+        {
+        case GemmOp::N: return GetRunFunc<GemmOp::N>(ops.second);
+        case GemmOp::T: return GetRunFunc<GemmOp::T>(ops.second);
+        default:        return GetRunFunc<GemmOp::C>(ops.second);
+        }
+    }
+};
+
+// For each problem shape, time and verify the GEMM with each
+// of the requested ops for A and B, and report them as CSV
+// alongside their slowdown relative to the first op pair,
+// so that a slow transposed path stands out.
+template<template<GemmOp, GemmOp> class TesterTemplate>
+int
+DoOpsMain(int argc, char* argv[])
+{
+    using Dispatcher = OpsDispatcher<TesterTemplate>;
+    using BaseTesterType = typename Dispatcher::BaseTesterType;
+
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::vector<int> ms;
+        std::vector<int> ks;
+        std::vector<int> ns;
+        float alpha;
+        float beta;
+        bool verbose;
+        RunOptions runOpts;
+
+        ProgramInfo program;
+        program.runsShapes = true;
+        program.takesOps = true;
+
+        std::tie(shouldRun,
+                    ret,
+                    ms,
+                    ks,
+                    ns,
+                    alpha,
+                    beta,
+                    verbose,
+                    runOpts) = ParseCommandLine<float>(argc, argv, program);
+
+        if(shouldRun)
+        {
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            TransferChunkBytes() = runOpts.transferChunkBytes;
+
+            HipStream hipStream;
+            typename Dispatcher::ContextType libContext(hipStream);
+
+            // Comparing ops means timing them.
+            runOpts.bench.enabled = true;
+
+            std::cout << "m,n,k,ops,min_ms,median_ms,p95_ms,gflops,slowdown_vs_first,mismatches,max_abs_err,status"
+                << std::endl;
+            for(auto m : ms)
+            {
+                for(auto n : ns)
+                {
+                    for(auto k : ks)
+                    {
+                        double firstMs = 0;
+                        for(const auto& ops : runOpts.ops)
+                        {
+                            auto run = Dispatcher::Get(ops);
+                            auto result = run(m, n, k,
+                                                alpha, beta,
+                                                verbose, true,
+                                                runOpts,
+                                                hipStream, libContext);
+                            if(firstMs == 0)
+                            {
+                                firstMs = result.stats.medianMs;
+                            }
+
+                            auto passed = (result.nMismatches == 0) and (result.nSoakFailures == 0);
+                            std::cout << m << ',' << n << ',' << k
+                                << ',' << GetOpPairName(ops)
+                                << ',' << result.stats.minMs
+                                << ',' << result.stats.medianMs
+                                << ',' << result.stats.p95Ms
+                                << ',' << result.gflops
+                                << ',' << (result.stats.medianMs / firstMs)
+                                << ',' << result.nMismatches
+                                << ',' << result.maxAbsErr
+                                << ',' << (passed ? "PASS" : "FAIL")
+                                << std::endl;
+                            auto record = MakeShapeRecord("sgemm", result, runOpts);
+                            record.config.Add("ops", GetOpPairName(ops));
+                            ResultsWriter::Get().Add(std::move(record));
+                        }
+                    }
+                }
+            }
+
+            std::cout << "# ";
+            ReportPeakMemory(std::cout);
+
+            // Write the trace now, while the HIP runtime is still usable.
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+
+            // A result that failed verification fails the program.
+            if(ResultsWriter::Get().AnyFailed())
+            {
+                ret = 1;
+            }
+            ReleaseMemoryPools();
+        }
+    }
+    catch(const HipException& e)
+    {
+        std::cerr << "HIP Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const typename BaseTesterType::ExceptionType& e)
+    {
+        std::cerr << "hipBLAS Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}
+
+#endif // DO_OPS_MAIN_H
@@ -4,8 +4,359 @@
 #define DO_MAIN_H
 
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 #include "CommandLine.h"
 #include "HipStream.h"
+#include "HipblasPrewarm.h"
+#include "Benchmark.h"
+#include "Concurrent.h"
+#include "HostTimer.h"
+#include "MemoryPool.h"
+#include "Pipeline.h"
+#include "Replay.h"
+#include "ResultsWriter.h"
+#include "Startup.h"
+#include "Tiled.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// What we learned from running one GEMM problem shape.
+struct ShapeResult
+{
+    int m = 0;
+    int n = 0;
+    int k = 0;
+
+    // Leading dimensions used.
+    int lda = 0;
+    int ldb = 0;
+    int ldc = 0;
+
+    // Only meaningful if the shape was benchmarked.
+    std::vector<double> samples;
+    TimingStats stats;
+    double gflops = 0;
+
+    // With checksum verification, mismatches are bad rows and
+    // columns, and the error is that of the worst checksum.
+    size_t nMismatches = 0;
+    double maxAbsErr = 0;
+
+    // Number of soak GEMMs whose checksums were wrong.
+    size_t nSoakFailures = 0;
+
+    // With --graph: median device time and host submission time per
+    // GEMM, submitted directly and replayed from a captured graph.
+    // The graph status is "ok", or why capture was unavailable.
+    double directGemmMs = 0;
+    double directSubmitUs = 0;
+    double graphGemmMs = 0;
+    double graphSubmitUs = 0;
+    std::string graphStatus;
+
+    // With --chain: median time per GEMM in a chain of dependent
+    // GEMMs with alpha and beta in host and in device memory.
+    double hostChainGemmMs = 0;
+    double deviceChainGemmMs = 0;
+};
+
+// Time a sequence of runOpts.nGraphGemms GEMMs submitted directly and
+// replayed from a HIP graph, and record the per-GEMM costs in result.
+// If the graph can't be captured, only direct submission is timed.
+template<typename TesterType>
+void
+CompareGraphReplay(TesterType& tester,
+                    const HipStream& hipStream,
+                    const RunOptions& runOpts,
+                    ShapeResult& result)
+{
+    const auto nGemms = runOpts.nGraphGemms;
+    const auto withCopies = runOpts.graphCopies;
+
+    // Host cost of enqueueing the sequence, from enqueue alone
+    // (each sequence is short enough not to fill the queue).
+    auto timeSubmitUs = [&](auto enqueue) {
+        HostTimer timer;
+        for(auto i = 0; i < runOpts.bench.nIters; ++i)
+        {
+            enqueue();
+        }
+        auto ms = timer.ElapsedMs();
+        hipStream.Synchronize();
+        return 1000.0 * ms / (static_cast<double>(runOpts.bench.nIters) * nGemms);
+    };
+
+    auto direct = [&tester, nGemms, withCopies](){ tester.EnqueueSequence(nGemms, withCopies); };
+    result.directGemmMs = TimingStats(TimeOnStream(hipStream, runOpts.bench, direct)).medianMs / nGemms;
+    result.directSubmitUs = timeSubmitUs(direct);
+
+    std::string whyNot;
+    if(tester.CaptureGraph(nGemms, withCopies, whyNot))
+    {
+        auto replay = [&tester](){ tester.EnqueueGraph(); };
+        result.graphGemmMs = TimingStats(TimeOnStream(hipStream, runOpts.bench, replay)).medianMs / nGemms;
+        result.graphSubmitUs = timeSubmitUs(replay);
+        result.graphStatus = "ok";
+    }
+    else
+    {
+        result.graphStatus = whyNot;
+    }
+}
+
+// Time chains of runOpts.nChainGemms dependent GEMMs (see
+// EnqueueChainStep) with scalars in host memory and in device memory,
+// and record the median time per GEMM for each in result.
+template<typename TesterType>
+void
+ComparePointerModes(TesterType& tester,
+                    const HipStream& hipStream,
+                    const RunOptions& runOpts,
+                    ShapeResult& result)
+{
+    const auto nGemms = runOpts.nChainGemms;
+    auto timeChain = [&](hipblasPointerMode_t mode) {
+        tester.SetPointerMode(mode);
+        auto chain = [&tester, nGemms](){
+            for(auto i = 0; i < nGemms; ++i)
+            {
+                tester.EnqueueChainStep();
+            }
+        };
+        for(auto i = 0; i < runOpts.bench.nWarmup; ++i)
+        {
+            chain();
+        }
+        hipStream.Synchronize();
+
+        // The host waits are part of the cost, so we time
+        // the chains with the host clock.
+        std::vector<double> samples;
+        HostTimer timer;
+        for(auto i = 0; i < runOpts.bench.nIters; ++i)
+        {
+            timer.Restart();
+            chain();
+            hipStream.Synchronize();
+            samples.push_back(timer.ElapsedMs() / nGemms);
+        }
+        return TimingStats(samples).medianMs;
+    };
+
+    auto oldMode = tester.GetPointerMode();
+    result.hostChainGemmMs = timeChain(HIPBLAS_POINTER_MODE_HOST);
+    result.deviceChainGemmMs = timeChain(HIPBLAS_POINTER_MODE_DEVICE);
+    tester.SetPointerMode(oldMode);
+}
+
+// Run one GEMM problem shape: build its matrices, optionally
+// time repeated GEMMs, then do one GEMM and verify it, and
+// optionally soak: repeat the GEMM, verifying each with checksums.
+// If quiet, nothing is written to standard output, so the
+// caller can report the result in its own format.
+template<typename TesterType>
+ShapeResult
+RunShape(int m,
+            int n,
+            int k,
+            float alpha,
+            float beta,
+            bool verbose,
+            bool quiet,
+            const RunOptions& runOpts,
+            const HipStream& hipStream,
+            const typename TesterType::ContextType& libContext)
+{
+    const auto& bench = runOpts.bench;
+
+    ShapeResult result;
+    result.m = m;
+    result.n = n;
+    result.k = k;
+
+    // Create the input matrices.
+    TesterType tester(m, n, k, alpha, beta, hipStream, libContext, runOpts.init);
+
+    // Wait for matrices to be copied to GPU.
+    hipStream.Synchronize();
+    result.lda = tester.GetLda();
+    result.ldb = tester.GetLdb();
+    result.ldc = tester.GetLdc();
+
+    if(verbose)
+    {
+        // Dump the state of the problem on the GPU for debugging.
+        std::cout << tester << std::endl;
+    }
+
+    if(bench.enabled)
+    {
+        // Time repeated GEMMs.  The timed loop only enqueues
+        // GEMMs; results are read back and checked once, below.
+        TraceSpan span("benchmark", "gemm");
+        auto samples = TimeOnStream(hipStream,
+                                    bench,
+                                    [&tester](){ tester.EnqueueSgemm(); });
+        result.samples = samples;
+        result.stats = TimingStats(samples);
+        result.gflops = ToGflops(tester.GetFlopCount(), result.stats.medianMs);
+        if(not quiet)
+        {
+            std::cout << "Leading dimensions: lda=" << result.lda
+                << " ldb=" << result.ldb
+                << " ldc=" << result.ldc << '\n'
+                << "GEMM time: " << result.stats << '\n'
+                << "GFLOP/s: " << result.gflops << " (median)"
+                << ", " << ToGflops(tester.GetFlopCount(), result.stats.minMs) << " (best)"
+                << std::endl;
+        }
+
+        if(runOpts.nGraphGemms > 0)
+        {
+            CompareGraphReplay(tester, hipStream, runOpts, result);
+            if(not quiet)
+            {
+                std::cout << "Per GEMM, sequences of " << runOpts.nGraphGemms
+                    << (runOpts.graphCopies ? " with copies" : "") << ":\n"
+                    << "  direct: " << result.directGemmMs << " ms, "
+                    << result.directSubmitUs << " us to submit\n";
+                if(result.graphStatus == "ok")
+                {
+                    std::cout << "  graph:  " << result.graphGemmMs << " ms, "
+                        << result.graphSubmitUs << " us to submit\n";
+                }
+                else
+                {
+                    std::cout << "  graph capture unavailable (" << result.graphStatus << ")\n";
+                }
+                std::cout << std::flush;
+            }
+        }
+
+        if(runOpts.nChainGemms > 0)
+        {
+            ComparePointerModes(tester, hipStream, runOpts, result);
+            if(not quiet)
+            {
+                std::cout << "Per GEMM, chains of " << runOpts.nChainGemms << " dependent GEMMs:\n"
+                    << "  scalars in host memory:   " << result.hostChainGemmMs << " ms\n"
+                    << "  scalars in device memory: " << result.deviceChainGemmMs << " ms\n"
+                    << "  difference: " << (result.hostChainGemmMs - result.deviceChainGemmMs) << " ms"
+                    << std::endl;
+            }
+        }
+
+        // The timed GEMMs accumulated into C, so start over
+        // for the verification run.
+        tester.ResetOutput();
+        hipStream.Synchronize();
+    }
+
+    // Do the GEMM.
+    tester.DoSgemm();
+    hipStream.Synchronize();
+
+    if(verbose)
+    {
+        // Dump the state after the GEMM for debugging.
+        std::cout << tester << std::endl;
+    }
+
+    // Verify the GPU-computed results match the expected results.
+    if(runOpts.verifyChecksums)
+    {
+        auto check = tester.CheckChecksums(runOpts.check, quiet);
+        result.nMismatches = check.badRows.size() + check.badCols.size();
+        result.maxAbsErr = check.maxErr;
+    }
+    else
+    {
+        auto check = tester.CheckComputation(runOpts.check, quiet);
+        result.nMismatches = check.nMismatches;
+        result.maxAbsErr = check.maxAbsErr;
+    }
+
+    // Soak: each GEMM uses the previous one's output as its C,
+    // so we chain the checksums rather than recomputing a reference.
+    for(auto iter = 0; iter < runOpts.nSoakIters; ++iter)
+    {
+        tester.ChainChecksums();
+        tester.DoSgemm();
+        hipStream.Synchronize();
+
+        auto check = tester.CheckChecksums(runOpts.check, true);
+        if(not check.Passed())
+        {
+            ++result.nSoakFailures;
+            if(not quiet)
+            {
+                std::cout << "Soak iteration " << iter << ":\n";
+                ReportChecksums(std::cout, check, runOpts.check.maxReported);
+            }
+        }
+    }
+    if( (runOpts.nSoakIters > 0) and not quiet )
+    {
+        std::cout << "Soak: " << runOpts.nSoakIters << " GEMMs, "
+            << result.nSoakFailures << " with bad checksums" << std::endl;
+    }
+
+    return result;
+}
+
+// Describe a shape's result for the results file.  Callers
+// add whatever else identifies the configuration they ran.
+inline
+ResultRecord
+MakeShapeRecord(const char* kind, const ShapeResult& result, const RunOptions& runOpts)
+{
+    ResultRecord record;
+    record.config.Add("kind", kind)
+        .Add("m", result.m)
+        .Add("n", result.n)
+        .Add("k", result.k)
+        .Add("lda", result.lda)
+        .Add("ldb", result.ldb)
+        .Add("ldc", result.ldc)
+        .Add("init", runOpts.init.random ? "random" : "pattern")
+        .Add("verify", runOpts.verifyChecksums ? "abft" : "full")
+        .Add("scalars", runOpts.init.deviceScalars ? "device" : "host");
+    if(result.stats.nSamples > 0)
+    {
+        record.metrics.Add("min_ms", result.stats.minMs)
+            .Add("median_ms", result.stats.medianMs)
+            .Add("mean_ms", result.stats.meanMs)
+            .Add("p95_ms", result.stats.p95Ms)
+            .Add("gflops", result.gflops);
+    }
+    if(not result.graphStatus.empty())
+    {
+        record.config.Add("graph_gemms", runOpts.nGraphGemms)
+            .Add("graph_copies", runOpts.graphCopies);
+        record.metrics.Add("direct_gemm_ms", result.directGemmMs)
+            .Add("direct_submit_us", result.directSubmitUs)
+            .Add("graph_status", result.graphStatus);
+        if(result.graphStatus == "ok")
+        {
+            record.metrics.Add("graph_gemm_ms", result.graphGemmMs)
+                .Add("graph_submit_us", result.graphSubmitUs);
+        }
+    }
+    if(runOpts.nChainGemms > 0)
+    {
+        record.config.Add("chain_gemms", runOpts.nChainGemms);
+        record.metrics.Add("host_scalars_chain_gemm_ms", result.hostChainGemmMs)
+            .Add("device_scalars_chain_gemm_ms", result.deviceChainGemmMs);
+    }
+    record.metrics.Add("mismatches", result.nMismatches)
+        .Add("max_abs_err", result.maxAbsErr)
+        .Add("soak_failures", result.nSoakFailures);
+    record.samplesMs = result.samples;
+    record.passed = (result.nMismatches == 0) and (result.nSoakFailures == 0);
+    return record;
+}
 
 template<typename TesterType>
 int
@@ -21,9 +372,11 @@ DoMain(int argc, char* argv[])
         // A: m x k
         // B: k x n
         // C: m x n
-        int m = -1;
-        int k = -1;
-        int n = -1;
+        // Each may be a list of sizes, in which case we
+        // sweep over all combinations.
+        std::vector<int> ms;
+        std::vector<int> ks;
+        std::vector<int> ns;
 
         // Scaling factors for A*B and for C as input.
         float alpha;
@@ -32,45 +385,479 @@ DoMain(int argc, char* argv[])
         // Whether we should dump debugging output.
         bool verbose;
 
-        // Parse the command line.
+        // How to run, e.g., whether and how to time repeated GEMMs.
+        RunOptions runOpts;
+
+        // Parse the command line.  This program has every way
+        // of running shapes, and is the only one that can run
+        // GEMMs out of core.
+        ProgramInfo program;
+        program.takesBench = true;
+        program.runsShapes = true;
+        program.runsModes = true;
+        program.runsTiled = true;
         std::tie(shouldRun,
                     ret,
-                    m,
-                    k,
-                    n,
+                    ms,
+                    ks,
+                    ns,
                     alpha,
                     beta,
-                    verbose) = ParseCommandLine<float>(argc, argv);
+                    verbose,
+                    runOpts) = ParseCommandLine<float>(argc, argv, program);
+        auto& bench = runOpts.bench;
+
+        if(shouldRun and runOpts.profileStartup)
+        {
+            // Profile startup for the first shape in fresh processes,
+            // cold and pre-warmed, before this process uses HIP.
+            // One process's times are noisy, so profile several of each,
+            // alternating so that drift (e.g., in caches that outlive
+            // a process) affects both alike.
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            std::vector<StartupProfile> coldRuns;
+            std::vector<StartupProfile> warmRuns;
+            for(auto run = 0; run < runOpts.nStartupRuns; ++run)
+            {
+                coldRuns.push_back(ProfileStartupInChild<TesterType>(ms[0], ns[0], ks[0], alpha, beta, false, runOpts));
+                warmRuns.push_back(ProfileStartupInChild<TesterType>(ms[0], ns[0], ks[0], alpha, beta, true, runOpts));
+            }
+
+            // Step times are medians over the runs.  What pre-warming
+            // removes from the first GEMM at this shape is its overhead
+            // beyond what the second GEMM costs anyway, taken run by run.
+            auto firstGemmOverhead = [](const StartupProfile& p){ return p.firstGemmMs - p.secondGemmMs; };
+            std::cout << "m,n,k,prewarm,runs,first_hip_call_ms,stream_create_ms,handle_create_ms,prewarm_ms,"
+                << "setup_ms,first_gemm_ms,second_gemm_ms,time_to_first_gemm_ms,"
+                << "time_to_first_gemm_min_ms,time_to_first_gemm_max_ms,"
+                << "first_gemm_overhead_ms,first_gemm_overhead_min_ms,first_gemm_overhead_max_ms"
+                << std::endl;
+            std::vector<TimingStats> overheads;
+            for(const auto* runs : { &coldRuns, &warmRuns })
+            {
+                auto prewarmed = (runs == &warmRuns);
+                auto profile = MedianStartupProfile(*runs);
+                auto timeToFirstGemm = StartupStats(*runs, [](const StartupProfile& p){ return p.timeToFirstGemmMs; });
+                auto overhead = StartupStats(*runs, firstGemmOverhead);
+                overheads.push_back(overhead);
+                std::cout << ms[0] << ',' << ns[0] << ',' << ks[0]
+                    << ',' << (prewarmed ? "yes" : "no")
+                    << ',' << runs->size()
+                    << ',' << profile.firstHipCallMs
+                    << ',' << profile.streamCreateMs
+                    << ',' << profile.handleCreateMs
+                    << ',' << profile.prewarmMs
+                    << ',' << profile.setupMs
+                    << ',' << profile.firstGemmMs
+                    << ',' << profile.secondGemmMs
+                    << ',' << profile.timeToFirstGemmMs
+                    << ',' << timeToFirstGemm.minMs
+                    << ',' << timeToFirstGemm.maxMs
+                    << ',' << overhead.medianMs
+                    << ',' << overhead.minMs
+                    << ',' << overhead.maxMs
+                    << std::endl;
+
+                ResultRecord record;
+                record.config.Add("kind", "startup")
+                    .Add("m", ms[0])
+                    .Add("n", ns[0])
+                    .Add("k", ks[0])
+                    .Add("ops", TesterType::GetOpsName())
+                    .Add("prewarm", prewarmed);
+                record.metrics.Add("first_hip_call_ms", profile.firstHipCallMs)
+                    .Add("stream_create_ms", profile.streamCreateMs)
+                    .Add("handle_create_ms", profile.handleCreateMs)
+                    .Add("prewarm_ms", profile.prewarmMs)
+                    .Add("setup_ms", profile.setupMs)
+                    .Add("first_gemm_ms", profile.firstGemmMs)
+                    .Add("second_gemm_ms", profile.secondGemmMs)
+                    .Add("time_to_first_gemm_ms", profile.timeToFirstGemmMs)
+                    .Add("first_gemm_overhead_ms", overhead.medianMs);
+                for(const auto& run : *runs)
+                {
+                    record.samplesMs.push_back(run.timeToFirstGemmMs);
+                }
+                ResultsWriter::Get().Add(std::move(record));
+            }
+
+            std::cout << "# first GEMM overhead: median "
+                << overheads[0].medianMs << " ms cold (" << overheads[0].minMs << " to " << overheads[0].maxMs << "), "
+                << overheads[1].medianMs << " ms pre-warmed (" << overheads[1].minMs << " to " << overheads[1].maxMs << "), "
+                << MedianStartupProfile(warmRuns).prewarmMs << " ms to pre-warm"
+                << std::endl;
+
+            // Spans in the children are not collected, so the
+            // trace has only this process's (none, so far).
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+            shouldRun = false;
+        }
 
         if(shouldRun)
         {
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            TransferChunkBytes() = runOpts.transferChunkBytes;
+
             // Build a HIP stream.
             HipStream hipStream;
 
-            // Create the input matrices with known values.
-            TesterType tester(m, n, k, alpha, beta, hipStream);
+            // Build the library context (e.g., hipBLAS handle) bound
+            // to our stream, once, and time it separately from the GEMMs.
+            HostTimer contextTimer;
+            typename TesterType::ContextType libContext(hipStream);
+            auto contextMs = contextTimer.ElapsedMs();
 
-            // Wait for matrices to be copied to GPU.
-            hipStream.Synchronize();
+            // A replay pre-warms the handles it makes itself.
+            if(runOpts.prewarm and runOpts.replayPath.empty())
+            {
+                HostTimer prewarmTimer;
+                PrewarmHipblas(hipStream, libContext, { TesterType::GetOps() });
+                std::cout << "# prewarm time: " << prewarmTimer.ElapsedMs() << " ms" << std::endl;
+            }
 
-            if(verbose)
+            if(not runOpts.replayPath.empty())
             {
-                // Dump the state of the problem on the GPU for debugging.
-                std::cout << tester << std::endl;
+                // Replay an application's GEMM calls instead of the given shapes.
+                RunReplay(runOpts);
             }
+            else if(runOpts.nPipelineProblems > 0)
+            {
+                // Run a queue of problems per shape, serialized and
+                // pipelined over several streams, each stream with
+                // its own library context.
+                std::vector<std::unique_ptr<HipStream>> streams;
+                std::vector<std::unique_ptr<typename TesterType::ContextType>> libContexts;
+                for(auto i = 0; i < runOpts.nStreams; ++i)
+                {
+                    streams.emplace_back(std::make_unique<HipStream>());
+                    libContexts.emplace_back(std::make_unique<typename TesterType::ContextType>(*streams.back()));
+                }
 
-            // Do the GEMM.
-            tester.DoSgemm();
-            hipStream.Synchronize();
+                std::cout << "m,n,k,problems,streams,upload_ms,gemm_ms,download_ms,serial_ms,pipelined_ms,ideal_ms,"
+                    << "serial_gflops,pipelined_gflops,speedup,overlap_efficiency,mismatches,status"
+                    << std::endl;
+                for(auto m : ms)
+                {
+                    for(auto n : ns)
+                    {
+                        for(auto k : ks)
+                        {
+                            auto result = RunPipeline<TesterType>(m, n, k,
+                                                                    alpha, beta,
+                                                                    runOpts.nPipelineProblems,
+                                                                    runOpts,
+                                                                    streams, libContexts);
+                            auto nFlops = 2.0 * m * n * k * result.nProblems;
+
+                            ResultRecord record;
+                            record.config.Add("kind", "pipeline")
+                                .Add("m", m)
+                                .Add("n", n)
+                                .Add("k", k)
+                                .Add("ops", TesterType::GetOpsName())
+                                .Add("problems", result.nProblems)
+                                .Add("streams", result.nStreams)
+                                .Add("verify", runOpts.verifyChecksums ? "abft" : "full");
+                            record.metrics.Add("serial_ms", result.serialMs)
+                                .Add("pipelined_ms", result.pipelinedMs)
+                                .Add("ideal_ms", result.idealMs)
+                                .Add("pipelined_gflops", ToGflops(nFlops, result.pipelinedMs))
+                                .Add("overlap_efficiency", result.overlapEfficiency)
+                                .Add("mismatches", result.nMismatches);
+                            record.passed = (result.nMismatches == 0);
+                            ResultsWriter::Get().Add(std::move(record));
+
+                            std::cout << m << ',' << n << ',' << k
+                                << ',' << result.nProblems
+                                << ',' << result.nStreams
+                                << ',' << result.uploadMs
+                                << ',' << result.gemmMs
+                                << ',' << result.downloadMs
+                                << ',' << result.serialMs
+                                << ',' << result.pipelinedMs
+                                << ',' << result.idealMs
+                                << ',' << ToGflops(nFlops, result.serialMs)
+                                << ',' << ToGflops(nFlops, result.pipelinedMs)
+                                << ',' << (result.serialMs / result.pipelinedMs)
+                                << ',' << result.overlapEfficiency
+                                << ',' << result.nMismatches
+                                << ',' << ((result.nMismatches == 0) ? "PASS" : "FAIL")
+                                << std::endl;
+                        }
+                    }
+                }
+            }
+            else if(runOpts.deviceBudgetBytes > 0)
+            {
+                // Run each shape out of core, streaming tiles through
+                // the device budget on several streams, each with its
+                // own library context, and in core where it fits.
+                std::vector<std::unique_ptr<HipStream>> streams;
+                std::vector<std::unique_ptr<typename TesterType::ContextType>> libContexts;
+                for(auto i = 0; i < runOpts.nStreams; ++i)
+                {
+                    streams.emplace_back(std::make_unique<HipStream>());
+                    libContexts.emplace_back(std::make_unique<typename TesterType::ContextType>(*streams.back()));
+                }
+
+                std::cout << "# device budget: " << (runOpts.deviceBudgetBytes >> 20) << " MiB\n"
+                    << "m,n,k,streams,tile_m,tile_n,tile_k,tiles,device_mib,tiled_median_ms,tiled_p95_ms,tiled_gflops,"
+                    << "in_core_median_ms,in_core_gflops,tiled_vs_in_core,mismatches,status"
+                    << std::endl;
+                for(auto m : ms)
+                {
+                    for(auto n : ns)
+                    {
+                        for(auto k : ks)
+                        {
+                            auto result = RunTiled<TesterType>(m, n, k,
+                                                                alpha, beta,
+                                                                runOpts.deviceBudgetBytes,
+                                                                runOpts,
+                                                                streams, libContexts);
+                            auto nFlops = 2.0 * m * n * k;
+                            auto tiledGflops = ToGflops(nFlops, result.tiled.medianMs);
+                            auto inCoreGflops = result.inCoreFits ? ToGflops(nFlops, result.inCore.medianMs) : 0;
+                            auto deviceMib = static_cast<double>(result.deviceBytes) / (1 << 20);
+
+                            ResultRecord record;
+                            record.config.Add("kind", "tiled")
+                                .Add("m", m)
+                                .Add("n", n)
+                                .Add("k", k)
+                                .Add("ops", TesterType::GetOpsName())
+                                .Add("streams", result.nStreams)
+                                .Add("device_budget_bytes", runOpts.deviceBudgetBytes)
+                                .Add("tile_m", result.tile.m)
+                                .Add("tile_n", result.tile.n)
+                                .Add("tile_k", result.tile.k);
+                            record.metrics.Add("device_bytes", result.deviceBytes)
+                                .Add("median_ms", result.tiled.medianMs)
+                                .Add("p95_ms", result.tiled.p95Ms)
+                                .Add("gflops", tiledGflops)
+                                .Add("mismatches", result.nMismatches)
+                                .Add("max_abs_err", result.maxAbsErr);
+                            if(result.inCoreFits)
+                            {
+                                record.metrics.Add("in_core_median_ms", result.inCore.medianMs)
+                                    .Add("in_core_gflops", inCoreGflops);
+                            }
+                            record.samplesMs = result.tiledSamples;
+                            record.passed = (result.nMismatches == 0);
+                            ResultsWriter::Get().Add(std::move(record));
+
+                            // The in-core columns are empty where only the tiled path fits.
+                            std::cout << m << ',' << n << ',' << k
+                                << ',' << result.nStreams
+                                << ',' << result.tile.m
+                                << ',' << result.tile.n
+                                << ',' << result.tile.k
+                                << ',' << result.nTiles
+                                << ',' << deviceMib
+                                << ',' << result.tiled.medianMs
+                                << ',' << result.tiled.p95Ms
+                                << ',' << tiledGflops
+                                << ',';
+                            if(result.inCoreFits)
+                            {
+                                std::cout << result.inCore.medianMs
+                                    << ',' << inCoreGflops
+                                    << ',' << (tiledGflops / inCoreGflops);
+                            }
+                            else
+                            {
+                                std::cout << ",,";
+                            }
+                            std::cout << ',' << result.nMismatches
+                                << ',' << ((result.nMismatches == 0) ? "PASS" : "FAIL")
+                                << std::endl;
+                        }
+                    }
+                }
+            }
+            else if(runOpts.nHostThreads > 0)
+            {
+                // Run each shape from 1, 2, 4, ... threads at once,
+                // and compare throughput with that of one thread.
+                std::vector<int> threadCounts;
+                for(auto t = 1; t < runOpts.nHostThreads; t *= 2)
+                {
+                    threadCounts.push_back(t);
+                }
+                threadCounts.push_back(runOpts.nHostThreads);
+
+                std::cout << "m,n,k,threads,gemms,wall_ms,gemms_per_s,gflops,scaling_efficiency,"
+                    << "lat_min_ms,lat_median_ms,lat_p95_ms,lat_max_ms,worst_thread_median_ms,mismatches,soak_failures,status"
+                    << std::endl;
+                for(auto m : ms)
+                {
+                    for(auto n : ns)
+                    {
+                        for(auto k : ks)
+                        {
+                            double baseGemmsPerSec = 0;
+                            for(auto nThreads : threadCounts)
+                            {
+                                auto result = RunConcurrent<TesterType>(m, n, k,
+                                                                        alpha, beta,
+                                                                        nThreads,
+                                                                        runOpts);
+                                if(nThreads == 1)
+                                {
+                                    baseGemmsPerSec = result.gemmsPerSec;
+                                }
+                                result.scalingEfficiency = (baseGemmsPerSec > 0)
+                                    ? result.gemmsPerSec / (nThreads * baseGemmsPerSec)
+                                    : 0;
+
+                                ResultRecord record;
+                                record.config.Add("kind", "concurrent")
+                                    .Add("m", m)
+                                    .Add("n", n)
+                                    .Add("k", k)
+                                    .Add("ops", TesterType::GetOpsName())
+                                    .Add("threads", nThreads)
+                                    .Add("verify", runOpts.verifyChecksums ? "abft" : "full");
+                                record.metrics.Add("wall_ms", result.wallMs)
+                                    .Add("gemms_per_s", result.gemmsPerSec)
+                                    .Add("gflops", result.gflops)
+                                    .Add("scaling_efficiency", result.scalingEfficiency)
+                                    .Add("median_ms", result.latency.medianMs)
+                                    .Add("p95_ms", result.latency.p95Ms)
+                                    .Add("worst_thread_median_ms", result.worstThreadMedianMs)
+                                    .Add("mismatches", result.nMismatches)
+                                    .Add("soak_failures", result.nSoakFailures);
+                                auto passed = (result.nMismatches == 0) and (result.nSoakFailures == 0);
+                                record.samplesMs = result.latencySamples;
+                                record.passed = passed;
+                                ResultsWriter::Get().Add(std::move(record));
 
-            if(verbose)
+                                std::cout << m << ',' << n << ',' << k
+                                    << ',' << nThreads
+                                    << ',' << result.nGemms
+                                    << ',' << result.wallMs
+                                    << ',' << result.gemmsPerSec
+                                    << ',' << result.gflops
+                                    << ',' << result.scalingEfficiency
+                                    << ',' << result.latency.minMs
+                                    << ',' << result.latency.medianMs
+                                    << ',' << result.latency.p95Ms
+                                    << ',' << result.latency.maxMs
+                                    << ',' << result.worstThreadMedianMs
+                                    << ',' << result.nMismatches
+                                    << ',' << result.nSoakFailures
+                                    << ',' << (passed ? "PASS" : "FAIL")
+                                    << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+            else if( (ms.size() == 1) and (ns.size() == 1) and (ks.size() == 1) and (runOpts.pads.size() == 1) )
+            {
+                if(bench.enabled)
+                {
+                    std::cout << "Handle creation time: " << contextMs << " ms" << std::endl;
+                }
+                auto result = RunShape<TesterType>(ms[0], ns[0], ks[0],
+                                                    alpha, beta,
+                                                    verbose, false,
+                                                    runOpts,
+                                                    hipStream, libContext);
+                auto record = MakeShapeRecord("sgemm", result, runOpts);
+                record.config.Add("ops", TesterType::GetOpsName());
+                ResultsWriter::Get().Add(std::move(record));
+                if(bench.enabled)
+                {
+                    PinnedHostPool().ReportTo(std::cout);
+                    DevicePool().ReportTo(std::cout);
+                }
+            }
+            else
             {
-                // Dump the state after the GEMM for debugging.
-                std::cout << tester << std::endl;
+                // Sweep all combinations of the given sizes (and paddings) in this
+                // process, with one stream and one library context,
+                // so device, library, and JIT initialization is paid once.
+                // A sweep is always timed.
+                bench.enabled = true;
+                std::cout << "# handle creation time: " << contextMs << " ms\n"
+                    << "m,n,k,pad,lda,ldb,ldc,warmup,iters,min_ms,median_ms,mean_ms,p95_ms,gflops,mismatches,max_abs_err,soak_failures,status"
+                    << ((runOpts.nGraphGemms > 0) ? ",direct_gemm_ms,direct_submit_us,graph_gemm_ms,graph_submit_us,graph_status" : "")
+                    << ((runOpts.nChainGemms > 0) ? ",host_scalars_chain_gemm_ms,device_scalars_chain_gemm_ms" : "")
+                    << std::endl;
+                for(auto m : ms)
+                {
+                    for(auto n : ns)
+                    {
+                        for(auto k : ks)
+                        {
+                            for(auto pad : runOpts.pads)
+                            {
+                                auto padOpts = runOpts;
+                                padOpts.init.layout.pad = pad;
+                                auto result = RunShape<TesterType>(m, n, k,
+                                                                    alpha, beta,
+                                                                    verbose, true,
+                                                                    padOpts,
+                                                                    hipStream, libContext);
+                                std::cout << m << ',' << n << ',' << k
+                                    << ',' << pad
+                                    << ',' << result.lda
+                                    << ',' << result.ldb
+                                    << ',' << result.ldc
+                                    << ',' << bench.nWarmup
+                                    << ',' << bench.nIters
+                                    << ',' << result.stats.minMs
+                                    << ',' << result.stats.medianMs
+                                    << ',' << result.stats.meanMs
+                                    << ',' << result.stats.p95Ms
+                                    << ',' << result.gflops
+                                    << ',' << result.nMismatches
+                                    << ',' << result.maxAbsErr
+                                    << ',' << result.nSoakFailures
+                                    << ',' << (((result.nMismatches == 0) and (result.nSoakFailures == 0)) ? "PASS" : "FAIL");
+                                if(runOpts.nGraphGemms > 0)
+                                {
+                                    std::cout << ',' << result.directGemmMs
+                                        << ',' << result.directSubmitUs
+                                        << ',' << result.graphGemmMs
+                                        << ',' << result.graphSubmitUs
+                                        << ",\"" << result.graphStatus << '"';
+                                }
+                                if(runOpts.nChainGemms > 0)
+                                {
+                                    std::cout << ',' << result.hostChainGemmMs
+                                        << ',' << result.deviceChainGemmMs;
+                                }
+                                std::cout << std::endl;
+
+                                auto record = MakeShapeRecord("sgemm", result, padOpts);
+                                record.config.Add("ops", TesterType::GetOpsName());
+                                ResultsWriter::Get().Add(std::move(record));
+                            }
+                        }
+                    }
+                }
+                std::cout << "# ";
+                PinnedHostPool().ReportTo(std::cout);
+                std::cout << "# ";
+                DevicePool().ReportTo(std::cout);
             }
 
-            // Verify the GPU-computed results match the expected results.
-            tester.CheckComputation();
+            std::cout << "# ";
+            ReportPeakMemory(std::cout);
+
+            // Write the trace now, while the HIP runtime is still usable.
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+
+            // A result that failed verification fails the program.
+            if(ResultsWriter::Get().AnyFailed())
+            {
+                ret = 1;
+            }
+            ReleaseMemoryPools();
         }
     }
     catch(const HipException& e)
@@ -0,0 +1,381 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef DO_STORAGE_MAIN_H
+#define DO_STORAGE_MAIN_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "hipblas.h"
+#include "CommandLine.h"
+#include "HipEvent.h"
+#include "HipStream.h"
+#include "HipblasContext.h"
+#include "HipblasException.h"
+#include "HostTimer.h"
+#include "Matrix.h"
+#include "MatrixChecker.h"
+#include "MemoryPool.h"
+#include "ResultsWriter.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// What we learned from running one GEMM problem shape
+// with one kind of Matrix storage.
+struct StorageResult
+{
+    // Median device time of each phase of a run: uploading A, B,
+    // and C, the GEMM, and downloading C.  Device-only storage has
+    // no transfers.  For managed storage, the transfers are prefetches,
+    // and pages the runtime migrates on demand count in the GEMM.
+    double h2dMs = 0;
+    double gemmMs = 0;
+    double d2hMs = 0;
+
+    // Transfer bandwidth, only for storage with explicit copies:
+    // a prefetch may move less than the whole matrix, or nothing.
+    bool hasBandwidth = false;
+    double h2dGBps = 0;
+    double d2hGBps = 0;
+
+    // Wall clock time of each whole run, including any time
+    // the host spends staging pageable copies.
+    std::vector<double> endToEndSamples;
+    TimingStats endToEnd;
+
+    size_t nMismatches = 0;
+    double maxAbsErr = 0;
+};
+
+// Run C = alpha * A * B + beta * C as an application would, with
+// A, B, and C in the given storage: produce the inputs on the host,
+// copy them to the device, do the GEMM, and copy C back.
+// With device-only storage, the inputs are produced on the device
+// (by copies from pinned matrices, untimed) and C stays there.
+// The inputs are SgemmTester's pattern, so C should end up as
+// alpha + beta * r * c.
+inline
+StorageResult
+RunStorage(int m,
+            int n,
+            int k,
+            float alpha,
+            float beta,
+            MatrixStorage storage,
+            const RunOptions& runOpts,
+            const HipStream& hipStream,
+            const HipblasContext& blasContext)
+{
+    TraceSpan span(GetStorageName(storage), "storage");
+
+    const auto& layout = runOpts.init.layout;
+    const auto onHost = (storage != MatrixStorage::DeviceOnly);
+
+    // The inputs as the application produces them each run,
+    // kept in pinned matrices (and copied to their device
+    // storage, for device-only storage).
+    Matrix<float> sourceA(m, k, layout);
+    Matrix<float> sourceB(k, n, layout);
+    Matrix<float> sourceC(m, n, layout);
+    for(auto r = 0; r < m; ++r)
+    {
+        sourceA.El(r, 0) = 1;
+    }
+    for(auto c = 0; c < n; ++c)
+    {
+        sourceB.El(0, c) = 1;
+        for(auto r = 0; r < m; ++r)
+        {
+            sourceC.El(r, c) = static_cast<float>(static_cast<int64_t>(r) * c);
+        }
+    }
+    if(not onHost)
+    {
+        sourceA.CopyHostToDevice();
+        sourceB.CopyHostToDevice();
+        sourceC.CopyHostToDevice();
+    }
+
+    Matrix<float> A(m, k, layout, storage);
+    Matrix<float> B(k, n, layout, storage);
+    Matrix<float> C(m, n, layout, storage);
+    auto produce = [&](const Matrix<float>& source, Matrix<float>& dest) {
+        if(onHost)
+        {
+            std::copy_n(source.GetHostData(), source.GetNumStoredItems(), dest.GetHostData());
+        }
+        else
+        {
+            CHECK(hipMemcpyAsync(dest.GetDeviceData(),
+                                    source.GetDeviceData(),
+                                    source.GetSize(),
+                                    hipMemcpyDeviceToDevice,
+                                    hipStream.GetHandle()));
+        }
+    };
+    auto produceInputs = [&](void) {
+        TraceSpan span("produce inputs", "init");
+        produce(sourceA, A);
+        produce(sourceB, B);
+        produce(sourceC, C);
+        hipStream.Synchronize();
+    };
+
+    blasContext.UsePointerMode(HIPBLAS_POINTER_MODE_HOST);
+    HipEvent start;
+    HipEvent uploaded;
+    HipEvent computed;
+    HipEvent downloaded;
+    auto run = [&](void) {
+        start.Record(hipStream);
+        if(onHost)
+        {
+            A.CopyHostToDeviceAsync(hipStream);
+            B.CopyHostToDeviceAsync(hipStream);
+            C.CopyHostToDeviceAsync(hipStream);
+        }
+        uploaded.Record(hipStream);
+        CHECK(hipblasSgemm(blasContext.GetHandle(),
+                            HIPBLAS_OP_N,
+                            HIPBLAS_OP_N,
+                            m,
+                            n,
+                            k,
+                            &alpha,
+                            A.GetDeviceData(),
+                            A.GetLeadingDim(),
+                            B.GetDeviceData(),
+                            B.GetLeadingDim(),
+                            &beta,
+                            C.GetDeviceData(),
+                            C.GetLeadingDim()));
+        computed.Record(hipStream);
+        if(onHost)
+        {
+            C.CopyDeviceToHostAsync(hipStream);
+        }
+        downloaded.Record(hipStream);
+        hipStream.Synchronize();
+    };
+
+    for(auto i = 0; i < runOpts.bench.nWarmup; ++i)
+    {
+        produceInputs();
+        run();
+    }
+
+    StorageResult result;
+    std::vector<double> h2dSamples;
+    std::vector<double> gemmSamples;
+    std::vector<double> d2hSamples;
+    for(auto i = 0; i < runOpts.bench.nIters; ++i)
+    {
+        produceInputs();
+        HostTimer timer;
+        run();
+        result.endToEndSamples.push_back(timer.ElapsedMs());
+        h2dSamples.push_back(uploaded.ElapsedSince(start));
+        gemmSamples.push_back(computed.ElapsedSince(uploaded));
+        d2hSamples.push_back(downloaded.ElapsedSince(computed));
+    }
+    result.endToEnd = TimingStats(result.endToEndSamples);
+    result.gemmMs = TimingStats(gemmSamples).medianMs;
+    if(onHost)
+    {
+        result.h2dMs = TimingStats(h2dSamples).medianMs;
+        result.d2hMs = TimingStats(d2hSamples).medianMs;
+    }
+    result.hasBandwidth = onHost and (storage != MatrixStorage::Managed);
+    if(result.hasBandwidth)
+    {
+        auto inputBytes = (A.GetNumItems() + B.GetNumItems() + C.GetNumItems()) * sizeof(float);
+        result.h2dGBps = ToGBps(inputBytes, result.h2dMs);
+        result.d2hGBps = ToGBps(C.GetNumItems() * sizeof(float), result.d2hMs);
+    }
+
+    // Check the last run's result, where the host can see it.
+    Matrix<float> deviceResult(m, n, layout);
+    if(not onHost)
+    {
+        CHECK(hipMemcpy(deviceResult.GetHostData(), C.GetDeviceData(), C.GetSize(), hipMemcpyDeviceToHost));
+    }
+    auto fillExpected = [alpha, beta, m](int c, float* expected) {
+        for(auto r = 0; r < m; ++r)
+        {
+            expected[r] = alpha + beta * static_cast<float>(static_cast<int64_t>(r) * c);
+        }
+    };
+    auto check = CheckMatrix(onHost ? C : deviceResult, fillExpected, runOpts.check);
+    result.nMismatches = check.nMismatches;
+    result.maxAbsErr = check.maxAbsErr;
+    return result;
+}
+
+// For each problem shape, run the GEMM end to end with each of
+// the requested kinds of Matrix storage, and report the transfer
+// bandwidth and end-to-end time of each as CSV, alongside the
+// slowdown relative to the first, so the storage an application
+// uses for its buffers can be chosen from data.
+inline
+int
+DoStorageMain(int argc, char* argv[])
+{
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::vector<int> ms;
+        std::vector<int> ks;
+        std::vector<int> ns;
+        float alpha;
+        float beta;
+        bool verbose;
+        RunOptions runOpts;
+
+        // The inputs are always SgemmTester's pattern.
+        ProgramInfo program;
+        program.takesStorage = true;
+        program.takesInit = false;
+        program.defaultM = "256:4096:x4";
+        program.defaultN = "1024";
+        program.defaultK = "1024";
+
+        std::tie(shouldRun,
+                    ret,
+                    ms,
+                    ks,
+                    ns,
+                    alpha,
+                    beta,
+                    verbose,
+                    runOpts) = ParseCommandLine<float>(argc, argv, program);
+
+        if(shouldRun)
+        {
+            SetMemoryPoolsEnabled(runOpts.usePools);
+            TransferChunkBytes() = runOpts.transferChunkBytes;
+
+            HipStream hipStream;
+            HipblasContext blasContext(hipStream);
+
+            std::cout << "m,n,k,storage,h2d_ms,h2d_gbps,gemm_ms,d2h_ms,d2h_gbps,"
+                << "end_to_end_ms,end_to_end_p95_ms,end_to_end_gflops,slowdown_vs_first,mismatches,status"
+                << std::endl;
+            for(auto m : ms)
+            {
+                for(auto n : ns)
+                {
+                    for(auto k : ks)
+                    {
+                        double firstMs = 0;
+                        for(auto storage : runOpts.storages)
+                        {
+                            auto result = RunStorage(m, n, k,
+                                                        alpha, beta,
+                                                        storage,
+                                                        runOpts,
+                                                        hipStream, blasContext);
+                            if(firstMs == 0)
+                            {
+                                firstMs = result.endToEnd.medianMs;
+                            }
+                            auto gflops = ToGflops(2.0 * m * n * k, result.endToEnd.medianMs);
+
+                            // Bandwidth fields are empty where there is none.
+                            auto bandwidth = [&result](double gbps) {
+                                std::ostringstream os;
+                                if(result.hasBandwidth)
+                                {
+                                    os << gbps;
+                                }
+                                return os.str();
+                            };
+                            auto passed = (result.nMismatches == 0);
+                            std::cout << m << ',' << n << ',' << k
+                                << ',' << GetStorageName(storage)
+                                << ',' << result.h2dMs
+                                << ',' << bandwidth(result.h2dGBps)
+                                << ',' << result.gemmMs
+                                << ',' << result.d2hMs
+                                << ',' << bandwidth(result.d2hGBps)
+                                << ',' << result.endToEnd.medianMs
+                                << ',' << result.endToEnd.p95Ms
+                                << ',' << gflops
+                                << ',' << (result.endToEnd.medianMs / firstMs)
+                                << ',' << result.nMismatches
+                                << ',' << (passed ? "PASS" : "FAIL")
+                                << std::endl;
+
+                            ResultRecord record;
+                            record.config.Add("kind", "storage")
+                                .Add("m", m)
+                                .Add("n", n)
+                                .Add("k", k)
+                                .Add("storage", GetStorageName(storage));
+                            record.metrics.Add("gemm_ms", result.gemmMs)
+                                .Add("median_ms", result.endToEnd.medianMs)
+                                .Add("p95_ms", result.endToEnd.p95Ms)
+                                .Add("gflops", gflops)
+                                .Add("mismatches", result.nMismatches)
+                                .Add("max_abs_err", result.maxAbsErr);
+                            if(storage != MatrixStorage::DeviceOnly)
+                            {
+                                record.metrics.Add("h2d_ms", result.h2dMs)
+                                    .Add("d2h_ms", result.d2hMs);
+                            }
+                            if(result.hasBandwidth)
+                            {
+                                record.metrics.Add("h2d_gbps", result.h2dGBps)
+                                    .Add("d2h_gbps", result.d2hGBps);
+                            }
+                            record.samplesMs = result.endToEndSamples;
+                            record.passed = passed;
+                            ResultsWriter::Get().Add(std::move(record));
+                        }
+                    }
+                }
+            }
+
+            std::cout << "# ";
+            ReportPeakMemory(std::cout);
+
+            // Write the trace now, while the HIP runtime is still usable.
+            Tracer::Get().Finish(runOpts.tracePath);
+            ResultsWriter::Get().Finish(runOpts.resultsPath);
+
+            // A result that failed verification fails the program.
+            if(ResultsWriter::Get().AnyFailed())
+            {
+                ret = 1;
+            }
+            ReleaseMemoryPools();
+        }
+    }
+    catch(const HipException& e)
+    {
+        std::cerr << "HIP Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const HipblasException& e)
+    {
+        std::cerr << "hipBLAS Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}
+
+#endif // DO_STORAGE_MAIN_H
@@ -0,0 +1,143 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HIPBLAS_BATCHED_SGEMM_TESTER_H
+#define HIPBLAS_BATCHED_SGEMM_TESTER_H
+
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipblasException.h"
+#include "BatchedSgemmTester.h"
+#include "HipblasContext.h"
+#include "Trace.h"
+
+// What the batched testers below have in common: a hipBLAS handle,
+// owned by our caller as with HipblasSgemmTester.
+template<bool Transpose = false>
+class HipblasBatchedTesterBase : public BatchedSgemmTester<Transpose>
+{
+public:
+    using ExceptionType = HipblasException;
+    using ContextType = HipblasContext;
+
+protected:
+    const HipblasContext& blasContext;
+
+    static constexpr hipblasOperation_t opB = Transpose ? HIPBLAS_OP_T : HIPBLAS_OP_N;
+
+public:
+    HipblasBatchedTesterBase(int m,
+                                int n,
+                                int k,
+                                int nBatch,
+                                float alpha,
+                                float beta,
+                                const HipStream& hipStream,
+                                const HipblasContext& _blasContext,
+                                const InitOptions& init = InitOptions())
+      : BatchedSgemmTester<Transpose>(m, n, k, nBatch, alpha, beta, hipStream, init),
+        blasContext(_blasContext)
+    {
+        // nothing else to do.
+    }
+};
+
+// The baseline: one hipblasSgemm call per matrix in the batch.
+template<bool Transpose = false>
+class HipblasLoopedSgemmTester : public HipblasBatchedTesterBase<Transpose>
+{
+public:
+    using HipblasBatchedTesterBase<Transpose>::HipblasBatchedTesterBase;
+
+    static const char* GetName(void)    { return "loop"; }
+
+    void
+    EnqueueSgemm(void) override
+    {
+        DeviceTraceSpan span("hipblasSgemm loop", this->hipStream.GetHandle());
+        for(auto b = 0; b < this->A.GetBatchCount(); ++b)
+        {
+            CHECK(hipblasSgemm(this->blasContext.GetHandle(),
+                                HIPBLAS_OP_N,
+                                this->opB,
+                                this->A.GetNumRows(),
+                                this->C.GetNumMatrixCols(),
+                                this->A.GetNumMatrixCols(),
+                                &(this->alpha),
+                                this->A.GetDeviceMatrix(b),
+                                this->A.GetLeadingDim(),
+                                this->B.GetDeviceMatrix(b),
+                                this->B.GetLeadingDim(),
+                                &(this->beta),
+                                this->C.GetDeviceMatrix(b),
+                                this->C.GetLeadingDim()));
+        }
+    }
+};
+
+// One hipblasSgemmStridedBatched call for the whole batch.
+template<bool Transpose = false>
+class HipblasStridedBatchedSgemmTester : public HipblasBatchedTesterBase<Transpose>
+{
+public:
+    using HipblasBatchedTesterBase<Transpose>::HipblasBatchedTesterBase;
+
+    static const char* GetName(void)    { return "strided"; }
+
+    void
+    EnqueueSgemm(void) override
+    {
+        DeviceTraceSpan span("hipblasSgemmStridedBatched", this->hipStream.GetHandle());
+        CHECK(hipblasSgemmStridedBatched(this->blasContext.GetHandle(),
+                                            HIPBLAS_OP_N,
+                                            this->opB,
+                                            this->A.GetNumRows(),
+                                            this->C.GetNumMatrixCols(),
+                                            this->A.GetNumMatrixCols(),
+                                            &(this->alpha),
+                                            this->A.GetDeviceData(),
+                                            this->A.GetLeadingDim(),
+                                            this->A.GetStride(),
+                                            this->B.GetDeviceData(),
+                                            this->B.GetLeadingDim(),
+                                            this->B.GetStride(),
+                                            &(this->beta),
+                                            this->C.GetDeviceData(),
+                                            this->C.GetLeadingDim(),
+                                            this->C.GetStride(),
+                                            this->A.GetBatchCount()));
+    }
+};
+
+// One hipblasSgemmBatched call for the whole batch,
+// passing arrays of pointers to the matrices.
+template<bool Transpose = false>
+class HipblasPointerBatchedSgemmTester : public HipblasBatchedTesterBase<Transpose>
+{
+public:
+    using HipblasBatchedTesterBase<Transpose>::HipblasBatchedTesterBase;
+
+    static const char* GetName(void)    { return "batched"; }
+
+    void
+    EnqueueSgemm(void) override
+    {
+        DeviceTraceSpan span("hipblasSgemmBatched", this->hipStream.GetHandle());
+        CHECK(hipblasSgemmBatched(this->blasContext.GetHandle(),
+                                    HIPBLAS_OP_N,
+                                    this->opB,
+                                    this->A.GetNumRows(),
+                                    this->C.GetNumMatrixCols(),
+                                    this->A.GetNumMatrixCols(),
+                                    &(this->alpha),
+                                    this->A.GetDevicePointers(),
+                                    this->A.GetLeadingDim(),
+                                    this->B.GetDevicePointers(),
+                                    this->B.GetLeadingDim(),
+                                    &(this->beta),
+                                    this->C.GetDevicePointers(),
+                                    this->C.GetLeadingDim(),
+                                    this->A.GetBatchCount()));
+    }
+};
+
+#endif // HIPBLAS_BATCHED_SGEMM_TESTER_H
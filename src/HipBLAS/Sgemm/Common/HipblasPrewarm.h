@@ -0,0 +1,71 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TEST_HIPBLAS_PREWARM_H
+#define TEST_HIPBLAS_PREWARM_H
+
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipstarException.h"
+#include "HipblasContext.h"
+#include "HipblasException.h"
+#include "HipblasSgemmTester.h"
+#include "GemmOp.h"
+#include "Matrix.h"
+#include "Trace.h"
+
+// Pay the one-time costs of the first SGEMMs early, e.g., while
+// an application is still reading its input: runtime and device
+// context initialization, and loading (on CHIP-SPV, JIT compiling)
+// the library's GEMM kernels.  Does one tiny SGEMM with each of the
+// given ops on the context's stream and waits for them.
+// Kernels for other ops, or ones the library picks only for
+// larger shapes, may still be loaded on first use.
+inline
+void
+PrewarmHipblas(const HipStream& stream,
+                const HipblasContext& blasContext,
+                const std::vector<GemmOpPair>& ops = { { GemmOp::N, GemmOp::N } })
+{
+    TraceSpan span("prewarm", "setup");
+
+    constexpr int size = 8;
+    Matrix<float> A(size, size);
+    Matrix<float> B(size, size);
+    Matrix<float> C(size, size);
+    for(auto i = 0; i < size; ++i)
+    {
+        for(auto j = 0; j < size; ++j)
+        {
+            A.El(i, j) = B.El(i, j) = C.El(i, j) = 0;
+        }
+    }
+    A.CopyHostToDevice();
+    B.CopyHostToDevice();
+    C.CopyHostToDevice();
+
+    const float alpha = 1;
+    const float beta = 0;
+    blasContext.UsePointerMode(HIPBLAS_POINTER_MODE_HOST);
+    for(const auto& op : ops)
+    {
+        CHECK(hipblasSgemm(blasContext.GetHandle(),
+                            ToHipblasOperation(op.first),
+                            ToHipblasOperation(op.second),
+                            size,
+                            size,
+                            size,
+                            &alpha,
+                            A.GetDeviceData(),
+                            A.GetLeadingDim(),
+                            B.GetDeviceData(),
+                            B.GetLeadingDim(),
+                            &beta,
+                            C.GetDeviceData(),
+                            C.GetLeadingDim()));
+    }
+    stream.Synchronize();
+}
+
+#endif // TEST_HIPBLAS_PREWARM_H
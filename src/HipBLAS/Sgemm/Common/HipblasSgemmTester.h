@@ -3,72 +3,176 @@
 #ifndef HIPBLAS_SGEMM_TESTER_H
 #define HIPBLAS_SGEMM_TESTER_H
 
+#include <memory>
 #include "hipblas.h"
 #include "HipStream.h"
 #include "HipblasException.h"
 #include "SgemmTester.h"
 #include "HipblasContext.h"
+#include "HipblasOp.h"
+#include "Trace.h"
 
-template<bool Transpose = false>
-class HipblasSgemmTester : public SgemmTester<Transpose>
+template<GemmOp OpA = GemmOp::N, GemmOp OpB = GemmOp::N>
+class HipblasSgemmTester : public SgemmTester<OpA, OpB>
 {
 public:
     using ExceptionType = HipblasException;
+    using ContextType = HipblasContext;
 
 protected:
+    // The hipBLAS handle to use, bound to our stream.
+    // It is owned by our caller so that it can be shared by
+    // any number of testers (e.g., one per problem shape),
+    // and so that its creation cost is paid only once.
+    const HipblasContext& blasContext;
+
+    // Where hipBLAS reads alpha and beta from.  In device mode,
+    // they are kept (in that order) in a small device matrix.
+    hipblasPointerMode_t pointerMode;
+    std::unique_ptr<Matrix<float>> deviceScalars;
+
     bool UsesD(void) const override { return false; }
 
+    // Copy alpha and beta to the device, if not done yet, and wait for the copy.
+    void MakeDeviceScalars(void)
+    {
+        if(not deviceScalars)
+        {
+            deviceScalars = std::make_unique<Matrix<float>>(2, 1);
+            deviceScalars->El(0, 0) = this->alpha;
+            deviceScalars->El(1, 0) = this->beta;
+            deviceScalars->CopyHostToDevice();
+        }
+    }
+
 public:
     HipblasSgemmTester(int m,
                         int n,
                         int k,
                         float alpha,
                         float beta,
-                        const HipStream& hipStream)
-      : SgemmTester<Transpose>(m, n, k, alpha, beta, hipStream)
+                        const HipStream& hipStream,
+                        const HipblasContext& _blasContext,
+                        const InitOptions& init = InitOptions())
+      : SgemmTester<OpA, OpB>(m, n, k, alpha, beta, hipStream, init),
+        blasContext(_blasContext),
+        pointerMode(HIPBLAS_POINTER_MODE_HOST)
     {
-        // nothing else to do.
+        SetPointerMode(init.deviceScalars ? HIPBLAS_POINTER_MODE_DEVICE : HIPBLAS_POINTER_MODE_HOST);
     }
 
-    // Do the GEMM on the GPU.
+    // Pass alpha and beta to hipBLAS in host or device memory.
+    void SetPointerMode(hipblasPointerMode_t mode)
+    {
+        if(mode == HIPBLAS_POINTER_MODE_DEVICE)
+        {
+            MakeDeviceScalars();
+        }
+        pointerMode = mode;
+    }
+
+    hipblasPointerMode_t GetPointerMode(void) const { return pointerMode; }
+
+    // One step of a chain of dependent GEMMs whose scalars are
+    // produced on the device (e.g., by a reduction over the previous
+    // result), as in iterative solvers.  In host mode, the host must
+    // wait for the previous GEMM and read the scalars back before it
+    // can enqueue the next GEMM.  In device mode, the GEMM reads them
+    // where they are, so the host never waits.
+    void EnqueueChainStep(void)
+    {
+        if(pointerMode == HIPBLAS_POINTER_MODE_HOST)
+        {
+            MakeDeviceScalars();
+            this->hipStream.Synchronize();
+            deviceScalars->CopyDeviceToHost();
+            this->alpha = deviceScalars->El(0, 0);
+            this->beta = deviceScalars->El(1, 0);
+        }
+        EnqueueSgemm();
+    }
+
+    // Enqueue the GEMM on the GPU.
     void
-    DoSgemm(void) override
+    EnqueueSgemm(void) override
     {
-        HipblasContext blasContext(this->hipStream);
-
-#if READY
-        // We need the GEMM to assume our scalars
-        // are in host memory.
-        hipblasPointerMode_t desiredPointerMode = HIPBLAS_POINTER_MODE_HOST;
-        hipblasPointerMode_t pointerMode;
-        CHECK(hipblasGetPointerMode(blasContext.GetHandle(), &pointerMode));
-        if(pointerMode != desiredPointerMode)
+        // The handle may be shared with testers using the other mode.
+        blasContext.UsePointerMode(pointerMode);
+        const float* alphaPtr = &(this->alpha);
+        const float* betaPtr = &(this->beta);
+        if(pointerMode == HIPBLAS_POINTER_MODE_DEVICE)
         {
-            std::cout << "Changing pointer mode to read scalars from host memory." << std::endl;
-            CHECK(hipblasSetPointerMode(blasContext.GetHandle(), desiredPointerMode));
+            alphaPtr = deviceScalars->GetDeviceData();
+            betaPtr = deviceScalars->GetDeviceData() + 1;
         }
-#endif // rEADY
 
-        // This assumes column major ordering (the use of nRows for leading dimension).
-        // Use of nRows does not differ depending on whether B is transposed.
+        DeviceTraceSpan span("hipblasSgemm", this->hipStream.GetHandle());
+
+        // This assumes column major ordering.  The leading dimensions are
+        // those of the stored matrices, whether or not A or B is transposed.
         CHECK(hipblasSgemm(blasContext.GetHandle(),
-                            HIPBLAS_OP_N,
-                            Transpose ? HIPBLAS_OP_T : HIPBLAS_OP_N,
-                            this->A.GetNumRows(),
-                            this->C.GetNumCols(),
-                            this->A.GetNumCols(),
-                            &(this->alpha),
+                            ToHipblasOperation(OpA),
+                            ToHipblasOperation(OpB),
+                            this->GetM(),
+                            this->GetN(),
+                            this->GetK(),
+                            alphaPtr,
                             this->A.GetDeviceData(),
-                            this->A.GetNumRows(),
+                            this->A.GetLeadingDim(),
                             this->B.GetDeviceData(),
-                            this->B.GetNumRows(),
-                            &(this->beta),
+                            this->B.GetLeadingDim(),
+                            betaPtr,
                             this->C.GetDeviceData(),
-                            this->C.GetNumRows()));
+                            this->C.GetLeadingDim()));
+    }
+
+    // Enqueue one tile of a GEMM streamed through the device in tiles
+    // (see RunTiled): C = alpha * op(A) * op(B) + tileBeta * C, with
+    // op(A) m x k and op(B) k x n, on device buffers holding the tile's
+    // blocks.  The work goes on the stream the given context is bound to,
+    // with alpha and beta in host memory.
+    void EnqueueTileSgemm(const HipblasContext& tileContext,
+                            int m,
+                            int n,
+                            int k,
+                            const float* A,
+                            int lda,
+                            const float* B,
+                            int ldb,
+                            float tileBeta,
+                            float* C,
+                            int ldc) const
+    {
+        tileContext.UsePointerMode(HIPBLAS_POINTER_MODE_HOST);
+        CHECK(hipblasSgemm(tileContext.GetHandle(),
+                            ToHipblasOperation(OpA),
+                            ToHipblasOperation(OpB),
+                            m,
+                            n,
+                            k,
+                            &(this->alpha),
+                            A,
+                            lda,
+                            B,
+                            ldb,
+                            &tileBeta,
+                            C,
+                            ldc));
+    }
+
+    // Do the GEMM on the GPU.
+    void
+    DoSgemm(void) override
+    {
+        EnqueueSgemm();
         this->hipStream.Synchronize();
 
-        // Read computed result from device to host.
-        this->C.CopyDeviceToHostAsync(this->hipStream);
+        // Read computed result from device to host, unless
+        // it is to be checked where it is (lean mode).
+        if(not this->IsLean())
+        {
+            this->C.CopyDeviceToHostAsync(this->hipStream);
+        }
     }
 };
 
@@ -0,0 +1,219 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "CommandLine.h"
+#include "HipEvent.h"
+#include "HipStream.h"
+#include "HostTimer.h"
+
+// What we learned from running a queue of independent
+// GEMM problems serialized and pipelined.
+struct PipelineResult
+{
+    int nProblems = 0;
+    int nStreams = 0;
+
+    // Per-problem phase times on the serialized path.
+    double uploadMs = 0;
+    double gemmMs = 0;
+    double downloadMs = 0;
+
+    // Wall clock time for all problems.
+    double serialMs = 0;
+    double pipelinedMs = 0;
+
+    // Pipelined time if the phases overlapped perfectly: the total
+    // time of the busiest phase, with uploads, GEMMs, and downloads
+    // each running one at a time but alongside the other two.
+    double idealMs = 0;
+
+    // Fraction of the possible saving (serialMs - idealMs) that the
+    // pipelined run achieved, in [0, 1].  It is clamped because GEMMs
+    // on different streams may also overlap each other, which the
+    // ideal doesn't allow for, and pipelining may cost more than it saves.
+    double overlapEfficiency = 0;
+
+    size_t nMismatches = 0;
+};
+
+// Run nProblems GEMMs of one shape, each uploading its inputs,
+// doing the GEMM, and downloading its result, two ways:
+// * Serialized: one stream, waiting for each phase to finish.
+//   We also time each phase here.
+// * Pipelined: problems are dealt round-robin to the given streams
+//   (each with its own library context), and each stream has two
+//   sets of matrices.  Since work on different streams may run
+//   concurrently, uploads and downloads for some problems overlap
+//   GEMMs for others, and the double buffering lets the host enqueue
+//   a stream's next problem while its previous one is in flight.
+// The results from the last problem on each set of matrices are
+// verified, in full or with checksums as the run options say.
+template<typename TesterType>
+PipelineResult
+RunPipeline(int m,
+            int n,
+            int k,
+            float alpha,
+            float beta,
+            int nProblems,
+            const RunOptions& runOpts,
+            const std::vector<std::unique_ptr<HipStream>>& streams,
+            const std::vector<std::unique_ptr<typename TesterType::ContextType>>& libContexts)
+{
+    PipelineResult result;
+    result.nProblems = nProblems;
+    result.nStreams = static_cast<int>(streams.size());
+
+    auto countMismatches = [&runOpts](const TesterType& tester) -> size_t {
+        if(runOpts.verifyChecksums)
+        {
+            auto check = tester.CheckChecksums(runOpts.check, true);
+            return check.badRows.size() + check.badCols.size();
+        }
+        return tester.CheckComputation(runOpts.check, true).nMismatches;
+    };
+
+    // Serialized path, on the first stream.
+    {
+        const auto& hipStream = *streams[0];
+        TesterType tester(m, n, k, alpha, beta, hipStream, *libContexts[0], runOpts.init);
+        hipStream.Synchronize();
+
+        // Absorb one-time costs like JIT compilation.
+        for(auto i = 0; i < runOpts.bench.nWarmup; ++i)
+        {
+            tester.EnqueueSgemm();
+        }
+        hipStream.Synchronize();
+
+        HipEvent start;
+        HipEvent uploaded;
+        HipEvent computed;
+        HipEvent downloaded;
+        HostTimer timer;
+        for(auto i = 0; i < nProblems; ++i)
+        {
+            start.Record(hipStream);
+            tester.EnqueueUpload();
+            uploaded.Record(hipStream);
+            hipStream.Synchronize();
+
+            tester.EnqueueSgemm();
+            computed.Record(hipStream);
+            hipStream.Synchronize();
+
+            tester.EnqueueDownload();
+            downloaded.Record(hipStream);
+            hipStream.Synchronize();
+
+            result.uploadMs += uploaded.ElapsedSince(start);
+            result.gemmMs += computed.ElapsedSince(uploaded);
+            result.downloadMs += downloaded.ElapsedSince(computed);
+        }
+        result.serialMs = timer.ElapsedMs();
+        result.uploadMs /= nProblems;
+        result.gemmMs /= nProblems;
+        result.downloadMs /= nProblems;
+
+        result.nMismatches += countMismatches(tester);
+    }
+
+    // Pipelined path.
+    struct Slot
+    {
+        std::unique_ptr<TesterType> tester;
+        HipEvent done;
+        bool busy = false;
+    };
+    constexpr int nBuffersPerStream = 2;
+    std::vector<std::unique_ptr<Slot>> slots;
+    for(auto b = 0; b < nBuffersPerStream; ++b)
+    {
+        for(size_t s = 0; s < streams.size(); ++s)
+        {
+            auto slot = std::make_unique<Slot>();
+            slot->tester = std::make_unique<TesterType>(m, n, k, alpha, beta, *streams[s], *libContexts[s], runOpts.init);
+            slots.push_back(std::move(slot));
+        }
+    }
+
+    // Absorb one-time costs on each stream and library context,
+    // and the first use of each slot's matrices, as the serialized
+    // path did for its own.  As in the timed loop below, a slot's
+    // upload waits until its previous download has finished, since
+    // the upload rewrites the host C that download writes.
+    for(auto i = 0; i < runOpts.bench.nWarmup; ++i)
+    {
+        for(size_t j = 0; j < slots.size(); ++j)
+        {
+            auto& slot = *slots[j];
+            if(slot.busy)
+            {
+                slot.done.Synchronize();
+            }
+            slot.tester->EnqueueUpload();
+            slot.tester->EnqueueSgemm();
+            slot.tester->EnqueueDownload();
+            slot.done.Record(*streams[j % streams.size()]);
+            slot.busy = true;
+        }
+    }
+    for(const auto& s : streams)
+    {
+        s->Synchronize();
+    }
+    for(const auto& slot : slots)
+    {
+        slot->busy = false;
+    }
+
+    // Slot i % nSlots is on stream i % nStreams, so consecutive
+    // problems go to different streams, and a stream alternates
+    // between its two slots.
+    HostTimer timer;
+    for(auto i = 0; i < nProblems; ++i)
+    {
+        auto& slot = *slots[i % slots.size()];
+        if(slot.busy)
+        {
+            // Wait for the previous problem using these
+            // matrices to finish downloading its result.
+            slot.done.Synchronize();
+        }
+        const auto& hipStream = *streams[i % streams.size()];
+        slot.tester->EnqueueUpload();
+        slot.tester->EnqueueSgemm();
+        slot.tester->EnqueueDownload();
+        slot.done.Record(hipStream);
+        slot.busy = true;
+    }
+    for(const auto& s : streams)
+    {
+        s->Synchronize();
+    }
+    result.pipelinedMs = timer.ElapsedMs();
+
+    for(const auto& slot : slots)
+    {
+        if(slot->busy)
+        {
+            result.nMismatches += countMismatches(*slot->tester);
+        }
+    }
+
+    result.idealMs = nProblems * std::max({ result.uploadMs, result.gemmMs, result.downloadMs });
+    auto possibleSaving = result.serialMs - result.idealMs;
+    result.overlapEfficiency = (possibleSaving > 0)
+        ? std::clamp((result.serialMs - result.pipelinedMs) / possibleSaving, 0.0, 1.0)
+        : 0;
+
+    return result;
+}
+
+#endif // PIPELINE_H
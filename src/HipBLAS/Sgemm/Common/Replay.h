@@ -0,0 +1,380 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "hipblas.h"
+#include "CommandLine.h"
+#include "GemmTrace.h"
+#include "HipEvent.h"
+#include "HipStream.h"
+#include "HipblasContext.h"
+#include "HipblasPrewarm.h"
+#include "HipblasSgemmTester.h"
+#include "HostTimer.h"
+#include "Matrix.h"
+#include "ResultsWriter.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// The calls of a replayed trace that fall in one shape class
+// (see GetShapeClass).
+struct ShapeClassResult
+{
+    std::string name;
+    size_t nCalls = 0;
+
+    // Sum of the calls' median device times, and their throughput.
+    double gemmMs = 0;
+    double gflops = 0;
+
+    // Device time of the class's calls in each timed pass.
+    std::vector<double> passSamples;
+};
+
+// What we learned from replaying a GEMM trace.
+struct ReplayResult
+{
+    size_t nCalls = 0;
+    int nStreams = 0;
+    double nFlops = 0;
+
+    // Wall clock time of each timed pass over the whole trace.
+    std::vector<double> passSamples;
+    TimingStats stats;
+    double gflops = 0;
+
+    // Median device time of each call over the timed passes.
+    std::vector<double> callMs;
+
+    // Classes, most time first.
+    std::vector<ShapeClassResult> classes;
+
+    // Indices of calls, slowest first.
+    std::vector<size_t> slowest;
+
+    // Time to pre-warm the replay's handles (with --prewarm).
+    double prewarmMs = 0;
+};
+
+// Calls of similar shapes tend to perform alike, so we report
+// throughput by class: the ops and each dimension rounded up to
+// a power of two, e.g., "NT 512x4096x64".
+inline
+std::string
+GetShapeClass(const TracedGemm& call)
+{
+    auto roundUp = [](int dim) {
+        int ret = 1;
+        while(ret < dim)
+        {
+            ret *= 2;
+        }
+        return ret;
+    };
+    return GetOpPairName(call.ops)
+        + ' ' + std::to_string(roundUp(call.m))
+        + 'x' + std::to_string(roundUp(call.n))
+        + 'x' + std::to_string(roundUp(call.k));
+}
+
+// Replay a trace of GEMM calls with hipBLAS.  Each of the trace's
+// streams gets its own HIP stream and hipBLAS handle, and one set of
+// matrices with storage for the largest operands of that stream's
+// calls, which every call on the stream reuses with its own shape
+// and leading dimensions.  Calls are enqueued in trace order, each
+// on its stream after waiting (on the device) for the calls it
+// depends on, so the replay keeps the application's concurrency.
+// The inputs hold small values so that accumulating into C over
+// many calls stays finite; results are not verified.
+//
+// Without benchmarking, the trace is replayed once untimed, to pay
+// one-time costs (e.g., kernel compilation), and once timed;
+// otherwise, as many times as the benchmark options say.  Each call
+// is timed with events on its stream.
+inline
+ReplayResult
+ReplayGemmTrace(const GemmTrace& trace, const RunOptions& runOpts)
+{
+    const auto& calls = trace.calls;
+    const auto nWarmup = runOpts.bench.enabled ? runOpts.bench.nWarmup : 1;
+    const auto nPasses = runOpts.bench.enabled ? runOpts.bench.nIters : 1;
+
+    ReplayResult result;
+    result.nCalls = calls.size();
+    result.nStreams = trace.nStreams;
+
+    std::vector<std::unique_ptr<HipStream>> streams;
+    std::vector<std::unique_ptr<HipblasContext>> contexts;
+    std::vector<size_t> maxA(trace.nStreams, 1);
+    std::vector<size_t> maxB(trace.nStreams, 1);
+    std::vector<size_t> maxC(trace.nStreams, 1);
+    for(const auto& call : calls)
+    {
+        maxA[call.stream] = std::max(maxA[call.stream], call.GetNumStoredA());
+        maxB[call.stream] = std::max(maxB[call.stream], call.GetNumStoredB());
+        maxC[call.stream] = std::max(maxC[call.stream], call.GetNumStoredC());
+        result.nFlops += call.GetFlopCount();
+    }
+
+    // Each matrix is one column long enough for the largest operand.
+    auto maxElements = std::max({ *std::max_element(maxA.begin(), maxA.end()),
+                                    *std::max_element(maxB.begin(), maxB.end()),
+                                    *std::max_element(maxC.begin(), maxC.end()) });
+    if(maxElements > static_cast<size_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::length_error("a traced GEMM operand has too many elements to replay");
+    }
+    std::vector<std::unique_ptr<Matrix<float>>> As;
+    std::vector<std::unique_ptr<Matrix<float>>> Bs;
+    std::vector<std::unique_ptr<Matrix<float>>> Cs;
+    for(auto s = 0; s < trace.nStreams; ++s)
+    {
+        streams.emplace_back(std::make_unique<HipStream>());
+        contexts.emplace_back(std::make_unique<HipblasContext>(*streams.back()));
+        contexts.back()->UsePointerMode(HIPBLAS_POINTER_MODE_HOST);
+
+        As.emplace_back(std::make_unique<Matrix<float>>(static_cast<int>(maxA[s]), 1));
+        Bs.emplace_back(std::make_unique<Matrix<float>>(static_cast<int>(maxB[s]), 1));
+        Cs.emplace_back(std::make_unique<Matrix<float>>(static_cast<int>(maxC[s]), 1));
+        for(auto* input : { As.back().get(), Bs.back().get() })
+        {
+            auto data = input->GetHostData();
+            for(size_t i = 0; i < input->GetNumItems(); ++i)
+            {
+                data[i] = static_cast<float>(static_cast<int>(i % 17) - 8) / 64;
+            }
+            input->CopyHostToDeviceAsync(*streams.back());
+        }
+        Cs.back()->GetDeviceData();
+    }
+    for(auto& stream : streams)
+    {
+        stream->Synchronize();
+    }
+    for(auto s = 0; s < trace.nStreams; ++s)
+    {
+        As[s]->ReleaseHostStorage();
+        Bs[s]->ReleaseHostStorage();
+    }
+
+    // Pre-warm the handles the replay uses, with the trace's ops.
+    if(runOpts.prewarm)
+    {
+        std::vector<GemmOpPair> ops;
+        for(const auto& call : calls)
+        {
+            if(std::find(ops.begin(), ops.end(), call.ops) == ops.end())
+            {
+                ops.push_back(call.ops);
+            }
+        }
+        HostTimer prewarmTimer;
+        for(auto s = 0; s < trace.nStreams; ++s)
+        {
+            PrewarmHipblas(*streams[s], *contexts[s], ops);
+        }
+        result.prewarmMs = prewarmTimer.ElapsedMs();
+    }
+
+    std::vector<HipEvent> starts(calls.size());
+    std::vector<HipEvent> ends(calls.size());
+    auto replay = [&]() {
+        for(size_t i = 0; i < calls.size(); ++i)
+        {
+            const auto& call = calls[i];
+            const auto& stream = *streams[call.stream];
+            for(auto dep : call.after)
+            {
+                if(calls[dep].stream != call.stream)
+                {
+                    ends[dep].MakeStreamWait(stream);
+                }
+            }
+
+            starts[i].Record(stream);
+            CHECK(hipblasSgemm(contexts[call.stream]->GetHandle(),
+                                ToHipblasOperation(call.ops.first),
+                                ToHipblasOperation(call.ops.second),
+                                call.m,
+                                call.n,
+                                call.k,
+                                &call.alpha,
+                                As[call.stream]->GetDeviceData(),
+                                call.lda,
+                                Bs[call.stream]->GetDeviceData(),
+                                call.ldb,
+                                &call.beta,
+                                Cs[call.stream]->GetDeviceData(),
+                                call.ldc));
+            ends[i].Record(stream);
+        }
+        for(auto& stream : streams)
+        {
+            stream->Synchronize();
+        }
+    };
+
+    for(auto pass = 0; pass < nWarmup; ++pass)
+    {
+        TraceSpan span("replay warmup", "gemm");
+        replay();
+    }
+
+    // Each call's class, with classes in order of first appearance.
+    std::vector<size_t> classOf;
+    std::vector<double> classFlops;
+    std::map<std::string, size_t> classIdx;
+    for(const auto& call : calls)
+    {
+        auto name = GetShapeClass(call);
+        auto iter = classIdx.emplace(name, classIdx.size()).first;
+        if(iter->second == result.classes.size())
+        {
+            result.classes.emplace_back();
+            result.classes.back().name = name;
+            classFlops.push_back(0);
+        }
+        classOf.push_back(iter->second);
+        ++result.classes[iter->second].nCalls;
+        classFlops[iter->second] += call.GetFlopCount();
+    }
+
+    std::vector<std::vector<double>> callSamples(calls.size());
+    for(auto pass = 0; pass < nPasses; ++pass)
+    {
+        TraceSpan span("replay", "gemm");
+        HostTimer timer;
+        replay();
+        result.passSamples.push_back(timer.ElapsedMs());
+
+        for(auto& shapeClass : result.classes)
+        {
+            shapeClass.passSamples.push_back(0);
+        }
+        for(size_t i = 0; i < calls.size(); ++i)
+        {
+            auto ms = ends[i].ElapsedSince(starts[i]);
+            callSamples[i].push_back(ms);
+            result.classes[classOf[i]].passSamples.back() += ms;
+        }
+    }
+    result.stats = TimingStats(result.passSamples);
+    result.gflops = ToGflops(result.nFlops, result.stats.medianMs);
+
+    for(size_t i = 0; i < calls.size(); ++i)
+    {
+        result.callMs.push_back(TimingStats(callSamples[i]).medianMs);
+        result.classes[classOf[i]].gemmMs += result.callMs.back();
+    }
+    for(size_t c = 0; c < result.classes.size(); ++c)
+    {
+        result.classes[c].gflops = ToGflops(classFlops[c], result.classes[c].gemmMs);
+    }
+    std::sort(result.classes.begin(),
+                result.classes.end(),
+                [](const ShapeClassResult& a, const ShapeClassResult& b) { return a.gemmMs > b.gemmMs; });
+
+    for(size_t i = 0; i < calls.size(); ++i)
+    {
+        result.slowest.push_back(i);
+    }
+    std::stable_sort(result.slowest.begin(),
+                        result.slowest.end(),
+                        [&result](size_t a, size_t b) { return result.callMs[a] > result.callMs[b]; });
+
+    return result;
+}
+
+// Replay the trace at runOpts.replayPath, and report the time by shape
+// class and the slowest calls on standard output and in the results.
+inline
+void
+RunReplay(const RunOptions& runOpts)
+{
+    constexpr size_t nSlowestReported = 10;
+    auto trace = LoadGemmTrace(runOpts.replayPath);
+    auto result = ReplayGemmTrace(trace, runOpts);
+
+    if(runOpts.prewarm)
+    {
+        std::cout << "# prewarm time: " << result.prewarmMs << " ms" << std::endl;
+    }
+    std::cout << "# trace " << runOpts.replayPath << ": " << result.nCalls << " calls on "
+        << result.nStreams << " streams, " << result.passSamples.size() << " timed passes\n"
+        << "# replay time: " << result.stats << '\n'
+        << "# replay GFLOP/s: " << result.gflops << " (median)\n"
+        << "class,calls,gemm_ms,gemm_pct,gflops"
+        << std::endl;
+    double totalGemmMs = 0;
+    for(const auto& shapeClass : result.classes)
+    {
+        totalGemmMs += shapeClass.gemmMs;
+    }
+    for(const auto& shapeClass : result.classes)
+    {
+        std::cout << shapeClass.name
+            << ',' << shapeClass.nCalls
+            << ',' << shapeClass.gemmMs
+            << ',' << ((totalGemmMs > 0) ? (100.0 * shapeClass.gemmMs / totalGemmMs) : 0.0)
+            << ',' << shapeClass.gflops
+            << std::endl;
+
+        ResultRecord record;
+        record.config.Add("kind", "replay_class")
+            .Add("trace", runOpts.replayPath)
+            .Add("class", shapeClass.name);
+        record.metrics.Add("calls", shapeClass.nCalls)
+            .Add("median_ms", TimingStats(shapeClass.passSamples).medianMs)
+            .Add("gflops", shapeClass.gflops);
+        record.samplesMs = shapeClass.passSamples;
+        ResultsWriter::Get().Add(std::move(record));
+    }
+
+    std::cout << "# slowest calls\n"
+        << "call,line,ops,m,n,k,lda,ldb,ldc,alpha,beta,stream,ms,gflops"
+        << std::endl;
+    for(size_t i = 0; i < std::min(nSlowestReported, result.slowest.size()); ++i)
+    {
+        auto idx = result.slowest[i];
+        const auto& call = trace.calls[idx];
+        std::cout << idx
+            << ',' << call.lineNumber
+            << ',' << GetOpPairName(call.ops)
+            << ',' << call.m
+            << ',' << call.n
+            << ',' << call.k
+            << ',' << call.lda
+            << ',' << call.ldb
+            << ',' << call.ldc
+            << ',' << call.alpha
+            << ',' << call.beta
+            << ',' << call.stream
+            << ',' << result.callMs[idx]
+            << ',' << ToGflops(call.GetFlopCount(), result.callMs[idx])
+            << std::endl;
+    }
+
+    ResultRecord record;
+    record.config.Add("kind", "replay")
+        .Add("trace", runOpts.replayPath)
+        .Add("calls", result.nCalls)
+        .Add("streams", result.nStreams);
+    record.metrics.Add("min_ms", result.stats.minMs)
+        .Add("median_ms", result.stats.medianMs)
+        .Add("mean_ms", result.stats.meanMs)
+        .Add("p95_ms", result.stats.p95Ms)
+        .Add("gflops", result.gflops);
+    record.samplesMs = result.passSamples;
+    ResultsWriter::Get().Add(std::move(record));
+}
+
+#endif // REPLAY_H
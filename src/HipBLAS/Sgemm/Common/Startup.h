@@ -0,0 +1,201 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "hip/hip_runtime_api.h"
+#include "CommandLine.h"
+#include "HipStream.h"
+#include "HipblasPrewarm.h"
+#include "HostTimer.h"
+#include "MemoryPool.h"
+#include "TimingStats.h"
+
+// How long each step up to the second GEMM took, in a process
+// that had not used HIP before.
+struct StartupProfile
+{
+    // The first HIP call (hipInit), which initializes the runtime.
+    double firstHipCallMs = 0;
+    double streamCreateMs = 0;
+    double handleCreateMs = 0;
+
+    // Zero unless pre-warmed.
+    double prewarmMs = 0;
+
+    // Allocating and initializing the GEMM's matrices.
+    double setupMs = 0;
+
+    // Enqueueing a GEMM and waiting for it.
+    double firstGemmMs = 0;
+    double secondGemmMs = 0;
+
+    // From before the first HIP call until the first GEMM completed.
+    double timeToFirstGemmMs = 0;
+};
+
+// Statistics of some quantity derived from each of several profiles.
+inline
+TimingStats
+StartupStats(const std::vector<StartupProfile>& profiles,
+                std::function<double(const StartupProfile&)> quantity)
+{
+    std::vector<double> samples;
+    for(const auto& profile : profiles)
+    {
+        samples.push_back(quantity(profile));
+    }
+    return TimingStats(samples);
+}
+
+// The median time of each step over several profiles.
+inline
+StartupProfile
+MedianStartupProfile(const std::vector<StartupProfile>& profiles)
+{
+    StartupProfile median;
+    for(auto step : { &StartupProfile::firstHipCallMs,
+                        &StartupProfile::streamCreateMs,
+                        &StartupProfile::handleCreateMs,
+                        &StartupProfile::prewarmMs,
+                        &StartupProfile::setupMs,
+                        &StartupProfile::firstGemmMs,
+                        &StartupProfile::secondGemmMs,
+                        &StartupProfile::timeToFirstGemmMs })
+    {
+        median.*step = StartupStats(profiles, [step](const StartupProfile& p){ return p.*step; }).medianMs;
+    }
+    return median;
+}
+
+// Time the startup steps in this process, which must not have
+// used HIP yet.  If prewarm, call PrewarmHipblas after creating
+// the handle, as an application would early on.
+template<typename TesterType>
+StartupProfile
+ProfileStartup(int m,
+                int n,
+                int k,
+                float alpha,
+                float beta,
+                bool prewarm,
+                const RunOptions& runOpts)
+{
+    StartupProfile profile;
+    HostTimer total;
+    HostTimer timer;
+
+    CHECK(hipInit(0));
+    profile.firstHipCallMs = timer.ElapsedMs();
+
+    timer.Restart();
+    HipStream hipStream;
+    profile.streamCreateMs = timer.ElapsedMs();
+
+    timer.Restart();
+    typename TesterType::ContextType libContext(hipStream);
+    profile.handleCreateMs = timer.ElapsedMs();
+
+    if(prewarm)
+    {
+        timer.Restart();
+        PrewarmHipblas(hipStream, libContext, { TesterType::GetOps() });
+        profile.prewarmMs = timer.ElapsedMs();
+    }
+
+    timer.Restart();
+    TesterType tester(m, n, k, alpha, beta, hipStream, libContext, runOpts.init);
+    hipStream.Synchronize();
+    profile.setupMs = timer.ElapsedMs();
+
+    timer.Restart();
+    tester.EnqueueSgemm();
+    hipStream.Synchronize();
+    profile.firstGemmMs = timer.ElapsedMs();
+    profile.timeToFirstGemmMs = total.ElapsedMs();
+
+    timer.Restart();
+    tester.EnqueueSgemm();
+    hipStream.Synchronize();
+    profile.secondGemmMs = timer.ElapsedMs();
+
+    return profile;
+}
+
+// Run ProfileStartup in a child process, so that it starts cold
+// however much this process has done, and return the child's profile.
+// This process must not have used HIP yet, since a process that has
+// initialized the runtime may not fork.
+// Note that caches that outlive a process (e.g., the driver's cache
+// of compiled kernels) may make later children start faster.
+template<typename TesterType>
+StartupProfile
+ProfileStartupInChild(int m,
+                        int n,
+                        int k,
+                        float alpha,
+                        float beta,
+                        bool prewarm,
+                        const RunOptions& runOpts)
+{
+    int fds[2];
+    if(pipe(fds) != 0)
+    {
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
+
+    std::cout << std::flush;
+    auto pid = fork();
+    if(pid < 0)
+    {
+        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+    }
+    if(pid == 0)
+    {
+        // Child: report the profile through the pipe, or nothing if
+        // we failed, and leave without running the parent's cleanup.
+        close(fds[0]);
+        int status = 1;
+        try
+        {
+            auto profile = ProfileStartup<TesterType>(m, n, k, alpha, beta, prewarm, runOpts);
+            ReleaseMemoryPools();
+            if(write(fds[1], &profile, sizeof(profile)) == static_cast<ssize_t>(sizeof(profile)))
+            {
+                status = 0;
+            }
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << "startup profile: " << e.what() << std::endl;
+        }
+        close(fds[1]);
+        _exit(status);
+    }
+
+    close(fds[1]);
+    StartupProfile profile;
+    auto nRead = read(fds[0], &profile, sizeof(profile));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if( (nRead != static_cast<ssize_t>(sizeof(profile)))
+        or not WIFEXITED(status)
+        or (WEXITSTATUS(status) != 0) )
+    {
+        throw std::runtime_error("startup profile child process failed");
+    }
+    return profile;
+}
+
+#endif // STARTUP_H
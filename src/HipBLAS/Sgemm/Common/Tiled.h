@@ -0,0 +1,348 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef TILED_H
+#define TILED_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "hip/hip_runtime_api.h"
+#include "CommandLine.h"
+#include "GemmOp.h"
+#include "HipEvent.h"
+#include "HipStream.h"
+#include "HostTimer.h"
+#include "Matrix.h"
+#include "TimingStats.h"
+#include "Trace.h"
+
+// Dimensions of the blocks a tiled GEMM streams through the device:
+// C is computed in m x n tiles, each accumulated over k-long panels
+// of op(A) (m x k) and op(B) (k x n).
+struct TileShape
+{
+    int m = 0;
+    int n = 0;
+    int k = 0;
+};
+
+// Choose the largest tiles for which each of nLanes streams'
+// buffers (a tile of C and two panels each of op(A) and op(B),
+// see RunTiled) fit in its share of budgetBytes of device memory.
+// Tiles are square where the problem allows.  A dimension that fits
+// whole is not split; otherwise it is split into blocks rounded down
+// to a multiple of 64, so the library sees friendly shapes.  If k is
+// short, the room its panels don't need goes to bigger C tiles.
+inline
+TileShape
+ChooseTileShape(size_t budgetBytes, int nLanes, int m, int n, int k)
+{
+    // Floats each lane may use: t*t for C, plus 2 * (t*t + t*t)
+    // for the panels, when all three dimensions are t.
+    auto laneItems = static_cast<double>(budgetBytes / sizeof(float) / nLanes);
+    auto fit = [](int dim, double most) {
+        auto t = static_cast<int>(most);
+        return (dim <= t) ? dim : ((t >= 64) ? (t / 64) * 64 : t);
+    };
+
+    TileShape tile;
+    tile.k = fit(k, std::sqrt(laneItems / 5));
+
+    // With the panels' k fixed, solve s*s + 4*k*s <= laneItems
+    // for square C tiles of side s.
+    auto kt = static_cast<double>(tile.k);
+    auto side = std::sqrt(4 * kt * kt + laneItems) - 2 * kt;
+    tile.m = fit(m, side);
+    tile.n = fit(n, side);
+
+    if( (tile.m < 1) or (tile.n < 1) or (tile.k < 1) )
+    {
+        throw std::invalid_argument("device budget is too small for tiles on "
+                                    + std::to_string(nLanes) + " streams");
+    }
+    return tile;
+}
+
+// What we learned from running one GEMM problem shape out of core,
+// streamed through the device in tiles, and, if it fits in the
+// device budget, in core.
+struct TiledResult
+{
+    int nStreams = 0;
+    TileShape tile;
+    int nTiles = 0;
+
+    // Device memory held by the tiled path's buffers.
+    size_t deviceBytes = 0;
+
+    // Wall clock time of each whole GEMM, including all copies.
+    std::vector<double> tiledSamples;
+    TimingStats tiled;
+
+    // The same, uploading whole matrices, doing one GEMM, and
+    // downloading C, if the whole problem fits in the budget.
+    bool inCoreFits = false;
+    std::vector<double> inCoreSamples;
+    TimingStats inCore;
+
+    size_t nMismatches = 0;
+    double maxAbsErr = 0;
+};
+
+// One stream's share of the device budget for RunTiled.  GEMMs run on
+// the lane's compute stream (the one its library context is bound to)
+// and copies on its copy stream.  Its C tile stays on the device while
+// the GEMM accumulates into it over the panels of A and B, and there
+// are two sets of panels, so the next pair can be uploaded while the
+// GEMM uses the current one.
+struct TiledLane
+{
+    // A pair of panel buffers, and events saying when the
+    // panels have been uploaded and when the GEMM is done with them.
+    struct Panels
+    {
+        Matrix<float> A;
+        Matrix<float> B;
+        HipEvent uploaded;
+        HipEvent consumed;
+
+        Panels(int aRows, int aCols, int bRows, int bCols)
+          : A(aRows, aCols),
+            B(bRows, bCols)
+        { }
+    };
+
+    HipStream copyStream;
+    Matrix<float> C;
+    std::unique_ptr<Panels> panels[2];
+    HipEvent computed;
+
+    // Number of panel pairs used so far, to alternate between them.
+    size_t nPanelsUsed = 0;
+
+    TiledLane(const TileShape& tile, bool transA, bool transB)
+      : C(tile.m, tile.n)
+    {
+        for(auto& p : panels)
+        {
+            p = std::make_unique<Panels>(transA ? tile.k : tile.m,
+                                            transA ? tile.m : tile.k,
+                                            transB ? tile.n : tile.k,
+                                            transB ? tile.k : tile.n);
+        }
+
+        // Allocate the device storage up front, so none is
+        // allocated (or zeroed) while the GEMM is timed.
+        C.GetDeviceData();
+        for(auto& p : panels)
+        {
+            p->A.GetDeviceData();
+            p->B.GetDeviceData();
+        }
+    }
+
+    size_t GetDeviceBytes(void) const
+    {
+        return C.GetSize() + 2 * (panels[0]->A.GetSize() + panels[0]->B.GetSize());
+    }
+};
+
+// Run C = alpha * op(A) * op(B) + beta * C with A, B, and C kept on
+// the host, streaming them through at most budgetBytes of device
+// memory, so problems too big for the device can be run:
+// * C is divided into tiles (see ChooseTileShape), which are dealt
+//   round-robin to the given streams (each with its own library
+//   context), so copies for some tiles overlap GEMMs for others.
+// * For each tile, the lane uploads the tile of C, then uploads
+//   k-long panels of op(A) and op(B) into alternate buffers and
+//   accumulates their product into the tile: the first GEMM
+//   scales C by beta, and later ones add to it with beta = 1.
+//   Then it downloads the tile over C's host copy.
+// The whole GEMM is timed end to end, as is the usual in-core path
+// (upload everything, one GEMM, download C) if the problem fits in
+// the budget.  Both results are verified.
+template<typename TesterType>
+TiledResult
+RunTiled(int m,
+            int n,
+            int k,
+            float alpha,
+            float beta,
+            size_t budgetBytes,
+            const RunOptions& runOpts,
+            const std::vector<std::unique_ptr<HipStream>>& streams,
+            const std::vector<std::unique_ptr<typename TesterType::ContextType>>& libContexts)
+{
+    TraceSpan span("RunTiled", "tiled");
+
+    const auto transA = IsTransposed(TesterType::GetOps().first);
+    const auto transB = IsTransposed(TesterType::GetOps().second);
+
+    TiledResult result;
+    result.nStreams = static_cast<int>(streams.size());
+    result.tile = ChooseTileShape(budgetBytes, result.nStreams, m, n, k);
+    const auto& tile = result.tile;
+    auto nRowTiles = (m + tile.m - 1) / tile.m;
+    auto nColTiles = (n + tile.n - 1) / tile.n;
+    result.nTiles = nRowTiles * nColTiles;
+
+    // Tiled path.
+    {
+        auto hostOpts = runOpts.init;
+        hostOpts.hostOnly = true;
+        TesterType tester(m, n, k, alpha, beta, *streams[0], *libContexts[0], hostOpts);
+
+        std::vector<std::unique_ptr<TiledLane>> lanes;
+        for(size_t s = 0; s < streams.size(); ++s)
+        {
+            lanes.push_back(std::make_unique<TiledLane>(tile, transA, transB));
+            result.deviceBytes += lanes.back()->GetDeviceBytes();
+        }
+
+        const auto* hostA = tester.GetHostA();
+        const auto* hostB = tester.GetHostB();
+        auto* hostC = tester.GetHostC();
+        auto lda = static_cast<size_t>(tester.GetLda());
+        auto ldb = static_cast<size_t>(tester.GetLdb());
+        auto ldc = static_cast<size_t>(tester.GetLdc());
+
+        auto run = [&](void) {
+            for(auto t = 0; t < result.nTiles; ++t)
+            {
+                auto& lane = *lanes[t % lanes.size()];
+                const auto& computeStream = *streams[t % streams.size()];
+                const auto& libContext = *libContexts[t % libContexts.size()];
+                auto copy = lane.copyStream.GetHandle();
+
+                auto i0 = (t % nRowTiles) * tile.m;
+                auto j0 = (t / nRowTiles) * tile.n;
+                auto mb = std::min(tile.m, m - i0);
+                auto nb = std::min(tile.n, n - j0);
+
+                // The copy stream is still in order after the
+                // download of the lane's previous tile of C.
+                auto ldcTile = lane.C.GetLeadingDim();
+                CHECK(hipMemcpy2DAsync(lane.C.GetDeviceData(), ldcTile * sizeof(float),
+                                        &hostC[j0 * ldc + i0], ldc * sizeof(float),
+                                        mb * sizeof(float), nb,
+                                        hipMemcpyHostToDevice,
+                                        copy));
+
+                for(auto p0 = 0; p0 < k; p0 += tile.k)
+                {
+                    auto kb = std::min(tile.k, k - p0);
+                    auto& panels = *lane.panels[lane.nPanelsUsed++ % 2];
+
+                    // Don't overwrite panels the GEMM two steps back
+                    // is still reading.
+                    panels.consumed.MakeStreamWait(lane.copyStream);
+
+                    // op(A)[i0:i0+mb, p0:p0+kb] and op(B)[p0:p0+kb, j0:j0+nb],
+                    // in the same storage order as the host matrices.
+                    auto aLd = panels.A.GetLeadingDim();
+                    CHECK(hipMemcpy2DAsync(panels.A.GetDeviceData(), aLd * sizeof(float),
+                                            transA ? &hostA[i0 * lda + p0] : &hostA[p0 * lda + i0],
+                                            lda * sizeof(float),
+                                            (transA ? kb : mb) * sizeof(float),
+                                            transA ? mb : kb,
+                                            hipMemcpyHostToDevice,
+                                            copy));
+                    auto bLd = panels.B.GetLeadingDim();
+                    CHECK(hipMemcpy2DAsync(panels.B.GetDeviceData(), bLd * sizeof(float),
+                                            transB ? &hostB[p0 * ldb + j0] : &hostB[j0 * ldb + p0],
+                                            ldb * sizeof(float),
+                                            (transB ? nb : kb) * sizeof(float),
+                                            transB ? kb : nb,
+                                            hipMemcpyHostToDevice,
+                                            copy));
+                    panels.uploaded.Record(lane.copyStream);
+
+                    panels.uploaded.MakeStreamWait(computeStream);
+                    tester.EnqueueTileSgemm(libContext,
+                                            mb, nb, kb,
+                                            panels.A.GetDeviceData(), aLd,
+                                            panels.B.GetDeviceData(), bLd,
+                                            (p0 == 0) ? beta : 1.0f,
+                                            lane.C.GetDeviceData(), ldcTile);
+                    panels.consumed.Record(computeStream);
+                }
+
+                lane.computed.Record(computeStream);
+                lane.computed.MakeStreamWait(lane.copyStream);
+                CHECK(hipMemcpy2DAsync(&hostC[j0 * ldc + i0], ldc * sizeof(float),
+                                        lane.C.GetDeviceData(), ldcTile * sizeof(float),
+                                        mb * sizeof(float), nb,
+                                        hipMemcpyDeviceToHost,
+                                        copy));
+            }
+
+            // Each lane's last work is a download on its copy stream.
+            for(const auto& lane : lanes)
+            {
+                lane->copyStream.Synchronize();
+            }
+        };
+
+        // One untimed pass absorbs one-time costs like JIT
+        // compilation; each pass is already many GEMMs.
+        if(runOpts.bench.nWarmup > 0)
+        {
+            run();
+        }
+        for(auto i = 0; i < runOpts.bench.nIters; ++i)
+        {
+            tester.ResetOutput();
+            HostTimer timer;
+            run();
+            result.tiledSamples.push_back(timer.ElapsedMs());
+        }
+        result.tiled = TimingStats(result.tiledSamples);
+
+        auto check = tester.CheckComputation(runOpts.check, true);
+        result.nMismatches += check.nMismatches;
+        result.maxAbsErr = std::max(result.maxAbsErr, check.maxAbsErr);
+    }
+
+    // In-core path, on the first stream, if the whole problem fits.
+    {
+        auto opA = transA ? static_cast<size_t>(k) * m : static_cast<size_t>(m) * k;
+        auto opB = transB ? static_cast<size_t>(n) * k : static_cast<size_t>(k) * n;
+        auto inCoreBytes = (opA + opB + static_cast<size_t>(m) * n) * sizeof(float);
+        result.inCoreFits = (inCoreBytes <= budgetBytes);
+    }
+    if(result.inCoreFits)
+    {
+        const auto& hipStream = *streams[0];
+        TesterType tester(m, n, k, alpha, beta, hipStream, *libContexts[0], runOpts.init);
+        hipStream.Synchronize();
+
+        auto run = [&](void) {
+            tester.EnqueueUpload();
+            tester.EnqueueSgemm();
+            tester.EnqueueDownload();
+            hipStream.Synchronize();
+        };
+        if(runOpts.bench.nWarmup > 0)
+        {
+            run();
+        }
+        for(auto i = 0; i < runOpts.bench.nIters; ++i)
+        {
+            HostTimer timer;
+            run();
+            result.inCoreSamples.push_back(timer.ElapsedMs());
+        }
+        result.inCore = TimingStats(result.inCoreSamples);
+
+        auto check = tester.CheckComputation(runOpts.check, true);
+        result.nMismatches += check.nMismatches;
+        result.maxAbsErr = std::max(result.maxAbsErr, check.maxAbsErr);
+    }
+
+    return result;
+}
+
+#endif // TILED_H
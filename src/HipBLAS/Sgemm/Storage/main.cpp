@@ -0,0 +1,9 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include "DoStorageMain.h"
+
+int
+main(int argc, char* argv[])
+{
+    return DoStorageMain(argc, argv);
+}
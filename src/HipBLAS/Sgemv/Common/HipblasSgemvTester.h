@@ -0,0 +1,70 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HIPBLAS_SGEMV_TESTER_H
+#define HIPBLAS_SGEMV_TESTER_H
+
+#include "hipblas.h"
+#include "HipStream.h"
+#include "HipblasException.h"
+#include "GemvTester.h"
+#include "HipblasContext.h"
+#include "HipblasOp.h"
+#include "Trace.h"
+
+template<GemmOp Op = GemmOp::N>
+class HipblasSgemvTester : public GemvTester<Op>
+{
+public:
+    using ExceptionType = HipblasException;
+    using ContextType = HipblasContext;
+
+    // Whether problems have a second dimension to sweep.
+    static constexpr bool hasN = true;
+
+protected:
+    // The hipBLAS handle to use, bound to our stream,
+    // owned by our caller.
+    const HipblasContext& blasContext;
+
+public:
+    HipblasSgemvTester(int m,
+                        int n,
+                        float alpha,
+                        float beta,
+                        const HipStream& hipStream,
+                        const HipblasContext& _blasContext,
+                        const InitOptions& init = InitOptions())
+      : GemvTester<Op>(m, n, alpha, beta, hipStream, init),
+        blasContext(_blasContext)
+    { }
+
+    static const char* GetName(void)
+    {
+        return (Op == GemmOp::N) ? "sgemv_n" : ((Op == GemmOp::T) ? "sgemv_t" : "sgemv_c");
+    }
+
+    // Enqueue the GEMV on the GPU.
+    void
+    Enqueue(void) override
+    {
+        blasContext.UsePointerMode(HIPBLAS_POINTER_MODE_HOST);
+
+        DeviceTraceSpan span("hipblasSgemv", this->hipStream.GetHandle());
+
+        // This assumes column major ordering.
+        CHECK(hipblasSgemv(blasContext.GetHandle(),
+                            ToHipblasOperation(Op),
+                            this->GetM(),
+                            this->GetN(),
+                            &(this->alpha),
+                            this->A.GetDeviceData(),
+                            this->A.GetLeadingDim(),
+                            this->x.GetDeviceData(),
+                            1,
+                            &(this->beta),
+                            this->y.GetDeviceData(),
+                            1));
+    }
+};
+
+#endif // HIPBLAS_SGEMV_TESTER_H
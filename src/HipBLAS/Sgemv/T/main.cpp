@@ -0,0 +1,10 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include "HipblasSgemvTester.h"
+#include "DoBandwidthMain.h"
+
+int
+main(int argc, char* argv[])
+{
+    return DoBandwidthMain<HipblasSgemvTester<GemmOp::T>>(argc, argv, "256:8192:x2", "4096");
+}
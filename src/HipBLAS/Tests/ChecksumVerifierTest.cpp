@@ -0,0 +1,130 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+//
+// Check that ChecksumVerifier passes a correctly computed GEMM and
+// catches an error in any single element, with k large enough that
+// tolerances which grow with the number of terms would hide it.
+// Exits with 1 if any check goes the wrong way.
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "ChecksumVerifier.h"
+
+namespace
+{
+
+// D = alpha * A * B + beta * C, column major, summing each element
+// in order in float: the least accurate summation a GEMM might use.
+std::vector<float>
+NaiveGemm(int m,
+            int n,
+            int k,
+            float alpha,
+            const std::vector<float>& A,
+            const std::vector<float>& B,
+            float beta,
+            const std::vector<float>& C)
+{
+    std::vector<float> D(static_cast<size_t>(m) * n);
+    for(auto j = 0; j < n; ++j)
+    {
+        for(auto i = 0; i < m; ++i)
+        {
+            float sum = 0;
+            for(auto p = 0; p < k; ++p)
+            {
+                sum += A[static_cast<size_t>(p) * m + i] * B[static_cast<size_t>(j) * k + p];
+            }
+            auto idx = static_cast<size_t>(j) * m + i;
+            D[idx] = alpha * sum + beta * C[idx];
+        }
+    }
+    return D;
+}
+
+} // namespace
+
+int
+main(void)
+{
+    constexpr int m = 32;
+    constexpr int n = 24;
+    constexpr int k = 16384;
+    constexpr float alpha = 1.5f;
+    constexpr float beta = 0.5f;
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto fill = [&](std::vector<float>& v) {
+        for(auto& x : v)
+        {
+            x = dist(gen);
+        }
+    };
+    std::vector<float> A(static_cast<size_t>(m) * k);
+    std::vector<float> B(static_cast<size_t>(k) * n);
+    std::vector<float> C(static_cast<size_t>(m) * n);
+    fill(A);
+    fill(B);
+    fill(C);
+    auto D = NaiveGemm(m, n, k, alpha, A, B, beta, C);
+
+    ChecksumVerifier<float> verifier(false, false, m, n, k, alpha, A.data(), m, B.data(), k, beta);
+    verifier.SetInput(C.data(), m);
+
+    int ret = 0;
+    auto clean = verifier.Check(D.data(), m);
+    if(not clean.Passed())
+    {
+        std::cerr << "FAIL: correct result rejected" << std::endl;
+        ReportChecksums(std::cerr, clean, 10);
+        ret = 1;
+    }
+
+    // Elements are typically around sqrt(k) / 3 in magnitude.  An error
+    // of 1 in one of them should show up in its row and its column,
+    // and nowhere else.  So should zeroing one.
+    std::uniform_int_distribution<int> rowDist(0, m - 1);
+    std::uniform_int_distribution<int> colDist(0, n - 1);
+    int nMissed = 0;
+    constexpr int nTrials = 20;
+    for(auto trial = 0; trial < 2 * nTrials; ++trial)
+    {
+        auto r = rowDist(gen);
+        auto c = colDist(gen);
+        auto corrupted = D;
+        auto& el = corrupted[static_cast<size_t>(c) * m + r];
+        if(trial < nTrials)
+        {
+            el += 1.0f;
+        }
+        else if(std::fabs(el) >= 1.0f)
+        {
+            el = 0;
+        }
+        else
+        {
+            continue;
+        }
+
+        auto result = verifier.Check(corrupted.data(), m);
+        auto located = (result.badRows == std::vector<int>{ r })
+            and (result.badCols == std::vector<int>{ c });
+        if(not located)
+        {
+            std::cerr << "FAIL: " << ((trial < nTrials) ? "error of 1" : "zeroed element")
+                << " at (" << r << ", " << c << ") not located" << std::endl;
+            ReportChecksums(std::cerr, result, 10);
+            ++nMissed;
+        }
+    }
+    if(nMissed > 0)
+    {
+        ret = 1;
+    }
+
+    std::cout << ((ret == 0) ? "PASS" : "FAIL") << std::endl;
+    return ret;
+}
@@ -0,0 +1,881 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "hip/hip_runtime_api.h"
+#include "StandInRuntime.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct ihipGraph
+{
+    std::vector<std::function<void(void)>> ops;
+};
+
+struct hipGraphExec
+{
+    std::vector<std::function<void(void)>> ops;
+};
+
+struct ihipStream_t
+{
+    std::mutex mtx;
+    std::condition_variable workCv;
+    std::condition_variable idleCv;
+    std::deque<std::function<void(void)>> queue;
+    bool busy = false;
+    bool stopping = false;
+    hipError_t stickyError = hipSuccess;
+
+    // Non-null while the stream is being captured into a graph.
+    ihipGraph* capture = nullptr;
+
+    std::thread worker;
+
+    ihipStream_t(void)
+      : worker(&ihipStream_t::Run, this)
+    { }
+
+    ~ihipStream_t(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        workCv.notify_all();
+        worker.join();
+    }
+
+    void Run(void)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while(true)
+        {
+            workCv.wait(lock, [this]{ return stopping or not queue.empty(); });
+            if(queue.empty())
+            {
+                break;
+            }
+            auto op = std::move(queue.front());
+            queue.pop_front();
+            busy = true;
+            lock.unlock();
+
+            hipError_t err = hipSuccess;
+            try
+            {
+                op();
+            }
+            catch(...)
+            {
+                err = hipErrorUnknown;
+            }
+
+            lock.lock();
+            busy = false;
+            if((err != hipSuccess) and (stickyError == hipSuccess))
+            {
+                stickyError = err;
+            }
+            if(queue.empty())
+            {
+                idleCv.notify_all();
+            }
+        }
+    }
+
+    void Push(std::function<void(void)> op)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queue.push_back(std::move(op));
+        }
+        workCv.notify_one();
+    }
+
+    hipError_t Synchronize(void)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        idleCv.wait(lock, [this]{ return queue.empty() and not busy; });
+        auto err = stickyError;
+        stickyError = hipSuccess;
+        return err;
+    }
+
+    // Wait for the stream to drain, leaving any error
+    // for the stream's own synchronization to report.
+    hipError_t Wait(void)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        idleCv.wait(lock, [this]{ return queue.empty() and not busy; });
+        return stickyError;
+    }
+
+    bool IsIdle(void)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return queue.empty() and not busy;
+    }
+};
+
+// Counts down to zero, so work on one stream can wait
+// for work queued earlier on others.
+struct Latch
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t count;
+
+    explicit Latch(size_t _count)
+      : count(_count)
+    { }
+
+    void CountDown(void)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(--count == 0)
+        {
+            cv.notify_all();
+        }
+    }
+
+    void Wait(void)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this]{ return count == 0; });
+    }
+};
+
+struct ihipEvent_t
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    uint64_t nRecorded = 0;
+    uint64_t nCompleted = 0;
+    Clock::time_point when;
+};
+
+namespace
+{
+
+// Process-wide runtime state.
+struct Runtime
+{
+    std::mutex mtx;
+    std::set<ihipStream_t*> streams;
+    std::map<void*, size_t> deviceAllocations;
+    std::set<void*> managedAllocations;
+    size_t deviceBytesInUse = 0;
+    size_t deviceBytesTotal = 0;
+
+    Runtime(void)
+    {
+        // Report physical memory as "device" memory unless told otherwise.
+        if(const char* envMB = std::getenv("HIP_STANDIN_DEVICE_MEMORY_MB"))
+        {
+            deviceBytesTotal = static_cast<size_t>(std::strtoull(envMB, nullptr, 10)) << 20;
+        }
+        else
+        {
+            deviceBytesTotal = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+        }
+    }
+
+    ihipStream_t* NullStream(void)
+    {
+        static ihipStream_t nullStream;
+        return &nullStream;
+    }
+
+    ihipStream_t* Resolve(hipStream_t stream)
+    {
+        return (stream == nullptr) ? NullStream() : stream;
+    }
+
+    // Wait for all streams to drain, and report the first error any
+    // of them hit.  The errors are left for each stream's own
+    // synchronization, so waiting here doesn't hide them.
+    hipError_t SynchronizeAll(void)
+    {
+        std::vector<ihipStream_t*> toSync;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            toSync.assign(streams.begin(), streams.end());
+        }
+        toSync.push_back(NullStream());
+
+        hipError_t ret = hipSuccess;
+        for(auto s : toSync)
+        {
+            auto err = s->Wait();
+            if(ret == hipSuccess)
+            {
+                ret = err;
+            }
+        }
+        return ret;
+    }
+};
+
+Runtime&
+TheRuntime(void)
+{
+    static Runtime runtime;
+    return runtime;
+}
+
+void*
+AlignedAlloc(size_t size)
+{
+    // Match the coarse alignment real device allocators provide.
+    constexpr size_t alignment = 256;
+    size_t roundedSize = ((size + alignment - 1) / alignment) * alignment;
+    return std::aligned_alloc(alignment, (roundedSize > 0) ? roundedSize : alignment);
+}
+
+void
+Copy2D(void* dst, size_t dpitch, const void* src, size_t spitch, size_t width, size_t height)
+{
+    auto d = static_cast<char*>(dst);
+    auto s = static_cast<const char*>(src);
+    if((dpitch == width) and (spitch == width))
+    {
+        std::memcpy(d, s, width * height);
+        return;
+    }
+    for(size_t row = 0; row < height; ++row)
+    {
+        std::memcpy(d + row * dpitch, s + row * spitch, width);
+    }
+}
+
+} // namespace
+
+
+namespace HipStandIn
+{
+
+hipError_t
+Enqueue(hipStream_t stream, std::function<void(void)> op)
+{
+    auto& rt = TheRuntime();
+    auto s = rt.Resolve(stream);
+    {
+        std::lock_guard<std::mutex> lock(s->mtx);
+        if(s->capture != nullptr)
+        {
+            s->capture->ops.push_back(std::move(op));
+            return hipSuccess;
+        }
+    }
+
+    // Like the legacy default stream, work on the null stream waits
+    // for all work queued earlier on other streams, and work on other
+    // streams waits for work queued earlier on the null stream.
+    // The markers that signal the waiting op are queued before it,
+    // so two threads enqueueing at once can't wait on each other.
+    if(stream == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(rt.mtx);
+        auto latch = std::make_shared<Latch>(rt.streams.size() + 1);
+        for(auto other : rt.streams)
+        {
+            other->Push([latch]{ latch->CountDown(); });
+        }
+        latch->CountDown();
+        s->Push([latch, op = std::move(op)]{
+            latch->Wait();
+            op();
+        });
+    }
+    else if(not rt.NullStream()->IsIdle())
+    {
+        auto latch = std::make_shared<Latch>(1);
+        rt.NullStream()->Push([latch]{ latch->CountDown(); });
+        s->Push([latch, op = std::move(op)]{
+            latch->Wait();
+            op();
+        });
+    }
+    else
+    {
+        s->Push(std::move(op));
+    }
+    return hipSuccess;
+}
+
+} // namespace HipStandIn
+
+
+hipError_t
+hipInit(unsigned int /* flags */)
+{
+    TheRuntime();
+    return hipSuccess;
+}
+
+hipError_t
+hipGetDeviceCount(int* count)
+{
+    if(count == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    TheRuntime();
+    *count = 1;
+    return hipSuccess;
+}
+
+hipError_t
+hipGetDevice(int* deviceId)
+{
+    if(deviceId == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    *deviceId = 0;
+    return hipSuccess;
+}
+
+hipError_t
+hipSetDevice(int deviceId)
+{
+    return (deviceId == 0) ? hipSuccess : hipErrorInvalidDevice;
+}
+
+hipError_t
+hipDeviceSynchronize(void)
+{
+    return TheRuntime().SynchronizeAll();
+}
+
+hipError_t
+hipRuntimeGetVersion(int* runtimeVersion)
+{
+    if(runtimeVersion == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    *runtimeVersion = 0;
+    return hipSuccess;
+}
+
+hipError_t
+hipGetDeviceProperties(hipDeviceProp_t* prop, int deviceId)
+{
+    if( (prop == nullptr) or (deviceId != 0) )
+    {
+        return hipErrorInvalidValue;
+    }
+    std::memset(prop, 0, sizeof(*prop));
+    std::strncpy(prop->name, "Host stand-in device", sizeof(prop->name) - 1);
+    prop->totalGlobalMem = TheRuntime().deviceBytesTotal;
+    prop->multiProcessorCount = static_cast<int>(std::thread::hardware_concurrency());
+    return hipSuccess;
+}
+
+hipError_t
+hipMemGetInfo(size_t* free, size_t* total)
+{
+    auto& rt = TheRuntime();
+    std::lock_guard<std::mutex> lock(rt.mtx);
+    if(free != nullptr)
+    {
+        *free = rt.deviceBytesTotal - rt.deviceBytesInUse;
+    }
+    if(total != nullptr)
+    {
+        *total = rt.deviceBytesTotal;
+    }
+    return hipSuccess;
+}
+
+const char*
+hipGetErrorString(hipError_t error)
+{
+    switch(error)
+    {
+        case hipSuccess: return "hipSuccess";
+        case hipErrorInvalidValue: return "hipErrorInvalidValue";
+        case hipErrorOutOfMemory: return "hipErrorOutOfMemory";
+        case hipErrorNotInitialized: return "hipErrorNotInitialized";
+        case hipErrorInvalidDevice: return "hipErrorInvalidDevice";
+        case hipErrorInvalidResourceHandle: return "hipErrorInvalidResourceHandle";
+        case hipErrorNotReady: return "hipErrorNotReady";
+        case hipErrorNotSupported: return "hipErrorNotSupported";
+        case hipErrorStreamCaptureUnsupported: return "hipErrorStreamCaptureUnsupported";
+        case hipErrorStreamCaptureInvalidated: return "hipErrorStreamCaptureInvalidated";
+        default: return "hipErrorUnknown";
+    }
+}
+
+hipError_t
+hipGetLastError(void)
+{
+    return hipSuccess;
+}
+
+hipError_t
+hipMalloc(void** ptr, size_t size)
+{
+    if(ptr == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+
+    auto& rt = TheRuntime();
+    {
+        std::lock_guard<std::mutex> lock(rt.mtx);
+        if(rt.deviceBytesInUse + size > rt.deviceBytesTotal)
+        {
+            return hipErrorOutOfMemory;
+        }
+    }
+
+    *ptr = AlignedAlloc(size);
+    if(*ptr == nullptr)
+    {
+        return hipErrorOutOfMemory;
+    }
+
+    std::lock_guard<std::mutex> lock(rt.mtx);
+    rt.deviceAllocations[*ptr] = size;
+    rt.deviceBytesInUse += size;
+    return hipSuccess;
+}
+
+hipError_t
+hipFree(void* ptr)
+{
+    if(ptr == nullptr)
+    {
+        return hipSuccess;
+    }
+
+    // Like the real runtime, freeing device memory synchronizes the device.
+    auto& rt = TheRuntime();
+    auto err = rt.SynchronizeAll();
+    {
+        std::lock_guard<std::mutex> lock(rt.mtx);
+        auto iter = rt.deviceAllocations.find(ptr);
+        if(iter != rt.deviceAllocations.end())
+        {
+            rt.deviceBytesInUse -= iter->second;
+            rt.deviceAllocations.erase(iter);
+        }
+        else if(rt.managedAllocations.erase(ptr) == 0)
+        {
+            return hipErrorInvalidValue;
+        }
+    }
+    std::free(ptr);
+    return err;
+}
+
+hipError_t
+hipHostMalloc(void** ptr, size_t size, unsigned int /* flags */)
+{
+    if(ptr == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    *ptr = AlignedAlloc(size);
+    return (*ptr != nullptr) ? hipSuccess : hipErrorOutOfMemory;
+}
+
+hipError_t
+hipHostFree(void* ptr)
+{
+    auto err = TheRuntime().SynchronizeAll();
+    std::free(ptr);
+    return err;
+}
+
+hipError_t
+hipMallocManaged(void** ptr, size_t size, unsigned int /* flags */)
+{
+    if(ptr == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    *ptr = AlignedAlloc(size);
+    if(*ptr == nullptr)
+    {
+        return hipErrorOutOfMemory;
+    }
+
+    auto& rt = TheRuntime();
+    std::lock_guard<std::mutex> lock(rt.mtx);
+    rt.managedAllocations.insert(*ptr);
+    return hipSuccess;
+}
+
+hipError_t
+hipMemPrefetchAsync(const void* ptr, size_t count, int device, hipStream_t stream)
+{
+    if( ((ptr == nullptr) and (count > 0)) or ((device != 0) and (device != hipCpuDeviceId)) )
+    {
+        return hipErrorInvalidValue;
+    }
+    return HipStandIn::Enqueue(stream, []{ });
+}
+
+hipError_t
+hipMemsetAsync(void* dst, int value, size_t sizeBytes, hipStream_t stream)
+{
+    if((dst == nullptr) and (sizeBytes > 0))
+    {
+        return hipErrorInvalidValue;
+    }
+    return HipStandIn::Enqueue(stream, [=]{ std::memset(dst, value, sizeBytes); });
+}
+
+hipError_t
+hipMemset(void* dst, int value, size_t sizeBytes)
+{
+    auto err = hipMemsetAsync(dst, value, sizeBytes, nullptr);
+    if(err != hipSuccess)
+    {
+        return err;
+    }
+    return TheRuntime().NullStream()->Synchronize();
+}
+
+hipError_t
+hipMemcpyAsync(void* dst, const void* src, size_t sizeBytes, hipMemcpyKind /* kind */, hipStream_t stream)
+{
+    if(((dst == nullptr) or (src == nullptr)) and (sizeBytes > 0))
+    {
+        return hipErrorInvalidValue;
+    }
+    return HipStandIn::Enqueue(stream, [=]{ std::memcpy(dst, src, sizeBytes); });
+}
+
+hipError_t
+hipMemcpy(void* dst, const void* src, size_t sizeBytes, hipMemcpyKind kind)
+{
+    // The blocking copy goes on the null stream, so it is
+    // ordered after all outstanding work.
+    auto err = hipMemcpyAsync(dst, src, sizeBytes, kind, nullptr);
+    if(err != hipSuccess)
+    {
+        return err;
+    }
+    return TheRuntime().NullStream()->Synchronize();
+}
+
+hipError_t
+hipMemcpy2DAsync(void* dst,
+                    size_t dpitch,
+                    const void* src,
+                    size_t spitch,
+                    size_t width,
+                    size_t height,
+                    hipMemcpyKind /* kind */,
+                    hipStream_t stream)
+{
+    if((width > dpitch) or (width > spitch))
+    {
+        return hipErrorInvalidValue;
+    }
+    if(((dst == nullptr) or (src == nullptr)) and (width * height > 0))
+    {
+        return hipErrorInvalidValue;
+    }
+    return HipStandIn::Enqueue(stream, [=]{ Copy2D(dst, dpitch, src, spitch, width, height); });
+}
+
+hipError_t
+hipMemcpy2D(void* dst,
+            size_t dpitch,
+            const void* src,
+            size_t spitch,
+            size_t width,
+            size_t height,
+            hipMemcpyKind kind)
+{
+    auto err = hipMemcpy2DAsync(dst, dpitch, src, spitch, width, height, kind, nullptr);
+    if(err != hipSuccess)
+    {
+        return err;
+    }
+    return TheRuntime().NullStream()->Synchronize();
+}
+
+hipError_t
+hipStreamCreate(hipStream_t* stream)
+{
+    if(stream == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    auto s = new ihipStream_t;
+    auto& rt = TheRuntime();
+    std::lock_guard<std::mutex> lock(rt.mtx);
+    rt.streams.insert(s);
+    *stream = s;
+    return hipSuccess;
+}
+
+hipError_t
+hipStreamDestroy(hipStream_t stream)
+{
+    if(stream == nullptr)
+    {
+        return hipErrorInvalidResourceHandle;
+    }
+    auto& rt = TheRuntime();
+    {
+        std::lock_guard<std::mutex> lock(rt.mtx);
+        if(rt.streams.erase(stream) == 0)
+        {
+            return hipErrorInvalidResourceHandle;
+        }
+    }
+    stream->Synchronize();
+    delete stream;
+    return hipSuccess;
+}
+
+hipError_t
+hipStreamSynchronize(hipStream_t stream)
+{
+    return TheRuntime().Resolve(stream)->Synchronize();
+}
+
+hipError_t
+hipStreamQuery(hipStream_t stream)
+{
+    return TheRuntime().Resolve(stream)->IsIdle() ? hipSuccess : hipErrorNotReady;
+}
+
+hipError_t
+hipStreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int /* flags */)
+{
+    if(event == nullptr)
+    {
+        return hipErrorInvalidResourceHandle;
+    }
+
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(event->mtx);
+        target = event->nRecorded;
+    }
+    return HipStandIn::Enqueue(stream, [=]{
+        std::unique_lock<std::mutex> lock(event->mtx);
+        event->cv.wait(lock, [=]{ return event->nCompleted >= target; });
+    });
+}
+
+hipError_t
+hipEventCreate(hipEvent_t* event)
+{
+    if(event == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    *event = new ihipEvent_t;
+    return hipSuccess;
+}
+
+hipError_t
+hipEventDestroy(hipEvent_t event)
+{
+    if(event == nullptr)
+    {
+        return hipErrorInvalidResourceHandle;
+    }
+    hipEventSynchronize(event);
+    delete event;
+    return hipSuccess;
+}
+
+hipError_t
+hipEventRecord(hipEvent_t event, hipStream_t stream)
+{
+    if(event == nullptr)
+    {
+        return hipErrorInvalidResourceHandle;
+    }
+
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(event->mtx);
+        generation = ++event->nRecorded;
+    }
+    return HipStandIn::Enqueue(stream, [=]{
+        {
+            std::lock_guard<std::mutex> lock(event->mtx);
+            event->when = Clock::now();
+            if(generation > event->nCompleted)
+            {
+                event->nCompleted = generation;
+            }
+        }
+        event->cv.notify_all();
+    });
+}
+
+hipError_t
+hipEventSynchronize(hipEvent_t event)
+{
+    if(event == nullptr)
+    {
+        return hipErrorInvalidResourceHandle;
+    }
+    std::unique_lock<std::mutex> lock(event->mtx);
+    auto target = event->nRecorded;
+    event->cv.wait(lock, [=]{ return event->nCompleted >= target; });
+    return hipSuccess;
+}
+
+hipError_t
+hipEventQuery(hipEvent_t event)
+{
+    if(event == nullptr)
+    {
+        return hipErrorInvalidResourceHandle;
+    }
+    std::lock_guard<std::mutex> lock(event->mtx);
+    return (event->nCompleted >= event->nRecorded) ? hipSuccess : hipErrorNotReady;
+}
+
+hipError_t
+hipEventElapsedTime(float* ms, hipEvent_t start, hipEvent_t stop)
+{
+    if((ms == nullptr) or (start == nullptr) or (stop == nullptr))
+    {
+        return hipErrorInvalidValue;
+    }
+
+    Clock::time_point startTime;
+    Clock::time_point stopTime;
+    {
+        std::lock_guard<std::mutex> lock(start->mtx);
+        if((start->nRecorded == 0) or (start->nCompleted < start->nRecorded))
+        {
+            return hipErrorNotReady;
+        }
+        startTime = start->when;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stop->mtx);
+        if((stop->nRecorded == 0) or (stop->nCompleted < stop->nRecorded))
+        {
+            return hipErrorNotReady;
+        }
+        stopTime = stop->when;
+    }
+    *ms = std::chrono::duration<float, std::milli>(stopTime - startTime).count();
+    return hipSuccess;
+}
+
+hipError_t
+hipStreamBeginCapture(hipStream_t stream, hipStreamCaptureMode /* mode */)
+{
+    if(stream == nullptr)
+    {
+        // As with the real runtime, the legacy null stream can't be captured.
+        return hipErrorStreamCaptureUnsupported;
+    }
+    std::lock_guard<std::mutex> lock(stream->mtx);
+    if(stream->capture != nullptr)
+    {
+        return hipErrorStreamCaptureInvalidated;
+    }
+    stream->capture = new ihipGraph;
+    return hipSuccess;
+}
+
+hipError_t
+hipStreamIsCapturing(hipStream_t stream, hipStreamCaptureStatus* status)
+{
+    if(status == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    if(stream == nullptr)
+    {
+        *status = hipStreamCaptureStatusNone;
+        return hipSuccess;
+    }
+    std::lock_guard<std::mutex> lock(stream->mtx);
+    *status = (stream->capture != nullptr) ? hipStreamCaptureStatusActive : hipStreamCaptureStatusNone;
+    return hipSuccess;
+}
+
+hipError_t
+hipStreamEndCapture(hipStream_t stream, hipGraph_t* graph)
+{
+    if((stream == nullptr) or (graph == nullptr))
+    {
+        return hipErrorInvalidValue;
+    }
+    std::lock_guard<std::mutex> lock(stream->mtx);
+    if(stream->capture == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    *graph = stream->capture;
+    stream->capture = nullptr;
+    return hipSuccess;
+}
+
+hipError_t
+hipGraphInstantiate(hipGraphExec_t* graphExec,
+                    hipGraph_t graph,
+                    hipGraphNode_t* /* errorNode */,
+                    char* /* logBuffer */,
+                    size_t /* bufferSize */)
+{
+    if((graphExec == nullptr) or (graph == nullptr))
+    {
+        return hipErrorInvalidValue;
+    }
+    *graphExec = new hipGraphExec{ graph->ops };
+    return hipSuccess;
+}
+
+hipError_t
+hipGraphLaunch(hipGraphExec_t graphExec, hipStream_t stream)
+{
+    if(graphExec == nullptr)
+    {
+        return hipErrorInvalidValue;
+    }
+    // Submit the whole graph as a single queue entry, so the
+    // host-side cost of a launch doesn't grow with the graph.
+    return HipStandIn::Enqueue(stream, [graphExec]{
+        for(auto& op : graphExec->ops)
+        {
+            op();
+        }
+    });
+}
+
+hipError_t
+hipGraphExecDestroy(hipGraphExec_t graphExec)
+{
+    // Launches that are still queued refer to the executable graph.
+    TheRuntime().SynchronizeAll();
+    delete graphExec;
+    return hipSuccess;
+}
+
+hipError_t
+hipGraphDestroy(hipGraph_t graph)
+{
+    delete graph;
+    return hipSuccess;
+}
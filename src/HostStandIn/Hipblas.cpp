@@ -0,0 +1,790 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "hipblas.h"
+#include "hip/hip_fp16.h"
+#include "StandInRuntime.h"
+
+struct hipblasStandInHandle
+{
+    hipStream_t stream = nullptr;
+    hipblasPointerMode_t pointerMode = HIPBLAS_POINTER_MODE_HOST;
+};
+
+namespace
+{
+
+// Host threads shared by all BLAS calls, so that a call doesn't
+// pay for creating threads.  The thread that runs a call (a stream's
+// worker) takes part in it, and helpers join in as they become free,
+// so calls from several streams at once share the threads.
+class WorkerPool
+{
+private:
+    struct Job
+    {
+        std::function<void(void)> body;
+        int nHelpersWanted;
+        int nHelpersStarted = 0;
+        int nHelpersDone = 0;
+    };
+
+    std::mutex mtx;
+    std::condition_variable workCv;
+    std::condition_variable doneCv;
+    std::deque<std::shared_ptr<Job>> jobs;
+    std::vector<std::thread> helpers;
+    bool stopping = false;
+
+    void Help(void)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while(true)
+        {
+            workCv.wait(lock, [this]{ return stopping or not jobs.empty(); });
+            if(stopping)
+            {
+                break;
+            }
+
+            auto job = jobs.front();
+            if(++job->nHelpersStarted == job->nHelpersWanted)
+            {
+                jobs.pop_front();
+            }
+            lock.unlock();
+
+            job->body();
+
+            lock.lock();
+            ++job->nHelpersDone;
+            doneCv.notify_all();
+        }
+    }
+
+public:
+    WorkerPool(void)
+    {
+        // One thread per core unless told otherwise,
+        // counting the thread that runs the call.
+        unsigned int nThreads = std::thread::hardware_concurrency();
+        if(const char* envThreads = std::getenv("HIP_STANDIN_THREADS"))
+        {
+            nThreads = static_cast<unsigned int>(std::strtoul(envThreads, nullptr, 10));
+        }
+        for(unsigned int t = 1; t < nThreads; ++t)
+        {
+            helpers.emplace_back(&WorkerPool::Help, this);
+        }
+    }
+
+    ~WorkerPool(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        workCv.notify_all();
+        for(auto& helper : helpers)
+        {
+            helper.join();
+        }
+    }
+
+    int GetNumThreads(void) const   { return static_cast<int>(helpers.size()) + 1; }
+
+    // Run body on this thread and on up to nHelpers helper threads,
+    // returning when all of them have finished it.  The body must
+    // share out the work itself (e.g., with an atomic counter), since
+    // it can't know how many helpers will join in.
+    void Run(std::function<void(void)> body, int nHelpers)
+    {
+        nHelpers = std::min(nHelpers, static_cast<int>(helpers.size()));
+        if(nHelpers <= 0)
+        {
+            body();
+            return;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->body = body;
+        job->nHelpersWanted = nHelpers;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            jobs.push_back(job);
+        }
+        workCv.notify_all();
+
+        body();
+
+        // Helpers that haven't started by now would find nothing
+        // left to do, so don't wait for them.
+        std::unique_lock<std::mutex> lock(mtx);
+        auto iter = std::find(jobs.begin(), jobs.end(), job);
+        if(iter != jobs.end())
+        {
+            jobs.erase(iter);
+        }
+        doneCv.wait(lock, [&job]{ return job->nHelpersDone == job->nHelpersStarted; });
+    }
+};
+
+WorkerPool&
+ThePool(void)
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+// Run body(begin, end) over [0, n) in chunks of grain, on as
+// many of the pool's threads as there are chunks.
+template<typename Func>
+void
+ParallelFor(int n, int grain, Func body)
+{
+    auto nChunks = (n + grain - 1) / grain;
+    std::atomic<int> nextChunk(0);
+    ThePool().Run([&]() {
+            for(auto chunk = nextChunk++; chunk < nChunks; chunk = nextChunk++)
+            {
+                auto begin = chunk * grain;
+                body(begin, std::min(n, begin + grain));
+            }
+        },
+        nChunks - 1);
+}
+
+// Dot product of x and y, summed in eight interleaved partial
+// sums that are added pairwise at the end, as a SIMD unit would.
+inline
+float
+Dot(const float* __restrict__ x, const float* __restrict__ y, int n)
+{
+    float sums[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    auto i = 0;
+    for( ; i + 8 <= n; i += 8)
+    {
+        for(auto l = 0; l < 8; ++l)
+        {
+            sums[l] += x[i + l] * y[i + l];
+        }
+    }
+    for( ; i < n; ++i)
+    {
+        sums[i % 8] += x[i] * y[i];
+    }
+    return ((sums[0] + sums[4]) + (sums[2] + sums[6]))
+        + ((sums[1] + sums[5]) + (sums[3] + sums[7]));
+}
+
+// The stand-in's GEMM.  It is deliberately not the host reference
+// GEMM (BlockedGemm), so that checking a result against the reference
+// compares two different summation orders, as it would on a GPU.
+// Each element of C is a dot product of a row of op(A) and a column
+// of op(B), with the rows packed once per call and the columns
+// packed a block at a time by each thread.
+template<typename InType, typename OutType>
+void
+Gemm(hipblasOperation_t transA,
+        hipblasOperation_t transB,
+        int m,
+        int n,
+        int k,
+        float alpha,
+        const InType* A,
+        int lda,
+        const InType* B,
+        int ldb,
+        float beta,
+        OutType* C,
+        int ldc)
+{
+    if((m <= 0) or (n <= 0))
+    {
+        return;
+    }
+
+    std::vector<float> rowsA(static_cast<size_t>(m) * k);
+    ParallelFor(m, 64, [&](int begin, int end) {
+        for(auto i = begin; i < end; ++i)
+        {
+            auto dst = rowsA.data() + static_cast<size_t>(i) * k;
+            for(auto p = 0; p < k; ++p)
+            {
+                dst[p] = static_cast<float>((transA != HIPBLAS_OP_N)
+                    ? A[static_cast<size_t>(i) * lda + p]
+                    : A[static_cast<size_t>(p) * lda + i]);
+            }
+        }
+    });
+
+    constexpr int nBlock = 16;
+    ParallelFor(n, nBlock, [&](int begin, int end) {
+        std::vector<float> colsB(static_cast<size_t>(k) * nBlock);
+        for(auto j = begin; j < end; ++j)
+        {
+            auto dst = colsB.data() + static_cast<size_t>(j - begin) * k;
+            for(auto p = 0; p < k; ++p)
+            {
+                dst[p] = static_cast<float>((transB != HIPBLAS_OP_N)
+                    ? B[static_cast<size_t>(p) * ldb + j]
+                    : B[static_cast<size_t>(j) * ldb + p]);
+            }
+        }
+
+        for(auto i = 0; i < m; ++i)
+        {
+            auto a = rowsA.data() + static_cast<size_t>(i) * k;
+            for(auto j = begin; j < end; ++j)
+            {
+                auto& c = C[static_cast<size_t>(j) * ldc + i];
+                auto val = alpha * Dot(a, colsB.data() + static_cast<size_t>(j - begin) * k, k);
+
+                // As in BLAS, C is not read if beta is zero.
+                if(beta != 0)
+                {
+                    val += beta * static_cast<float>(c);
+                }
+                c = static_cast<OutType>(val);
+            }
+        }
+    });
+}
+
+// Offset of element i of a vector of n elements with increment inc.
+// As in BLAS, vectors with negative increments are walked backwards.
+inline
+int64_t
+VectorOffset(int i, int n, int inc)
+{
+    return (inc > 0) ? int64_t(i) * inc : int64_t(n - 1 - i) * -inc;
+}
+
+// A scalar argument, read when the call is made in host pointer
+// mode, and when the call runs in device pointer mode.
+template<typename T>
+class Scalar
+{
+private:
+    T value;
+    const T* ptr;
+
+public:
+    Scalar(hipblasHandle_t handle, const T* _ptr)
+      : value((handle->pointerMode == HIPBLAS_POINTER_MODE_HOST) ? *_ptr : T()),
+        ptr((handle->pointerMode == HIPBLAS_POINTER_MODE_HOST) ? nullptr : _ptr)
+    { }
+
+    T Get(void) const   { return (ptr != nullptr) ? *ptr : value; }
+};
+
+hipblasStatus_t
+Submit(hipblasHandle_t handle, std::function<void(void)> op)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    return (HipStandIn::Enqueue(handle->stream, std::move(op)) == hipSuccess)
+        ? HIPBLAS_STATUS_SUCCESS
+        : HIPBLAS_STATUS_EXECUTION_FAILED;
+}
+
+bool
+IsValidGemm(hipblasOperation_t transA,
+            hipblasOperation_t transB,
+            int m,
+            int n,
+            int k,
+            int lda,
+            int ldb,
+            int ldc)
+{
+    auto rowsA = (transA == HIPBLAS_OP_N) ? m : k;
+    auto rowsB = (transB == HIPBLAS_OP_N) ? k : n;
+    return (m >= 0) and (n >= 0) and (k >= 0)
+        and (lda >= std::max(1, rowsA))
+        and (ldb >= std::max(1, rowsB))
+        and (ldc >= std::max(1, m));
+}
+
+template<typename T>
+float
+LoadScalar(const void* ptr)
+{
+    return static_cast<float>(*static_cast<const T*>(ptr));
+}
+
+} // namespace
+
+
+hipblasStatus_t
+hipblasCreate(hipblasHandle_t* handle)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+    *handle = new hipblasStandInHandle;
+    return HIPBLAS_STATUS_SUCCESS;
+}
+
+hipblasStatus_t
+hipblasDestroy(hipblasHandle_t handle)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    delete handle;
+    return HIPBLAS_STATUS_SUCCESS;
+}
+
+hipblasStatus_t
+hipblasSetStream(hipblasHandle_t handle, hipStream_t streamId)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    handle->stream = streamId;
+    return HIPBLAS_STATUS_SUCCESS;
+}
+
+hipblasStatus_t
+hipblasGetStream(hipblasHandle_t handle, hipStream_t* streamId)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    *streamId = handle->stream;
+    return HIPBLAS_STATUS_SUCCESS;
+}
+
+hipblasStatus_t
+hipblasSetPointerMode(hipblasHandle_t handle, hipblasPointerMode_t mode)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    handle->pointerMode = mode;
+    return HIPBLAS_STATUS_SUCCESS;
+}
+
+hipblasStatus_t
+hipblasGetPointerMode(hipblasHandle_t handle, hipblasPointerMode_t* mode)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    *mode = handle->pointerMode;
+    return HIPBLAS_STATUS_SUCCESS;
+}
+
+hipblasStatus_t
+hipblasSgemm(hipblasHandle_t handle,
+                hipblasOperation_t transA,
+                hipblasOperation_t transB,
+                int m,
+                int n,
+                int k,
+                const float* alpha,
+                const float* A,
+                int lda,
+                const float* B,
+                int ldb,
+                const float* beta,
+                float* C,
+                int ldc)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if(not IsValidGemm(transA, transB, m, n, k, lda, ldb, ldc))
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+
+    Scalar<float> a(handle, alpha);
+    Scalar<float> b(handle, beta);
+    return Submit(handle, [=]{
+        Gemm(transA, transB, m, n, k, a.Get(), A, lda, B, ldb, b.Get(), C, ldc);
+    });
+}
+
+hipblasStatus_t
+hipblasSgemmBatched(hipblasHandle_t handle,
+                    hipblasOperation_t transA,
+                    hipblasOperation_t transB,
+                    int m,
+                    int n,
+                    int k,
+                    const float* alpha,
+                    const float* const A[],
+                    int lda,
+                    const float* const B[],
+                    int ldb,
+                    const float* beta,
+                    float* const C[],
+                    int ldc,
+                    int batchCount)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if( not IsValidGemm(transA, transB, m, n, k, lda, ldb, ldc) or (batchCount < 0) )
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+
+    // The pointer arrays are in "device" memory, so like the
+    // matrices they are read when the call runs.
+    Scalar<float> a(handle, alpha);
+    Scalar<float> b(handle, beta);
+    return Submit(handle, [=]{
+        for(auto i = 0; i < batchCount; ++i)
+        {
+            Gemm(transA, transB, m, n, k, a.Get(), A[i], lda, B[i], ldb, b.Get(), C[i], ldc);
+        }
+    });
+}
+
+hipblasStatus_t
+hipblasSgemmStridedBatched(hipblasHandle_t handle,
+                            hipblasOperation_t transA,
+                            hipblasOperation_t transB,
+                            int m,
+                            int n,
+                            int k,
+                            const float* alpha,
+                            const float* A,
+                            int lda,
+                            hipblasStride strideA,
+                            const float* B,
+                            int ldb,
+                            hipblasStride strideB,
+                            const float* beta,
+                            float* C,
+                            int ldc,
+                            hipblasStride strideC,
+                            int batchCount)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if( not IsValidGemm(transA, transB, m, n, k, lda, ldb, ldc) or (batchCount < 0) )
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+
+    Scalar<float> a(handle, alpha);
+    Scalar<float> b(handle, beta);
+    return Submit(handle, [=]{
+        for(auto i = 0; i < batchCount; ++i)
+        {
+            Gemm(transA,
+                    transB,
+                    m,
+                    n,
+                    k,
+                    a.Get(),
+                    A + i * strideA,
+                    lda,
+                    B + i * strideB,
+                    ldb,
+                    b.Get(),
+                    C + i * strideC,
+                    ldc);
+        }
+    });
+}
+
+hipblasStatus_t
+hipblasGemmEx(hipblasHandle_t handle,
+                hipblasOperation_t transA,
+                hipblasOperation_t transB,
+                int m,
+                int n,
+                int k,
+                const void* alpha,
+                const void* A,
+                hipblasDatatype_t aType,
+                int lda,
+                const void* B,
+                hipblasDatatype_t bType,
+                int ldb,
+                const void* beta,
+                void* C,
+                hipblasDatatype_t cType,
+                int ldc,
+                hipblasDatatype_t computeType,
+                hipblasGemmAlgo_t /* algo */)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if(not IsValidGemm(transA, transB, m, n, k, lda, ldb, ldc))
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+    if( (aType != bType) or (handle->pointerMode != HIPBLAS_POINTER_MODE_HOST) )
+    {
+        return HIPBLAS_STATUS_NOT_SUPPORTED;
+    }
+
+    // alpha and beta are of the compute type; we compute in float either way.
+    float alphaVal = 0;
+    float betaVal = 0;
+    if(computeType == HIPBLAS_R_16F)
+    {
+        alphaVal = LoadScalar<__half>(alpha);
+        betaVal = LoadScalar<__half>(beta);
+    }
+    else if(computeType == HIPBLAS_R_32F)
+    {
+        alphaVal = LoadScalar<float>(alpha);
+        betaVal = LoadScalar<float>(beta);
+    }
+    else
+    {
+        return HIPBLAS_STATUS_NOT_SUPPORTED;
+    }
+
+    if( (aType == HIPBLAS_R_32F) and (cType == HIPBLAS_R_32F) )
+    {
+        return Submit(handle, [=]{
+            Gemm(transA,
+                    transB,
+                    m,
+                    n,
+                    k,
+                    alphaVal,
+                    static_cast<const float*>(A),
+                    lda,
+                    static_cast<const float*>(B),
+                    ldb,
+                    betaVal,
+                    static_cast<float*>(C),
+                    ldc);
+        });
+    }
+    if( (aType == HIPBLAS_R_16F) and (cType == HIPBLAS_R_32F) )
+    {
+        return Submit(handle, [=]{
+            Gemm(transA,
+                    transB,
+                    m,
+                    n,
+                    k,
+                    alphaVal,
+                    static_cast<const __half*>(A),
+                    lda,
+                    static_cast<const __half*>(B),
+                    ldb,
+                    betaVal,
+                    static_cast<float*>(C),
+                    ldc);
+        });
+    }
+    if( (aType == HIPBLAS_R_16F) and (cType == HIPBLAS_R_16F) )
+    {
+        return Submit(handle, [=]{
+            Gemm(transA,
+                    transB,
+                    m,
+                    n,
+                    k,
+                    alphaVal,
+                    static_cast<const __half*>(A),
+                    lda,
+                    static_cast<const __half*>(B),
+                    ldb,
+                    betaVal,
+                    static_cast<__half*>(C),
+                    ldc);
+        });
+    }
+    return HIPBLAS_STATUS_NOT_SUPPORTED;
+}
+
+hipblasStatus_t
+hipblasSaxpy(hipblasHandle_t handle,
+                int n,
+                const float* alpha,
+                const float* x,
+                int incx,
+                float* y,
+                int incy)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if( (n < 0) or (incx == 0) or (incy == 0) )
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+
+    Scalar<float> a(handle, alpha);
+    return Submit(handle, [=]{
+        auto alphaVal = a.Get();
+        ParallelFor(n, 1 << 16, [=](int begin, int end) {
+            if( (incx == 1) and (incy == 1) )
+            {
+                for(auto i = begin; i < end; ++i)
+                {
+                    y[i] += alphaVal * x[i];
+                }
+                return;
+            }
+            for(auto i = begin; i < end; ++i)
+            {
+                y[VectorOffset(i, n, incy)] += alphaVal * x[VectorOffset(i, n, incx)];
+            }
+        });
+    });
+}
+
+hipblasStatus_t
+hipblasSdot(hipblasHandle_t handle,
+            int n,
+            const float* x,
+            int incx,
+            const float* y,
+            int incy,
+            float* result)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if( (n < 0) or (incx == 0) or (incy == 0) or (result == nullptr) )
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+
+    auto status = Submit(handle, [=]{
+        // Chunks are summed in double, and their sums
+        // combined in order, so the result is reproducible.
+        constexpr int grain = 1 << 16;
+        std::vector<double> partials((n + grain - 1) / grain);
+        ParallelFor(n, grain, [&](int begin, int end) {
+            double sum = 0;
+            for(auto i = begin; i < end; ++i)
+            {
+                sum += static_cast<double>(x[VectorOffset(i, n, incx)]) * y[VectorOffset(i, n, incy)];
+            }
+            partials[begin / grain] = sum;
+        });
+        double sum = 0;
+        for(auto partial : partials)
+        {
+            sum += partial;
+        }
+        *result = static_cast<float>(sum);
+    });
+
+    // In host pointer mode, the result must be there when we return.
+    if( (status == HIPBLAS_STATUS_SUCCESS) and (handle->pointerMode == HIPBLAS_POINTER_MODE_HOST) )
+    {
+        if(hipStreamSynchronize(handle->stream) != hipSuccess)
+        {
+            status = HIPBLAS_STATUS_EXECUTION_FAILED;
+        }
+    }
+    return status;
+}
+
+hipblasStatus_t
+hipblasSgemv(hipblasHandle_t handle,
+                hipblasOperation_t trans,
+                int m,
+                int n,
+                const float* alpha,
+                const float* A,
+                int lda,
+                const float* x,
+                int incx,
+                const float* beta,
+                float* y,
+                int incy)
+{
+    if(handle == nullptr)
+    {
+        return HIPBLAS_STATUS_HANDLE_IS_NULLPTR;
+    }
+    if( (m < 0) or (n < 0) or (lda < std::max(1, m)) or (incx == 0) or (incy == 0) )
+    {
+        return HIPBLAS_STATUS_INVALID_VALUE;
+    }
+
+    Scalar<float> a(handle, alpha);
+    Scalar<float> b(handle, beta);
+    return Submit(handle, [=]{
+        auto alphaVal = a.Get();
+        auto betaVal = b.Get();
+        auto lenX = (trans == HIPBLAS_OP_N) ? n : m;
+        auto lenY = (trans == HIPBLAS_OP_N) ? m : n;
+
+        // As in BLAS, y is not read if beta is zero.
+        auto update = [=](int i, float sum) {
+            auto& yi = y[VectorOffset(i, lenY, incy)];
+            yi = alphaVal * sum + ((betaVal != 0) ? betaVal * yi : 0.0f);
+        };
+
+        if(trans == HIPBLAS_OP_N)
+        {
+            // Each thread sweeps all of A's columns for a block of rows,
+            // reading the columns with unit stride.
+            constexpr int rowBlock = 256;
+            ParallelFor(m, rowBlock, [=](int begin, int end) {
+                float acc[rowBlock] = { };
+                for(auto j = 0; j < n; ++j)
+                {
+                    auto xj = x[VectorOffset(j, lenX, incx)];
+                    auto col = &A[int64_t(j) * lda];
+                    for(auto i = begin; i < end; ++i)
+                    {
+                        acc[i - begin] += col[i] * xj;
+                    }
+                }
+                for(auto i = begin; i < end; ++i)
+                {
+                    update(i, acc[i - begin]);
+                }
+            });
+        }
+        else
+        {
+            // Each element of y is the dot product of a column of A with x.
+            ParallelFor(n, 16, [=](int begin, int end) {
+                for(auto j = begin; j < end; ++j)
+                {
+                    auto col = &A[int64_t(j) * lda];
+                    float sum = 0;
+                    for(auto i = 0; i < m; ++i)
+                    {
+                        sum += col[i] * x[VectorOffset(i, lenX, incx)];
+                    }
+                    update(j, sum);
+                }
+            });
+        }
+    });
+}
@@ -0,0 +1,22 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HOST_STANDIN_RUNTIME_H
+#define HOST_STANDIN_RUNTIME_H
+
+#include <functional>
+#include "hip/hip_runtime_api.h"
+
+// Interfaces shared between the stand-in HIP runtime
+// and the stand-in hipBLAS library.
+namespace HipStandIn
+{
+
+// Add an operation to the given stream's work queue, or to the
+// stream's graph if the stream is being captured.
+// The operation runs on the stream's worker thread after
+// all previously enqueued operations have completed.
+hipError_t Enqueue(hipStream_t stream, std::function<void(void)> op);
+
+} // namespace HipStandIn
+
+#endif // HOST_STANDIN_RUNTIME_H
@@ -0,0 +1,102 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HOST_STANDIN_HIP_FP16_H
+#define HOST_STANDIN_HIP_FP16_H
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 storage type.  Arithmetic is done by
+// converting to float, which is all the ExtTest programs need.
+struct __half
+{
+    uint16_t bits;
+
+    __half(void) : bits(0) { }
+
+    __half(float f) : bits(FromFloat(f)) { }
+
+    operator float(void) const  { return ToFloat(bits); }
+
+    static uint16_t FromFloat(float f)
+    {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        uint32_t sign = (x >> 16) & 0x8000u;
+        uint32_t absx = x & 0x7fffffffu;
+
+        if(absx >= 0x7f800000u)
+        {
+            // Inf or NaN.
+            return static_cast<uint16_t>(sign | 0x7c00u | ((absx > 0x7f800000u) ? 0x200u : 0u));
+        }
+        if(absx >= 0x477ff000u)
+        {
+            // Rounds to a value too large for half.
+            return static_cast<uint16_t>(sign | 0x7c00u);
+        }
+        if(absx < 0x33000001u)
+        {
+            // Rounds to zero.
+            return static_cast<uint16_t>(sign);
+        }
+
+        int32_t exp = static_cast<int32_t>(absx >> 23) - 127 + 15;
+        uint32_t mant = (absx & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 13;
+        if(exp <= 0)
+        {
+            // Subnormal half.
+            shift += static_cast<uint32_t>(1 - exp);
+            exp = 0;
+        }
+        uint32_t halfMant = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if((rem > halfway) or ((rem == halfway) and (halfMant & 1u)))
+        {
+            ++halfMant;
+        }
+        uint32_t h = (exp == 0) ? halfMant : ((static_cast<uint32_t>(exp) << 10) + (halfMant - 0x400u));
+        return static_cast<uint16_t>(sign | h);
+    }
+
+    static float ToFloat(uint16_t h)
+    {
+        uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+        uint32_t exp = (h >> 10) & 0x1fu;
+        uint32_t mant = h & 0x3ffu;
+        uint32_t x;
+        if(exp == 0x1fu)
+        {
+            x = sign | 0x7f800000u | (mant << 13);
+        }
+        else if(exp != 0)
+        {
+            x = sign | ((exp - 15 + 127) << 23) | (mant << 13);
+        }
+        else if(mant == 0)
+        {
+            x = sign;
+        }
+        else
+        {
+            // Normalize a subnormal half.
+            int32_t e = -1;
+            do
+            {
+                ++e;
+                mant <<= 1;
+            } while((mant & 0x400u) == 0);
+            x = sign | (static_cast<uint32_t>(127 - 15 - e) << 23) | ((mant & 0x3ffu) << 13);
+        }
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+};
+
+inline float __half2float(__half h)  { return static_cast<float>(h); }
+inline __half __float2half(float f)  { return __half(f); }
+
+#endif // HOST_STANDIN_HIP_FP16_H
@@ -0,0 +1,10 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HOST_STANDIN_HIP_RUNTIME_H
+#define HOST_STANDIN_HIP_RUNTIME_H
+
+// The stand-in has no kernel language support, so the full
+// runtime header is just the runtime API.
+#include "hip/hip_runtime_api.h"
+
+#endif // HOST_STANDIN_HIP_RUNTIME_H
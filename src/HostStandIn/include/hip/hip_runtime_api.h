@@ -0,0 +1,161 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HOST_STANDIN_HIP_RUNTIME_API_H
+#define HOST_STANDIN_HIP_RUNTIME_API_H
+
+// A host-only stand-in for the subset of the HIP runtime API
+// used by the ExtTest programs.  "Device" memory is ordinary host
+// memory, and each stream is a worker thread draining a queue of
+// operations, so the asynchronous behavior of the programs
+// (overlap, events, synchronization) is preserved.
+
+#include <cstddef>
+#include <cstdint>
+
+#define HIP_STANDIN 1
+
+typedef enum hipError_t
+{
+    hipSuccess = 0,
+    hipErrorInvalidValue = 1,
+    hipErrorOutOfMemory = 2,
+    hipErrorNotInitialized = 3,
+    hipErrorInvalidDevice = 101,
+    hipErrorInvalidResourceHandle = 400,
+    hipErrorNotReady = 600,
+    hipErrorNotSupported = 801,
+    hipErrorStreamCaptureUnsupported = 900,
+    hipErrorStreamCaptureInvalidated = 901,
+    hipErrorUnknown = 999
+} hipError_t;
+
+typedef enum hipMemcpyKind
+{
+    hipMemcpyHostToHost = 0,
+    hipMemcpyHostToDevice = 1,
+    hipMemcpyDeviceToHost = 2,
+    hipMemcpyDeviceToDevice = 3,
+    hipMemcpyDefault = 4
+} hipMemcpyKind;
+
+typedef enum hipStreamCaptureMode
+{
+    hipStreamCaptureModeGlobal = 0,
+    hipStreamCaptureModeThreadLocal = 1,
+    hipStreamCaptureModeRelaxed = 2
+} hipStreamCaptureMode;
+
+typedef enum hipStreamCaptureStatus
+{
+    hipStreamCaptureStatusNone = 0,
+    hipStreamCaptureStatusActive = 1,
+    hipStreamCaptureStatusInvalidated = 2
+} hipStreamCaptureStatus;
+
+typedef struct ihipStream_t* hipStream_t;
+typedef struct ihipEvent_t* hipEvent_t;
+typedef struct ihipGraph* hipGraph_t;
+typedef struct hipGraphExec* hipGraphExec_t;
+typedef struct hipGraphNode* hipGraphNode_t;
+
+// The properties of a device we report.
+typedef struct hipDeviceProp_t
+{
+    char name[256];
+    size_t totalGlobalMem;
+    int multiProcessorCount;
+} hipDeviceProp_t;
+
+#define hipHostMallocDefault 0x0
+#define hipEventDefault 0x0
+#define hipMemAttachGlobal 0x1
+
+// The device id that hipMemPrefetchAsync takes for the host.
+#define hipCpuDeviceId (-1)
+
+hipError_t hipInit(unsigned int flags);
+hipError_t hipGetDeviceCount(int* count);
+hipError_t hipGetDevice(int* deviceId);
+hipError_t hipSetDevice(int deviceId);
+hipError_t hipDeviceSynchronize(void);
+hipError_t hipRuntimeGetVersion(int* runtimeVersion);
+hipError_t hipGetDeviceProperties(hipDeviceProp_t* prop, int deviceId);
+hipError_t hipMemGetInfo(size_t* free, size_t* total);
+const char* hipGetErrorString(hipError_t error);
+hipError_t hipGetLastError(void);
+
+hipError_t hipMalloc(void** ptr, size_t size);
+hipError_t hipFree(void* ptr);
+hipError_t hipHostMalloc(void** ptr, size_t size, unsigned int flags = hipHostMallocDefault);
+hipError_t hipHostFree(void* ptr);
+
+// Managed memory is host memory, so prefetches only order
+// themselves on the stream.  It is freed with hipFree.
+hipError_t hipMallocManaged(void** ptr, size_t size, unsigned int flags = hipMemAttachGlobal);
+hipError_t hipMemPrefetchAsync(const void* ptr, size_t count, int device, hipStream_t stream = nullptr);
+
+hipError_t hipMemset(void* dst, int value, size_t sizeBytes);
+hipError_t hipMemsetAsync(void* dst, int value, size_t sizeBytes, hipStream_t stream = nullptr);
+hipError_t hipMemcpy(void* dst, const void* src, size_t sizeBytes, hipMemcpyKind kind);
+hipError_t hipMemcpyAsync(void* dst,
+                            const void* src,
+                            size_t sizeBytes,
+                            hipMemcpyKind kind,
+                            hipStream_t stream = nullptr);
+hipError_t hipMemcpy2D(void* dst,
+                        size_t dpitch,
+                        const void* src,
+                        size_t spitch,
+                        size_t width,
+                        size_t height,
+                        hipMemcpyKind kind);
+hipError_t hipMemcpy2DAsync(void* dst,
+                            size_t dpitch,
+                            const void* src,
+                            size_t spitch,
+                            size_t width,
+                            size_t height,
+                            hipMemcpyKind kind,
+                            hipStream_t stream = nullptr);
+
+hipError_t hipStreamCreate(hipStream_t* stream);
+hipError_t hipStreamDestroy(hipStream_t stream);
+hipError_t hipStreamSynchronize(hipStream_t stream);
+hipError_t hipStreamQuery(hipStream_t stream);
+hipError_t hipStreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int flags);
+
+hipError_t hipEventCreate(hipEvent_t* event);
+hipError_t hipEventDestroy(hipEvent_t event);
+hipError_t hipEventRecord(hipEvent_t event, hipStream_t stream = nullptr);
+hipError_t hipEventSynchronize(hipEvent_t event);
+hipError_t hipEventQuery(hipEvent_t event);
+hipError_t hipEventElapsedTime(float* ms, hipEvent_t start, hipEvent_t stop);
+
+hipError_t hipStreamBeginCapture(hipStream_t stream, hipStreamCaptureMode mode);
+hipError_t hipStreamIsCapturing(hipStream_t stream, hipStreamCaptureStatus* status);
+hipError_t hipStreamEndCapture(hipStream_t stream, hipGraph_t* graph);
+hipError_t hipGraphInstantiate(hipGraphExec_t* graphExec,
+                                hipGraph_t graph,
+                                hipGraphNode_t* errorNode,
+                                char* logBuffer,
+                                size_t bufferSize);
+hipError_t hipGraphLaunch(hipGraphExec_t graphExec, hipStream_t stream);
+hipError_t hipGraphExecDestroy(hipGraphExec_t graphExec);
+hipError_t hipGraphDestroy(hipGraph_t graph);
+
+// Typed allocation wrappers, as provided by the real HIP headers.
+template<typename T>
+inline hipError_t
+hipMalloc(T** ptr, size_t size)
+{
+    return hipMalloc(reinterpret_cast<void**>(ptr), size);
+}
+
+template<typename T>
+inline hipError_t
+hipHostMalloc(T** ptr, size_t size, unsigned int flags = hipHostMallocDefault)
+{
+    return hipHostMalloc(reinterpret_cast<void**>(ptr), size, flags);
+}
+
+#endif // HOST_STANDIN_HIP_RUNTIME_API_H
@@ -0,0 +1,169 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+#ifndef HOST_STANDIN_HIPBLAS_H
+#define HOST_STANDIN_HIPBLAS_H
+
+// A host-only stand-in for the subset of hipBLAS used by
+// the ExtTest programs.  Calls are enqueued on the handle's
+// stand-in stream and computed with a blocked, multithreaded
+// CPU kernel.
+
+#include <cstdint>
+#include "hip/hip_runtime_api.h"
+
+#define hipblasVersionMajor 0
+#define hipblasVersionMinor 1
+#define hipblasVersionPatch 0
+
+typedef struct hipblasStandInHandle* hipblasHandle_t;
+typedef int64_t hipblasStride;
+
+typedef enum
+{
+    HIPBLAS_STATUS_SUCCESS = 0,
+    HIPBLAS_STATUS_NOT_INITIALIZED = 1,
+    HIPBLAS_STATUS_ALLOC_FAILED = 2,
+    HIPBLAS_STATUS_INVALID_VALUE = 3,
+    HIPBLAS_STATUS_MAPPING_ERROR = 4,
+    HIPBLAS_STATUS_EXECUTION_FAILED = 5,
+    HIPBLAS_STATUS_INTERNAL_ERROR = 6,
+    HIPBLAS_STATUS_NOT_SUPPORTED = 7,
+    HIPBLAS_STATUS_ARCH_MISMATCH = 8,
+    HIPBLAS_STATUS_HANDLE_IS_NULLPTR = 9,
+    HIPBLAS_STATUS_INVALID_ENUM = 10,
+    HIPBLAS_STATUS_UNKNOWN = 11
+} hipblasStatus_t;
+
+typedef enum
+{
+    HIPBLAS_OP_N = 111,
+    HIPBLAS_OP_T = 112,
+    HIPBLAS_OP_C = 113
+} hipblasOperation_t;
+
+typedef enum
+{
+    HIPBLAS_POINTER_MODE_HOST = 0,
+    HIPBLAS_POINTER_MODE_DEVICE = 1
+} hipblasPointerMode_t;
+
+typedef enum
+{
+    HIPBLAS_R_16F = 150,
+    HIPBLAS_R_32F = 151,
+    HIPBLAS_R_64F = 152
+} hipblasDatatype_t;
+
+typedef enum
+{
+    HIPBLAS_GEMM_DEFAULT = 160
+} hipblasGemmAlgo_t;
+
+hipblasStatus_t hipblasCreate(hipblasHandle_t* handle);
+hipblasStatus_t hipblasDestroy(hipblasHandle_t handle);
+hipblasStatus_t hipblasSetStream(hipblasHandle_t handle, hipStream_t streamId);
+hipblasStatus_t hipblasGetStream(hipblasHandle_t handle, hipStream_t* streamId);
+hipblasStatus_t hipblasSetPointerMode(hipblasHandle_t handle, hipblasPointerMode_t mode);
+hipblasStatus_t hipblasGetPointerMode(hipblasHandle_t handle, hipblasPointerMode_t* mode);
+
+hipblasStatus_t hipblasSaxpy(hipblasHandle_t handle,
+                                int n,
+                                const float* alpha,
+                                const float* x,
+                                int incx,
+                                float* y,
+                                int incy);
+
+// In host pointer mode, this waits for the result.
+hipblasStatus_t hipblasSdot(hipblasHandle_t handle,
+                            int n,
+                            const float* x,
+                            int incx,
+                            const float* y,
+                            int incy,
+                            float* result);
+
+hipblasStatus_t hipblasSgemv(hipblasHandle_t handle,
+                                hipblasOperation_t trans,
+                                int m,
+                                int n,
+                                const float* alpha,
+                                const float* A,
+                                int lda,
+                                const float* x,
+                                int incx,
+                                const float* beta,
+                                float* y,
+                                int incy);
+
+hipblasStatus_t hipblasSgemm(hipblasHandle_t handle,
+                                hipblasOperation_t transA,
+                                hipblasOperation_t transB,
+                                int m,
+                                int n,
+                                int k,
+                                const float* alpha,
+                                const float* A,
+                                int lda,
+                                const float* B,
+                                int ldb,
+                                const float* beta,
+                                float* C,
+                                int ldc);
+
+hipblasStatus_t hipblasSgemmBatched(hipblasHandle_t handle,
+                                    hipblasOperation_t transA,
+                                    hipblasOperation_t transB,
+                                    int m,
+                                    int n,
+                                    int k,
+                                    const float* alpha,
+                                    const float* const A[],
+                                    int lda,
+                                    const float* const B[],
+                                    int ldb,
+                                    const float* beta,
+                                    float* const C[],
+                                    int ldc,
+                                    int batchCount);
+
+hipblasStatus_t hipblasSgemmStridedBatched(hipblasHandle_t handle,
+                                            hipblasOperation_t transA,
+                                            hipblasOperation_t transB,
+                                            int m,
+                                            int n,
+                                            int k,
+                                            const float* alpha,
+                                            const float* A,
+                                            int lda,
+                                            hipblasStride strideA,
+                                            const float* B,
+                                            int ldb,
+                                            hipblasStride strideB,
+                                            const float* beta,
+                                            float* C,
+                                            int ldc,
+                                            hipblasStride strideC,
+                                            int batchCount);
+
+hipblasStatus_t hipblasGemmEx(hipblasHandle_t handle,
+                                hipblasOperation_t transA,
+                                hipblasOperation_t transB,
+                                int m,
+                                int n,
+                                int k,
+                                const void* alpha,
+                                const void* A,
+                                hipblasDatatype_t aType,
+                                int lda,
+                                const void* B,
+                                hipblasDatatype_t bType,
+                                int ldb,
+                                const void* beta,
+                                void* C,
+                                hipblasDatatype_t cType,
+                                int ldc,
+                                hipblasDatatype_t computeType,
+                                hipblasGemmAlgo_t algo);
+
+#endif // HOST_STANDIN_HIPBLAS_H
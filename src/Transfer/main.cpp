@@ -0,0 +1,214 @@
+// Copyright 2021-2023 UT-Battelle
+// See LICENSE.txt in the root of the source distribution for license info.
+//
+// Measure host/device transfer bandwidth through Matrix's chunked
+// copies, for sizes up to and beyond 4 GiB, and check that the
+// data survives the round trip.
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "boost/program_options.hpp"
+#include "HipStream.h"
+#include "HostTimer.h"
+#include "Matrix.h"
+#include "SizeList.h"
+#include "Transfer.h"
+namespace bpo = boost::program_options;
+
+// Number of floats in one Matrix column: 1 MiB.
+constexpr int nRowsPerMiB = (1 << 20) / sizeof(float);
+
+std::tuple<bool, int, std::vector<int>, std::vector<size_t>, std::vector<int>, int>
+ParseCommandLine(int argc, char* argv[])
+{
+    int ret = 0;
+    bool shouldRun = true;
+
+    bpo::options_description desc("Host/device transfer bandwidth.\nSupported options");
+    desc.add_options()
+        ("help,h", "show this help message")
+        ("sizes-mib,s", bpo::value<std::string>()->default_value("1:4096:x4,4608"), "Transfer sizes in MiB (value, list, or range)")
+        ("chunk-mib,c", bpo::value<std::string>()->default_value("0,64,256"), "Chunk sizes in MiB (0 for no split)")
+        ("streams", bpo::value<std::string>()->default_value("1,2"), "Numbers of streams to spread chunks over")
+        ("iters,i", bpo::value<int>()->default_value(3), "Number of timed round trips (best is reported)")
+    ;
+
+    bpo::variables_map opts;
+    bpo::store(bpo::parse_command_line(argc, argv, desc), opts);
+    bpo::notify(opts);
+
+    if(opts.count("help") > 0)
+    {
+        std::cout << desc << std::endl;
+        shouldRun = false;
+    }
+
+    auto sizes = ParseSizeList<int>(opts["sizes-mib"].as<std::string>());
+    auto chunks = ParseSizeList<size_t>(opts["chunk-mib"].as<std::string>());
+    auto streams = ParseSizeList<int>(opts["streams"].as<std::string>());
+    auto nIters = opts["iters"].as<int>();
+
+    auto isPositive = [](int val){ return val > 0; };
+    if( not std::all_of(sizes.begin(), sizes.end(), isPositive)
+        or not std::all_of(streams.begin(), streams.end(), isPositive)
+        or (nIters <= 0) )
+    {
+        std::cerr << "sizes, streams, and iters must each be >=1" << std::endl;
+        shouldRun = false;
+        ret = 1;
+    }
+
+    return std::make_tuple(shouldRun, ret, sizes, chunks, streams, nIters);
+}
+
+// A value that identifies an element's position, so a
+// misplaced chunk doesn't go unnoticed.
+inline
+float
+PatternValue(size_t i)
+{
+    return static_cast<float>(i % 16777213);
+}
+
+int
+main(int argc, char* argv[])
+{
+    int ret = 0;
+
+    try
+    {
+        bool shouldRun = true;
+        std::vector<int> sizesMiB;
+        std::vector<size_t> chunksMiB;
+        std::vector<int> streamCounts;
+        int nIters = 0;
+
+        std::tie(shouldRun,
+                    ret,
+                    sizesMiB,
+                    chunksMiB,
+                    streamCounts,
+                    nIters) = ParseCommandLine(argc, argv);
+
+        if(shouldRun)
+        {
+            // Each size needs its own buffers, allocated once, so caching
+            // would only keep every earlier size's buffers alive.
+            SetMemoryPoolsEnabled(false);
+
+            // Enough streams for the largest requested count.
+            std::vector<std::unique_ptr<HipStream>> allStreams;
+            auto maxStreams = *std::max_element(streamCounts.begin(), streamCounts.end());
+            for(auto i = 0; i < maxStreams; ++i)
+            {
+                allStreams.emplace_back(std::make_unique<HipStream>());
+            }
+            auto synchronizeAll = [&allStreams]() {
+                for(auto& s : allStreams)
+                {
+                    s->Synchronize();
+                }
+            };
+
+            std::cout << "size_mib,chunk_mib,streams,h2d_ms,h2d_gbps,d2h_ms,d2h_gbps,status" << std::endl;
+            for(auto sizeMiB : sizesMiB)
+            {
+                // One column per MiB keeps each dimension well within
+                // an int even when the total size is many GiB.
+                Matrix<float> m(nRowsPerMiB, sizeMiB);
+
+                // Matrix storage is allocated on first use, so
+                // allocate both sides now, outside the timed copies.
+                auto hostData = m.GetHostData();
+                m.GetDeviceData();
+                auto nItems = m.GetNumItems();
+                auto nBytes = m.GetSize();
+
+                for(auto chunkMiB : chunksMiB)
+                {
+                    TransferChunkBytes() = chunkMiB << 20;
+                    for(auto nStreams : streamCounts)
+                    {
+                        std::vector<const HipStream*> streams;
+                        for(auto i = 0; i < nStreams; ++i)
+                        {
+                            streams.push_back(allStreams[i].get());
+                        }
+
+                        double bestH2DMs = std::numeric_limits<double>::max();
+                        double bestD2HMs = std::numeric_limits<double>::max();
+                        for(auto iter = 0; iter < nIters; ++iter)
+                        {
+                            for(size_t i = 0; i < nItems; ++i)
+                            {
+                                hostData[i] = PatternValue(i);
+                            }
+
+                            HostTimer timer;
+                            m.CopyHostToDeviceAsync(streams);
+                            synchronizeAll();
+                            bestH2DMs = std::min(bestH2DMs, timer.ElapsedMs());
+
+                            // Make sure what we check next came from the device.
+                            std::fill(hostData, hostData + nItems, -1.0f);
+
+                            timer.Restart();
+                            m.CopyDeviceToHostAsync(streams);
+                            synchronizeAll();
+                            bestD2HMs = std::min(bestD2HMs, timer.ElapsedMs());
+                        }
+
+                        size_t nMismatches = 0;
+                        for(size_t i = 0; i < nItems; ++i)
+                        {
+                            if(hostData[i] != PatternValue(i))
+                            {
+                                ++nMismatches;
+                            }
+                        }
+
+                        auto toGBps = [nBytes](double ms){ return nBytes / (ms * 1.0e6); };
+                        std::cout << sizeMiB
+                            << ',' << chunkMiB
+                            << ',' << nStreams
+                            << ',' << bestH2DMs
+                            << ',' << toGBps(bestH2DMs)
+                            << ',' << bestD2HMs
+                            << ',' << toGBps(bestD2HMs)
+                            << ',' << ((nMismatches == 0) ? "PASS" : "FAIL")
+                            << std::endl;
+                        if(nMismatches != 0)
+                        {
+                            ret = 1;
+                        }
+                    }
+                }
+            }
+
+            ReleaseMemoryPools();
+        }
+    }
+    catch(const HipException& e)
+    {
+        std::cerr << "HIP Exception: " << e.GetCode() << ": " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        ret = 1;
+    }
+    catch(...)
+    {
+        std::cerr << "unrecognized exception caught" << std::endl;
+        ret = 1;
+    }
+
+    return ret;
+}